@@ -0,0 +1,127 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+//compares running many instances of one program on separate VMs with running them as lanes of a BatchMachine
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <print>
+#include <ranges>
+#include <span>
+#include <vector>
+#include "chip8/batchMachine.hpp"
+
+namespace
+{
+    //arithmetic on data seeded per lane by Cxnn, every lane takes the same path
+    constexpr std::array<std::uint8_t, 26> UNIFORM_PROGRAM = 
+    {
+        0xC0, 0xFF, //V0 = random
+        0xC1, 0xFF, //V1 = random
+        0xC2, 0xFF, //V2 = random
+        0x80, 0x14, //V0 += V1
+        0x81, 0x25, //V1 -= V2
+        0x82, 0x0E, //V2 <<= 1
+        0x83, 0x03, //V3 ^= V0
+        0x83, 0x06, //V3 >>= 1
+        0x84, 0x31, //V4 |= V3
+        0x85, 0x42, //V5 &= V4
+        0x72, 0x07, //V2 += 7
+        0x86, 0x57, //V6 = V5 - V6
+        0x12, 0x06  //jump to V0 += V1
+    };
+
+    //the skips depend on the data, so the lanes spread over the loop
+    constexpr std::array<std::uint8_t, 28> DIVERGENT_PROGRAM = 
+    {
+        0x60, 0x00, //V0 = 0
+        0x61, 0x01, //V1 = 1
+        0xC2, 0xFF, //V2 = random
+        0x80, 0x24, //V0 += V2
+        0x81, 0x05, //V1 -= V0
+        0x83, 0x10, //V3 = V1
+        0x83, 0x0E, //V3 <<= 1
+        0x84, 0x32, //V4 &= V3
+        0x33, 0x00, //skip if V3 == 0
+        0x75, 0x01, //V5 += 1
+        0x86, 0x53, //V6 ^= V5
+        0x40, 0x80, //skip if V0 != 0x80
+        0xC2, 0xFF, //V2 = random
+        0x12, 0x06  //jump to V0 += V2
+    };
+
+    void Measure(const char* name, std::span<const std::uint8_t> programBytes, std::size_t laneCount, std::size_t instructionCount)
+    {
+        std::vector<std::byte> program;
+        std::ranges::transform(programBytes, std::back_inserter(program), [](const auto n) {return std::byte {n};});
+
+        std::vector<std::vector<std::byte>> expectedRegisters(laneCount);
+        auto start = std::chrono::steady_clock::now();
+        for (const auto lane : std::views::iota(0UZ, laneCount))
+        {
+            CHIP8::VirtualMachine virtualMachine;
+            virtualMachine.LoadProgram(program);
+            virtualMachine.SetExecutionEngine(CHIP8::VirtualMachine::ExecutionEngine::Threaded);
+            virtualMachine.SetRandomSeed(static_cast<std::uint32_t>(lane));
+            virtualMachine.Execute(instructionCount);
+            std::ranges::copy(virtualMachine.GetRegisters(), std::back_inserter(expectedRegisters[lane]));
+        }
+        const std::chrono::duration<double> sequentialSeconds = std::chrono::steady_clock::now() - start;
+
+        CHIP8::BatchMachine batchMachine {program, laneCount};
+        for (const auto lane : std::views::iota(0UZ, laneCount))
+        {
+            batchMachine.SetRandomSeed(lane, static_cast<std::uint32_t>(lane));
+        }
+        start = std::chrono::steady_clock::now();
+        batchMachine.Execute(instructionCount);
+        const std::chrono::duration<double> batchSeconds = std::chrono::steady_clock::now() - start;
+
+        for (const auto lane : std::views::iota(0UZ, laneCount))
+        {
+            if (not std::ranges::equal(batchMachine.GetRegisters(lane), expectedRegisters[lane]))
+            {
+                std::println("Lane {} of the {} program does not match its VM", lane, name);
+                std::exit(EXIT_FAILURE);
+            }
+        }
+
+        const auto totalInstructions = static_cast<double>(laneCount * instructionCount);
+        std::println("{:>10} {:>16.1f} {:>11.1f} {:>8.2f}x", name, 
+            totalInstructions / sequentialSeconds.count() / 1e6, 
+            totalInstructions / batchSeconds.count() / 1e6, 
+            sequentialSeconds.count() / batchSeconds.count());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t laneCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1024;
+    const std::size_t instructionCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100'000;
+
+    std::println("{} lanes x {} instructions", laneCount, instructionCount);
+    std::println("{:>10} {:>16} {:>11} {:>9}", "program", "sequential MIPS", "batch MIPS", "speedup");
+    Measure("uniform", UNIFORM_PROGRAM, laneCount, instructionCount);
+    Measure("divergent", DIVERGENT_PROGRAM, laneCount, instructionCount);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
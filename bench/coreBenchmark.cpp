@@ -0,0 +1,433 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+//microbenchmarks of the parts of the core and headless runs of bundled programs,
+//printed as JSON so results of different commits can be compared by a script;
+//an optional argument only runs the benchmarks whose names contain it
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <format>
+#include <print>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "chip8/audioSink.hpp"
+#include "chip8/beeper.hpp"
+#include "chip8/chip8vm.hpp"
+#include "chip8/framebuffer.hpp"
+#include "chip8/instruction.hpp"
+#include "chip8/timer.hpp"
+
+namespace
+{
+    using Engine = CHIP8::VirtualMachine::ExecutionEngine;
+
+    constexpr std::uint16_t PROGRAM_START = 0x200;
+
+    //a run is repeated with twice the iterations until it takes this long, then timed a few more times
+    constexpr auto MIN_RUN_DURATION = std::chrono::milliseconds {20};
+    constexpr unsigned REPETITIONS = 5;
+    //instructions per call of Execute, large enough to hide its own overhead
+    constexpr std::size_t EXECUTE_CHUNK = 1 << 16;
+    //copies of the measured instruction in a dispatch program
+    constexpr std::size_t REPEATED_INSTRUCTIONS = 256;
+
+    constexpr std::array ENGINES 
+    {
+        std::pair {Engine::Interpreter, "interpreter"},
+        std::pair {Engine::Threaded, "threaded"},
+        std::pair {Engine::Jit, "jit"}
+    };
+
+    //programs measured as a whole, the start of a game loop each
+    struct BundledProgram
+    {
+        std::string_view name;
+        std::vector<std::uint16_t> opcodes;
+    };
+
+    const std::array<BundledProgram, 4> BUNDLED_PROGRAMS 
+    {
+        //draws hex digits while mixing a few registers
+        BundledProgram {"digits", {0xA050, 0x6000, 0x6100, 0xD015, 0x7001, 0x7102, 0x8014, 0xF029, 0x1206}},
+        //register arithmetic without branches
+        BundledProgram {"arithmetic", {0xC0FF, 0xC1FF, 0xC2FF, 0x8014, 0x8125, 0x820E, 0x8303, 0x8306, 0x8431, 0x8542, 0x7207, 0x8657, 0x1206}},
+        //counts up and draws the count as three decimal digits
+        BundledProgram {"scoreboard", {0x6300, 0x7301, 0xA800, 0xF333, 0xF265, 0x00E0, 0xF029, 0x6400, 0x6500, 0xD455, 0xF129, 0x7405, 0xD455, 0xF229, 0x7405, 0xD455, 0x1202}},
+        //calls a subroutine and branches on the carry of an addition
+        BundledProgram {"subroutines", {0x220A, 0x8104, 0x3F01, 0x1200, 0x1200, 0x7003, 0x00EE}}
+    };
+
+    struct Result
+    {
+        std::string name;
+        double value;
+        std::string_view unit;
+    };
+
+    //written by the benchmarks so the compiler cannot drop the work they measure
+    volatile std::uint64_t sink;
+
+    //nanoseconds per iteration of the fastest repetition
+    double MeasureNanoseconds(const std::function<void(std::size_t)>& body)
+    {
+        std::size_t iterations {1};
+        while (true)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            body(iterations);
+            if (std::chrono::steady_clock::now() - start >= MIN_RUN_DURATION)
+            {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        auto best = std::numeric_limits<double>::infinity();
+        for (unsigned repetition {0}; repetition < REPETITIONS; ++repetition)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            body(iterations);
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count() / iterations);
+        }
+        return best;
+    }
+
+    std::vector<std::byte> ToProgram(std::span<const std::uint16_t> opcodes)
+    {
+        std::vector<std::byte> program;
+        for (const auto opcode : opcodes)
+        {
+            program.push_back(std::byte {static_cast<std::uint8_t>(opcode >> 8)});
+            program.push_back(std::byte {static_cast<std::uint8_t>(opcode)});
+        }
+        return program;
+    }
+
+    //the prologue once, then the opcode repeated in a loop
+    std::vector<std::byte> MakeRepeatingProgram(std::initializer_list<std::uint16_t> prologue, std::uint16_t opcode)
+    {
+        std::vector<std::uint16_t> opcodes {prologue};
+        const auto loopStart = static_cast<std::uint16_t>(PROGRAM_START + opcodes.size() * 2);
+        opcodes.insert(opcodes.end(), REPEATED_INSTRUCTIONS, opcode);
+        opcodes.push_back(0x1000 | loopStart);
+        return ToProgram(opcodes);
+    }
+
+    //nanoseconds per instruction of a program run without pacing
+    double MeasureProgram(std::span<const std::byte> program, Engine engine)
+    {
+        CHIP8::VirtualMachine virtualMachine;
+        virtualMachine.LoadProgram(program);
+        virtualMachine.SetExecutionEngine(engine);
+        virtualMachine.SetRandomSeed(1);
+        return MeasureNanoseconds([&](std::size_t iterations)
+        {
+            for (std::size_t executed {0}; executed < iterations; executed += EXECUTE_CHUNK)
+            {
+                virtualMachine.Execute(std::min(EXECUTE_CHUNK, iterations - executed));
+            }
+        });
+    }
+
+    bool IsJitAvailable()
+    {
+        CHIP8::VirtualMachine virtualMachine;
+        virtualMachine.SetExecutionEngine(Engine::Jit);
+        return virtualMachine.GetExecutionEngine() == Engine::Jit;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+    const auto jitAvailable = IsJitAvailable();
+
+    std::vector<Result> results;
+    const auto run = [&](std::string name, std::string_view unit, const auto& measure)
+    {
+        if (name.contains(filter))
+        {
+            results.push_back(Result {std::move(name), measure(), unit});
+        }
+    };
+
+    run("decode/operands", "ns", []
+    {
+        return MeasureNanoseconds([](std::size_t iterations)
+        {
+            std::uint64_t sum {0};
+            for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+            {
+                const CHIP8::DecodedOpcode operands {static_cast<std::uint16_t>(iteration)};
+                sum += operands.nnn + operands.x + operands.y + operands.n + operands.nn;
+            }
+            sink = sum;
+        });
+    });
+
+    //the first run of freshly loaded code, every instruction is looked up in the instruction table once
+    run("decode/predecode", "ns", []
+    {
+        const auto program = MakeRepeatingProgram({}, 0x7A01);
+        CHIP8::VirtualMachine virtualMachine;
+        return MeasureNanoseconds([&](std::size_t iterations)
+        {
+            for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+            {
+                virtualMachine.LoadProgram(program);
+                virtualMachine.Execute(REPEATED_INSTRUCTIONS + 1);
+            }
+        }) / (REPEATED_INSTRUCTIONS + 1);
+    });
+
+    //the repeated opcode after a prologue which keeps it well defined
+    const std::array<std::pair<std::string_view, std::vector<std::byte>>, 15> dispatchPrograms 
+    {{
+        {"set_register", MakeRepeatingProgram({}, 0x6A42)},
+        {"add_immediate", MakeRepeatingProgram({}, 0x7A01)},
+        {"add_registers", MakeRepeatingProgram({}, 0x8AB4)},
+        {"shift", MakeRepeatingProgram({}, 0x8A06)},
+        {"skip_not_taken", MakeRepeatingProgram({0x6A01}, 0x3A00)},
+        {"set_index", MakeRepeatingProgram({}, 0xA800)},
+        {"add_index", MakeRepeatingProgram({}, 0xF01E)},
+        {"random", MakeRepeatingProgram({}, 0xCAFF)},
+        {"load_delay_timer", MakeRepeatingProgram({}, 0xFA07)},
+        {"draw", MakeRepeatingProgram({0xA050}, 0xD015)},
+        {"bcd", MakeRepeatingProgram({0xA800}, 0xFA33)},
+        {"store_registers", MakeRepeatingProgram({0xA800}, 0xFF55)},
+        {"load_registers", MakeRepeatingProgram({0xA800}, 0xFF65)},
+        //two jumps chasing each other, a jump to itself would be skipped as an idle loop
+        {"jump", ToProgram(std::array<std::uint16_t, 2> {0x1202, 0x1200})},
+        {"call_return", ToProgram(std::array<std::uint16_t, 3> {0x2204, 0x1200, 0x00EE})}
+    }};
+    for (const auto& [engine, engineName] : ENGINES)
+    {
+        if (engine == Engine::Jit and not jitAvailable)
+        {
+            continue;
+        }
+        for (const auto& [className, program] : dispatchPrograms)
+        {
+            run(std::format("dispatch/{}/{}", engineName, className), "ns", [&] {return MeasureProgram(program, engine);});
+        }
+    }
+
+    //the high resolution has 4 times the pixels, which should not make drawing, scrolling or publishing 4 times slower
+    constexpr std::array RESOLUTIONS 
+    {
+        std::pair {CHIP8::Framebuffer::Resolution::Low, "low"}, 
+        std::pair {CHIP8::Framebuffer::Resolution::High, "high"}
+    };
+    const std::array<std::byte, 5> sprite {std::byte {0xF0}, std::byte {0x90}, std::byte {0xF0}, std::byte {0x90}, std::byte {0xF0}};
+    std::array<std::byte, 32> bigSprite;
+    std::ranges::generate(bigSprite, [value = 0U]() mutable {return std::byte {static_cast<std::uint8_t>(value++ * 37)};});
+    for (const auto& [resolution, resolutionName] : RESOLUTIONS)
+    {
+        //coordinates sweep a little past the edges of the display
+        const auto width = resolution == CHIP8::Framebuffer::Resolution::High ? CHIP8::Framebuffer::HIGH_WIDTH : CHIP8::Framebuffer::LOW_WIDTH;
+        const auto height = resolution == CHIP8::Framebuffer::Resolution::High ? CHIP8::Framebuffer::HIGH_HEIGHT : CHIP8::Framebuffer::LOW_HEIGHT;
+        for (const auto& [edgeMode, edgeModeName] : {std::pair {CHIP8::Framebuffer::EdgeMode::Clip, "clip"}, std::pair {CHIP8::Framebuffer::EdgeMode::Wrap, "wrap"}})
+        {
+            for (const auto& [spriteWidth, spriteData] : {std::pair {8U, std::span<const std::byte> {sprite}}, std::pair {16U, std::span<const std::byte> {bigSprite}}})
+            {
+                run(std::format("sprite/{}/{}/{}", resolutionName, edgeModeName, spriteWidth == 16 ? "16x16" : "8x5"), "ns", [&]
+                {
+                    CHIP8::Framebuffer framebuffer;
+                    framebuffer.SetResolution(resolution);
+                    return MeasureNanoseconds([&](std::size_t iterations)
+                    {
+                        std::uint64_t collisions {0};
+                        for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+                        {
+                            const auto x = static_cast<unsigned>(iteration * 7 % (width + 6)), y = static_cast<unsigned>(iteration * 3 % (height + 2));
+                            collisions += framebuffer.DrawSprite(x, y, spriteData, edgeMode, spriteWidth, 1);
+                        }
+                        sink = collisions;
+                    });
+                });
+            }
+        }
+
+        //a full display, scrolled back and forth so it never empties
+        for (const auto direction : {"vertical", "horizontal"})
+        {
+            run(std::format("scroll/{}/{}", resolutionName, direction), "ns", [&]
+            {
+                CHIP8::Framebuffer framebuffer;
+                framebuffer.SetResolution(resolution);
+                for (unsigned y {0}; y < height; y += 16)
+                {
+                    for (unsigned x {0}; x < width; x += 16)
+                    {
+                        framebuffer.DrawSprite(x, y, bigSprite, CHIP8::Framebuffer::EdgeMode::Clip, 16, 0b11);
+                    }
+                }
+                const auto vertical = std::string_view {direction} == "vertical";
+                return MeasureNanoseconds([&](std::size_t iterations)
+                {
+                    for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+                    {
+                        const auto forward = iteration % 2 == 0;
+                        if (vertical and forward)
+                        {
+                            framebuffer.ScrollDown(4, 0b11);
+                        }
+                        else if (vertical)
+                        {
+                            framebuffer.ScrollUp(4, 0b11);
+                        }
+                        else if (forward)
+                        {
+                            framebuffer.ScrollRight(4, 0b11);
+                        }
+                        else
+                        {
+                            framebuffer.ScrollLeft(4, 0b11);
+                        }
+                    }
+                    sink = framebuffer.GetGeneration();
+                });
+            });
+        }
+
+        //every draw changes the display, so every Execute publishes a frame which is then fetched
+        run(std::format("frame/publish_and_fetch/{}", resolutionName), "ns", [&]
+        {
+            const auto setResolution = resolution == CHIP8::Framebuffer::Resolution::High ? std::uint16_t {0x00FF} : std::uint16_t {0x00FE};
+            const auto program = MakeRepeatingProgram({setResolution, 0xA050}, 0xD015);
+            CHIP8::VirtualMachine virtualMachine;
+            virtualMachine.LoadProgram(program);
+            virtualMachine.Execute(2);
+            return MeasureNanoseconds([&](std::size_t iterations)
+            {
+                for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+                {
+                    virtualMachine.Execute(1);
+                    sink = virtualMachine.GetDisplayMemory().GetGeneration();
+                }
+            });
+        });
+    }
+
+    run("frame/copy", "ns", []
+    {
+        CHIP8::Framebuffer source, destination;
+        return MeasureNanoseconds([&](std::size_t iterations)
+        {
+            for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+            {
+                destination = source;
+                sink = destination.GetGeneration();
+            }
+        });
+    });
+
+    run("timer/get_value", "ns", []
+    {
+        CHIP8::Timer timer;
+        CHIP8::Timer::Frame frame {0};
+        return MeasureNanoseconds([&](std::size_t iterations)
+        {
+            for (std::size_t iteration {0}; iteration < iterations; ++iteration, ++frame)
+            {
+                if (timer.GetValue(frame) == 0)
+                {
+                    timer.Set(0xFF, frame);
+                }
+            }
+            sink = timer.GetValue(frame);
+        });
+    });
+
+    //samples of one 60 Hz frame
+    constexpr std::size_t FRAME_SAMPLES = CHIP8::Beeper::DEFAULT_SAMPLE_RATE / 60;
+    run("sound/synthesize_frame", "ns", []
+    {
+        CHIP8::Beeper beeper;
+        std::vector<std::int16_t> samples(FRAME_SAMPLES);
+        return MeasureNanoseconds([&](std::size_t iterations)
+        {
+            for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+            {
+                beeper.Synthesize(true, samples);
+                sink = static_cast<std::uint64_t>(samples.back());
+            }
+        });
+    });
+
+    //a frame written by the VM thread and read back in the chunks an audio callback takes
+    run("sound/queue_frame", "ns", []
+    {
+        CHIP8::StreamingAudioSink audioSink {CHIP8::Beeper::DEFAULT_SAMPLE_RATE, 0, 2 * FRAME_SAMPLES};
+        const std::vector<std::int16_t> frame(FRAME_SAMPLES, 1);
+        //five reads per frame
+        std::array<std::int16_t, FRAME_SAMPLES / 5> chunk;
+        return MeasureNanoseconds([&](std::size_t iterations)
+        {
+            for (std::size_t iteration {0}; iteration < iterations; ++iteration)
+            {
+                audioSink.Write(frame);
+                for (std::size_t read {0}; read < FRAME_SAMPLES; read += chunk.size())
+                {
+                    audioSink.Read(chunk);
+                }
+            }
+            sink = audioSink.GetStatistics().underruns;
+        });
+    });
+
+    for (const auto& [name, opcodes] : BUNDLED_PROGRAMS)
+    {
+        for (const auto& [engine, engineName] : ENGINES)
+        {
+            if (engine == Engine::Jit and not jitAvailable)
+            {
+                continue;
+            }
+            run(std::format("program/{}/{}", name, engineName), "instructions/s", [&] 
+            {
+                return 1e9 / MeasureProgram(ToProgram(opcodes), engine);
+            });
+        }
+    }
+
+    std::println("{{");
+    std::println("  \"context\": {{\"jit\": {}}},", jitAvailable);
+    std::println("  \"benchmarks\": [");
+    for (const auto& [index, result] : results | std::views::enumerate)
+    {
+        std::println("    {{\"name\": \"{}\", \"value\": {:.6g}, \"unit\": \"{}\"}}{}", 
+            result.name, result.value, result.unit, index + 1 < std::ssize(results) ? "," : "");
+    }
+    std::println("  ]");
+    std::println("}}");
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+//measures how the throughput of VmPool scales from one worker to every hardware thread
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <print>
+#include <thread>
+#include <vector>
+#include "chip8/vmPool.hpp"
+
+namespace
+{
+    //10000 instructions per frame keep the slices long enough to measure the workers rather than the queues
+    constexpr std::uint32_t CLOCK_SPEED = 600'000;
+    constexpr std::size_t FRAME_INSTRUCTIONS = CLOCK_SPEED / CHIP8::VirtualMachine::FRAME_RATE;
+
+    //draws digits while mixing a few registers, forever
+    constexpr std::array<std::uint8_t, 18> PROGRAM = 
+    {
+        0xA0, 0x50, //I = font
+        0x60, 0x00, //V0 = 0
+        0x61, 0x00, //V1 = 0
+        0xD0, 0x15, //draw V0, V1
+        0x70, 0x01, //V0 += 1
+        0x71, 0x02, //V1 += 2
+        0x80, 0x14, //V0 += V1
+        0xF0, 0x29, //I = digit V0
+        0x12, 0x06  //jump to draw
+    };
+
+    double MeasureSeconds(unsigned workerCount, std::size_t instanceCount, std::size_t frameCount, std::size_t sliceFrames)
+    {
+        std::vector<std::byte> program;
+        std::ranges::transform(PROGRAM, std::back_inserter(program), [](const auto n) {return std::byte {n};});
+
+        CHIP8::VmPool pool {workerCount};
+        pool.SetClockSpeed(CLOCK_SPEED);
+        for (std::size_t instance {0}; instance < instanceCount; ++instance)
+        {
+            pool.Add(program, frameCount, static_cast<std::uint32_t>(instance));
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto results = pool.Run(sliceFrames);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const auto failed = std::ranges::count_if(results, [](const auto& result) {return not result.error.empty();});
+        if (failed > 0)
+        {
+            std::println("{} instances failed: {}", failed, results.front().error);
+            std::exit(EXIT_FAILURE);
+        }
+        return elapsed.count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t instanceCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2048;
+    const std::size_t frameCount = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20;
+    const std::size_t sliceFrames = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+    if (sliceFrames == 0)
+    {
+        std::println("Slice length must be greater than zero!");
+        return EXIT_FAILURE;
+    }
+    const auto hardwareThreads = std::max(std::thread::hardware_concurrency(), 1U);
+
+    std::vector<unsigned> workerCounts;
+    for (unsigned workerCount {1}; workerCount < hardwareThreads; workerCount *= 2)
+    {
+        workerCounts.push_back(workerCount);
+    }
+    workerCounts.push_back(hardwareThreads);
+
+    std::println("{} instances x {} frames of {} instructions, slices of {} frames", instanceCount, frameCount, FRAME_INSTRUCTIONS, sliceFrames);
+    std::println("{:>8} {:>10} {:>12} {:>9} {:>11}", "workers", "seconds", "MIPS", "speedup", "efficiency");
+
+    double singleWorkerSeconds {0};
+    for (const auto workerCount : workerCounts)
+    {
+        const auto seconds = MeasureSeconds(workerCount, instanceCount, frameCount, sliceFrames);
+        if (workerCount == 1)
+        {
+            singleWorkerSeconds = seconds;
+        }
+        const auto speedup = singleWorkerSeconds / seconds;
+        const auto mips = static_cast<double>(instanceCount * frameCount * FRAME_INSTRUCTIONS) / seconds / 1e6;
+        std::println("{:>8} {:>10.3f} {:>12.1f} {:>8.2f}x {:>10.0f}%", workerCount, seconds, mips, speedup, 100 * speedup / workerCount);
+    }
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+//compares the cost of drawing a frame with one sprite per lit pixel against the single texture renderer
+
+#include <chrono>
+#include <cstdlib>
+#include <print>
+#include <random>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "chip8/framebuffer.hpp"
+#include "renderer.hpp"
+
+namespace
+{
+    constexpr unsigned SCALE = 10, FRAMES = 2000, SPRITES_PER_FRAME = 4;
+
+    //snapshots of one display a game draws a few sprites into every frame
+    std::vector<CHIP8::Framebuffer> MakeFrames()
+    {
+        std::mt19937 randomEngine {8};
+        std::uniform_int_distribution<unsigned> coordinate {0, 63};
+        std::vector<std::byte> sprite(8);
+        CHIP8::Framebuffer display;
+        std::vector<CHIP8::Framebuffer> frames;
+        frames.reserve(FRAMES);
+        for (unsigned frame {0}; frame < FRAMES; ++frame)
+        {
+            for (unsigned draw {0}; draw < SPRITES_PER_FRAME; ++draw)
+            {
+                for (auto& spriteRow : sprite)
+                {
+                    spriteRow = std::byte {static_cast<unsigned char>(randomEngine())};
+                }
+                display.DrawSprite(coordinate(randomEngine), coordinate(randomEngine) / 2, sprite, CHIP8::Framebuffer::EdgeMode::Wrap);
+            }
+            frames.push_back(display);
+        }
+        return frames;
+    }
+
+    template <typename DrawFrame>
+    double MeasureFrameCost(sf::RenderTexture& target, const std::vector<CHIP8::Framebuffer>& frames, DrawFrame drawFrame)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned frame {0}; frame < FRAMES; ++frame)
+        {
+            target.clear(sf::Color::Black);
+            drawFrame(frames[frame]);
+            target.display();
+        }
+        //reading the result back waits for the GPU to finish every queued frame
+        static_cast<void>(target.getTexture().copyToImage());
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / FRAMES;
+    }
+}
+
+int main()
+{
+    sf::RenderTexture target;
+    if (not target.create(CHIP8::Framebuffer::LOW_WIDTH * SCALE, CHIP8::Framebuffer::LOW_HEIGHT * SCALE))
+    {
+        std::println("Cannot create render texture!");
+        return EXIT_FAILURE;
+    }
+
+    const auto frames = MakeFrames();
+
+    sf::Image whiteRectImage;
+    whiteRectImage.create(SCALE, SCALE, sf::Color::White);
+    sf::Texture whiteRectTexture;
+    whiteRectTexture.loadFromImage(whiteRectImage);
+
+    const auto spritePerPixel = MeasureFrameCost(target, frames, [&](const CHIP8::Framebuffer& frame)
+    {
+        for (unsigned rowIndex {0}; rowIndex < CHIP8::Framebuffer::LOW_HEIGHT; ++rowIndex)
+        {
+            for (unsigned columnIndex {0}; columnIndex < CHIP8::Framebuffer::LOW_WIDTH; ++columnIndex)
+            {
+                if (frame.GetPixel(columnIndex, rowIndex))
+                {
+                    sf::Sprite whiteRect {whiteRectTexture};
+                    whiteRect.setPosition(columnIndex * SCALE, rowIndex * SCALE);
+                    target.draw(whiteRect);
+                }
+            }
+        }
+    });
+
+    Renderer renderer {SCALE, sf::Color::White, sf::Color::Black};
+    const auto singleTexture = MeasureFrameCost(target, frames, [&](const CHIP8::Framebuffer& frame)
+    {
+        renderer.Update(frame);
+        renderer.Draw(target);
+    });
+
+    std::println("sprite per pixel: {:.1f} us/frame", spritePerPixel);
+    std::println("single texture:   {:.1f} us/frame", singleTexture);
+    std::println("speedup:          {:.1f}x", spritePerPixel / singleTexture);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
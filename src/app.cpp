@@ -17,9 +17,17 @@
 */
 
 #include <cstddef>
+#include <cctype>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <ctime>
 #include <ostream>
 #include <vector>
+#include <string>
+#include <string_view>
+#include <stdexcept>
 #include <print>
 #include <ranges>
 #include <thread>
@@ -28,19 +36,92 @@
 #include <optional>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <boost/program_options.hpp>
 #include <SFML/Graphics.hpp>
 #include "chip8/chip8vm.hpp"
+#include "chip8/gdbStub.hpp"
+#include "chip8/inputLog.hpp"
+#include "sfmlKeyboard.hpp"
+#include "sfmlAudioSink.hpp"
+#include "renderer.hpp"
 #include "app.hpp"
 
+namespace
+{
+    constexpr unsigned FRAME_RATE = 60;
+    constexpr auto PRESENT_PERIOD = std::chrono::nanoseconds {1'000'000'000 / FRAME_RATE};
+
+    //CPU time consumed by the calling thread, where the platform can tell
+    std::optional<std::chrono::nanoseconds> GetThreadCpuTime()
+    {
+#ifdef __unix__
+        timespec cpuTime;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime) == 0)
+        {
+            return std::chrono::seconds {cpuTime.tv_sec} + std::chrono::nanoseconds {cpuTime.tv_nsec};
+        }
+#endif
+        return {};
+    }
+
+    //parses colors written as RRGGBB
+    std::optional<sf::Color> ParseColor(const std::string& text)
+    {
+        if (text.size() != 6 or not std::ranges::all_of(text, [](const char c) {return std::isxdigit(static_cast<unsigned char>(c));}))
+        {
+            return {};
+        }
+        const auto rgb = std::stoul(text, nullptr, 16);
+        return sf::Color {static_cast<sf::Uint8>(rgb >> 16), static_cast<sf::Uint8>(rgb >> 8), static_cast<sf::Uint8>(rgb)};
+    }
+}
+
 Emulator::Emulator(int argc, char** argv)
+    :
+    m_sfmlKeyboard(nullptr),
+    m_sfmlAudioSink(nullptr),
+    m_headless(false),
+    m_instructionCount(0),
+    m_frameCount(0),
+    m_rewindFrameCount(0),
+    m_scale(10),
+    m_busyRender(false),
+    m_failed(false)
 {
     namespace po = boost::program_options;
 
     po::options_description desc("Arguments");
     desc.add_options()
         ("help", "Show this message")
-        ("program-file,p", po::value<std::string>()->required(), "Path to file with CHIP-8 program");
+        ("program-file,p", po::value<std::string>()->required(), "Path to file with CHIP-8 program")
+        ("engine,e", po::value<std::string>()->default_value("interpreter"), "Execution engine: interpreter, threaded or jit")
+        ("perf-map", "Write a perf map file for blocks compiled by the JIT")
+        ("clock-speed,c", po::value<std::uint32_t>()->default_value(500), "Instructions executed per second")
+        ("scale,s", po::value<unsigned>()->default_value(10), "Size of a CHIP-8 pixel in window pixels")
+        ("foreground", po::value<std::string>()->default_value("FFFFFF"), "Color of lit pixels as RRGGBB")
+        ("background", po::value<std::string>()->default_value("000000"), "Color of unlit pixels as RRGGBB")
+        ("busy-render", "Redraw the window continuously instead of waiting for new frames, for comparing CPU usage")
+        ("quirks", po::value<std::string>(), "Quirk profile of the program: cosmac-vip, chip-48, super-chip, xo-chip or legacy, legacy unless found in the quirk database")
+        ("wrap-sprites", "Wrap sprites around the edges of the display instead of clipping them, whatever the quirk profile says")
+        ("quirk-database", po::value<std::string>(), "File listing the quirk profiles of programs by their hash")
+        ("print-hash", "Print the hash of the program which it is listed by in quirk databases and exit")
+        ("analyze", "Print the instructions which static analysis cannot prove to stay within memory and exit")
+        ("rewind-seconds", po::value<unsigned>()->default_value(0), "Seconds of history kept for rewinding with Backspace, 0 disables rewinding")
+        ("rewind-memory", po::value<unsigned>()->default_value(4), "MiB of memory for the rewind history")
+        ("seed", po::value<std::uint32_t>(), "Seed of the random number generator, for reproducible runs")
+        ("record", po::value<std::string>(), "Record the keys held in every frame to an input log")
+        ("replay", po::value<std::string>(), "Replay an input log headless as fast as possible, then print the display and registers")
+        ("headless", "Run without a window as fast as possible, then print the display and registers")
+        ("instructions", po::value<std::size_t>(), "Number of instructions to execute in headless mode")
+        ("frames", po::value<std::size_t>(), "Number of 60 Hz frames to execute in headless mode")
+        ("rewind-frames", po::value<std::size_t>()->default_value(0), "Number of frames to step back in headless mode before printing the state")
+        ("profile", po::value<std::string>(), "Count executed instructions and memory accesses, written on exit as CSV if the file ends in .csv and JSON otherwise")
+        ("gdb", po::value<std::uint16_t>(), "Wait for GDB to connect to this port of localhost, the program starts stopped")
+        ("trace", po::value<std::string>()->default_value("chip8.trace"), "File the last instructions executed are written to if the program fails, decoded by chip8_trace")
+        ("mute", "Do not play sound")
+        ("wav", po::value<std::string>(), "Write the sound to a WAV file instead of playing it, also in headless mode");
     
     po::variables_map options;
     po::store(po::parse_command_line(argc, argv, desc), options);
@@ -68,22 +149,484 @@ Emulator::Emulator(int argc, char** argv)
         }
     }
 
-    m_virtualMachine.LoadProgram(program);
+    const auto clockSpeed {options.at("clock-speed").as<std::uint32_t>()};
+    if (clockSpeed == 0)
+    {
+        std::println("Clock speed must be greater than zero!");
+        std::exit(EXIT_FAILURE);
+    }
+    m_virtualMachine.SetClockSpeed(clockSpeed);
+
+    m_scale = options.at("scale").as<unsigned>();
+    if (m_scale == 0)
+    {
+        std::println("Scale must be greater than zero!");
+        std::exit(EXIT_FAILURE);
+    }
+
+    const auto foreground {ParseColor(options.at("foreground").as<std::string>())};
+    const auto background {ParseColor(options.at("background").as<std::string>())};
+    if (not foreground.has_value() or not background.has_value())
+    {
+        std::println("Colors must be given as RRGGBB!");
+        std::exit(EXIT_FAILURE);
+    }
+    m_foreground = foreground.value();
+    m_background = background.value();
+
+    m_busyRender = options.count("busy-render") > 0;
+
+    const auto programHash {CHIP8::InputLog::HashProgram(program)};
+    if (options.count("print-hash"))
+    {
+        std::println("{:016X}", programHash);
+        std::exit(EXIT_SUCCESS);
+    }
+
+    std::optional<CHIP8::InputLog> replayedLog;
+    if (options.count("replay"))
+    {
+        try
+        {
+            replayedLog = CHIP8::InputLog::Load(options.at("replay").as<std::string>());
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::println("{}!", e.what());
+            std::exit(EXIT_FAILURE);
+        }
+        if (replayedLog->header.programHash != programHash)
+        {
+            std::println("Input log was recorded with another program!");
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    //given on the command line or found in the database, the VM keeps its default profile otherwise
+    std::optional<CHIP8::QuirkProfile> quirkProfile;
+    if (options.count("quirks"))
+    {
+        const auto quirkProfileName {options.at("quirks").as<std::string>()};
+        quirkProfile = CHIP8::ParseQuirkProfile(quirkProfileName);
+        if (not quirkProfile.has_value())
+        {
+            std::println("Unknown quirk profile {}!", quirkProfileName);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    else if (options.count("quirk-database"))
+    {
+        try
+        {
+            quirkProfile = CHIP8::QuirkDatabase::Load(options.at("quirk-database").as<std::string>()).Find(programHash);
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::println("{}!", e.what());
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    //a replay brings the profile it was recorded with
+    if (replayedLog.has_value())
+    {
+        quirkProfile = replayedLog->header.quirkProfile;
+    }
+    if (quirkProfile.has_value())
+    {
+        m_virtualMachine.SetQuirkProfile(quirkProfile.value());
+    }
+    if (options.count("wrap-sprites"))
+    {
+        m_virtualMachine.SetSpriteEdgeMode(CHIP8::Framebuffer::EdgeMode::Wrap);
+    }
+
+    //the profile decides how much memory there is for the program
+    try
+    {
+        m_virtualMachine.LoadProgram(program);
+    }
+    catch (const std::invalid_argument& e)
+    {
+        std::println("{}!", e.what());
+        std::exit(EXIT_FAILURE);
+    }
+
+    //the analysis depends on the quirks, so it is printed once the profile is known
+    if (options.count("analyze"))
+    {
+        const auto& diagnostics = m_virtualMachine.GetProgramAnalysis().diagnostics;
+        if (diagnostics.empty())
+        {
+            std::println("Every memory access of the program stays within memory");
+        }
+        for (const auto& diagnostic : diagnostics)
+        {
+            std::println("{:04X}: {}", diagnostic.address, diagnostic.message);
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+
+    const auto rewindSeconds {options.at("rewind-seconds").as<unsigned>()};
+    if (rewindSeconds > 0)
+    {
+        const std::size_t rewindMemory {options.at("rewind-memory").as<unsigned>() * 1024UZ * 1024UZ};
+        try
+        {
+            m_virtualMachine.EnableRewind(rewindSeconds * FRAME_RATE, rewindMemory);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::println("{}!", e.what());
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    m_rewindFrameCount = options.at("rewind-frames").as<std::size_t>();
+    if (m_rewindFrameCount > 0 and rewindSeconds == 0)
+    {
+        std::println("Rewinding frames requires a rewind history, given with --rewind-seconds!");
+        std::exit(EXIT_FAILURE);
+    }
+    m_tracePath = options.at("trace").as<std::string>();
+
+    if (options.count("profile"))
+    {
+        if (not CHIP8::Profiler::ENABLED)
+        {
+            std::println("Profiling requires a build with CHIP8_ENABLE_PROFILER!");
+            std::exit(EXIT_FAILURE);
+        }
+        m_profilePath = options.at("profile").as<std::string>();
+        m_virtualMachine.EnableProfiler();
+    }
+
+    m_headless = options.count("headless") > 0 or replayedLog.has_value();
+    if (m_headless)
+    {
+        //a replay runs for as many frames as were recorded unless told otherwise
+        if (options.count("instructions") == options.count("frames") and not replayedLog.has_value())
+        {
+            std::println("Headless mode requires exactly one of --instructions and --frames!");
+            std::exit(EXIT_FAILURE);
+        }
+        if (options.count("instructions") and options.count("frames"))
+        {
+            std::println("Only one of --instructions and --frames can be given!");
+            std::exit(EXIT_FAILURE);
+        }
+        //the recorded keys and the timers only advance at the start of each frame
+        if (options.count("instructions") and replayedLog.has_value())
+        {
+            std::println("A replay runs frame by frame, --instructions cannot be given with --replay!");
+            std::exit(EXIT_FAILURE);
+        }
+        if (options.count("instructions"))
+        {
+            m_instructionCount = options.at("instructions").as<std::size_t>();
+        }
+        else if (options.count("frames"))
+        {
+            m_frameCount = options.at("frames").as<std::size_t>();
+        }
+        else
+        {
+            m_frameCount = replayedLog->frames.size();
+        }
+    }
+
+    const auto engine {options.at("engine").as<std::string>()};
+    if (engine == "interpreter")
+    {
+        m_virtualMachine.SetExecutionEngine(CHIP8::VirtualMachine::ExecutionEngine::Interpreter);
+    }
+    else if (engine == "threaded")
+    {
+        m_virtualMachine.SetExecutionEngine(CHIP8::VirtualMachine::ExecutionEngine::Threaded);
+    }
+    else if (engine == "jit")
+    {
+        m_virtualMachine.SetExecutionEngine(CHIP8::VirtualMachine::ExecutionEngine::Jit);
+        if (m_virtualMachine.GetExecutionEngine() != CHIP8::VirtualMachine::ExecutionEngine::Jit)
+        {
+            std::println("JIT is not available on this platform, using threaded engine instead");
+        }
+        else if (options.count("perf-map"))
+        {
+            m_virtualMachine.EnableJitPerfMap();
+        }
+    }
+    else
+    {
+        std::println("Unknown execution engine {}!", engine);
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (options.count("gdb"))
+    {
+        if (m_headless)
+        {
+            std::println("Debugging with GDB requires the window!");
+            std::exit(EXIT_FAILURE);
+        }
+        const auto port = options.at("gdb").as<std::uint16_t>();
+        try
+        {
+            m_gdbStub = std::make_unique<CHIP8::GdbStub>(m_virtualMachine, port);
+        }
+        catch (const boost::system::system_error& e)
+        {
+            std::println("{}!", e.what());
+            std::exit(EXIT_FAILURE);
+        }
+        std::println("Waiting for GDB on port {}, connect with target remote localhost:{}", port, port);
+    }
+
+    if (options.count("wav"))
+    {
+        try
+        {
+            m_virtualMachine.SetAudioSink(std::make_unique<CHIP8::WavFileSink>(options.at("wav").as<std::string>(), CHIP8::Beeper::DEFAULT_SAMPLE_RATE));
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::println("{}!", e.what());
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    //headless runs are not paced, their sound can only be written to a file
+    else if (not m_headless and not options.count("mute"))
+    {
+        auto sfmlAudioSink = std::make_unique<SfmlAudioSink>();
+        m_sfmlAudioSink = sfmlAudioSink.get();
+        m_virtualMachine.SetAudioSink(std::move(sfmlAudioSink));
+    }
+
+    //a replay brings the settings it was recorded with, the keys are replayed frame by frame
+    if (replayedLog.has_value())
+    {
+        const auto& header = replayedLog->header;
+        m_virtualMachine.SetRandomSeed(header.randomSeed);
+        m_virtualMachine.SetClockSpeed(header.clockSpeed);
+        m_virtualMachine.SetSpriteEdgeMode(header.wrapSprites ? std::optional {CHIP8::Framebuffer::EdgeMode::Wrap} : std::nullopt);
+        m_virtualMachine.SetKeyboard(std::make_unique<CHIP8::ReplayKeyboard>(std::move(replayedLog->frames)));
+        return;
+    }
+
+    std::unique_ptr<CHIP8::Keyboard> keyboard;
+    if (m_headless)
+    {
+        keyboard = std::make_unique<CHIP8::NullKeyboard>();
+    }
+    else
+    {
+        auto sfmlKeyboard = std::make_unique<SfmlKeyboard>();
+        m_sfmlKeyboard = sfmlKeyboard.get();
+        keyboard = std::move(sfmlKeyboard);
+    }
+
+    //a recorded run has to be reproducible, so it needs a known seed
+    std::optional<std::uint32_t> seed;
+    if (options.count("seed"))
+    {
+        seed = options.at("seed").as<std::uint32_t>();
+    }
+    else if (options.count("record"))
+    {
+        seed = std::random_device {}();
+    }
+    if (seed.has_value())
+    {
+        m_virtualMachine.SetRandomSeed(seed.value());
+    }
+
+    if (options.count("record"))
+    {
+        if (rewindSeconds > 0)
+        {
+            std::println("Recording and rewinding cannot be combined!");
+            std::exit(EXIT_FAILURE);
+        }
+
+        const CHIP8::InputLog::Header header 
+        {
+            programHash,
+            seed.value(),
+            clockSpeed,
+            m_virtualMachine.GetQuirkProfile(),
+            options.count("wrap-sprites") > 0
+        };
+        try
+        {
+            keyboard = std::make_unique<CHIP8::RecordingKeyboard>(std::move(keyboard), options.at("record").as<std::string>(), header);
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::println("{}!", e.what());
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    m_virtualMachine.SetKeyboard(std::move(keyboard));
 }
 
 void Emulator::Run()
 {
-    std::jthread vmThread {&CHIP8::VirtualMachine::Run, &m_virtualMachine};
-    sf::RenderWindow mainWindow {sf::VideoMode{640, 320}, "CHIP-8 emulator"};
-    
-    sf::Image whiteRectImage;
-    whiteRectImage.create(10, 10, sf::Color::White);
-    sf::Texture whiteRectTexture;
-    whiteRectTexture.loadFromImage(whiteRectImage);
+    if (m_headless)
+    {
+        RunHeadless();
+    }
+    else
+    {
+        RunWindowed();
+    }
+    //the VM thread has finished by now
+    WriteProfile();
+    if (m_failed)
+    {
+        std::println("{}!", m_failure);
+        WriteTrace();
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void Emulator::RunHeadless()
+{
+    try
+    {
+        if (m_instructionCount > 0)
+        {
+            m_virtualMachine.Execute(m_instructionCount);
+        }
+        else
+        {
+            m_virtualMachine.RunFrames(m_frameCount);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        m_failure = e.what();
+        m_failed = true;
+        return;
+    }
+    m_virtualMachine.RewindFrames(m_rewindFrameCount);
+    PrintState();
+    PrintRewindStatistics();
+}
+
+void Emulator::PrintState()
+{
+    //pixels lit in the second plane are shown apart from those of the first one
+    constexpr std::string_view PIXEL_COLORS = ".#+*";
+    const auto& display = m_virtualMachine.GetDisplayMemory();
+    for (const auto rowIndex : std::views::iota(0U, display.GetHeight()))
+    {
+        for (const auto columnIndex : std::views::iota(0U, display.GetWidth()))
+        {
+            std::print("{}", PIXEL_COLORS[display.GetPixel(columnIndex, rowIndex)]);
+        }
+        std::println("");
+    }
+
+    for (const auto [index, value] : m_virtualMachine.GetRegisters() | std::views::enumerate)
+    {
+        std::print("V{:X}={:02X} ", index, std::to_integer<unsigned>(value));
+    }
+    std::println("");
+    std::println("I={:03X} PC={:03X}", m_virtualMachine.GetAddressRegister(), m_virtualMachine.GetProgramCounter());
+}
+
+void Emulator::PrintRewindStatistics()
+{
+    const auto statistics = m_virtualMachine.GetRewindStatistics();
+    if (statistics.has_value())
+    {
+        std::println("Rewind history holds {} frames in {:.1f} of {:.1f} KiB, capturing took {} ns per frame", 
+            statistics->frameCount, statistics->usedBytes / 1024.0, statistics->capacityBytes / 1024.0, statistics->averageCaptureTime.count());
+    }
+}
+
+void Emulator::PrintAudioStatistics()
+{
+    if (m_sfmlAudioSink == nullptr)
+    {
+        return;
+    }
+    const auto statistics = m_sfmlAudioSink->GetStatistics();
+    std::println("Sound had {} underruns and dropped {} samples, {} of {} samples were queued at exit", 
+        statistics.underruns, statistics.droppedSamples, statistics.queuedSamples, statistics.maxQueuedSamples);
+}
+
+void Emulator::WriteProfile()
+{
+    const auto* profiler = m_virtualMachine.GetProfiler();
+    if (profiler == nullptr)
+    {
+        return;
+    }
 
-    CHIP8::VirtualMachine::DisplayMemory previousDisplay {boost::extents[m_virtualMachine.GetDisplayHeight()][m_virtualMachine.GetDisplayWidth()]};
+    std::ofstream profileFile {m_profilePath};
+    if (not profileFile.is_open())
+    {
+        std::println("Cannot open file {}!", m_profilePath);
+        return;
+    }
+    if (std::filesystem::path {m_profilePath}.extension() == ".csv")
+    {
+        profiler->WriteCsv(profileFile);
+    }
+    else
+    {
+        profiler->WriteJson(profileFile);
+    }
+    std::println("Profiled {} instructions into {}", profiler->GetInstructionCount(), m_profilePath);
+}
 
-    while (mainWindow.isOpen())
+void Emulator::WriteTrace()
+{
+    const auto& trace = m_virtualMachine.GetExecutionTrace();
+    try
+    {
+        trace.Save(m_tracePath, m_failure);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::println("{}!", e.what());
+        return;
+    }
+    std::println("Wrote the last {} instructions to {}, decode them with chip8_trace", 
+        std::min<std::uint64_t>(trace.GetRecordedCount(), CHIP8::ExecutionTrace::CAPACITY), m_tracePath);
+}
+
+void Emulator::RunWindowed()
+{
+    //a failing program closes the window, the failure is reported once the thread has finished
+    std::jthread vmThread {[this]
+    {
+        try
+        {
+            //a GDB stub is served between frames, it keeps the program paused until a debugger continues it
+            m_virtualMachine.Run();
+        }
+        catch (const std::exception& e)
+        {
+            m_failure = e.what();
+            m_failed = true;
+        }
+    }};
+    if (m_sfmlAudioSink != nullptr)
+    {
+        m_sfmlAudioSink->Play();
+    }
+    Renderer renderer {m_scale, m_foreground, m_background};
+    const auto windowSize = renderer.GetSize();
+    sf::RenderWindow mainWindow {sf::VideoMode{windowSize.x, windowSize.y}, "CHIP-8 emulator"};
+
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto startCpuTime = GetThreadCpuTime();
+
+    //the window keeps showing the last frame, it only has to be redrawn when the display
+    //changed or the window system may have discarded its contents
+    bool redrawWindow {true};
+    auto lastPresentTime = startTime;
+    while (mainWindow.isOpen() and not m_failed)
     {
         sf::Event event;
         while (mainWindow.pollEvent(event))
@@ -92,36 +635,61 @@ void Emulator::Run()
             { 
                 mainWindow.close();
             }
+            else if (event.type == sf::Event::Resized or event.type == sf::Event::GainedFocus)
+            {
+                redrawWindow = true;
+            }
+            else if ((event.type == sf::Event::KeyPressed or event.type == sf::Event::KeyReleased) and event.key.code == sf::Keyboard::Backspace)
+            {
+                m_virtualMachine.SetRewinding(event.type == sf::Event::KeyPressed);
+            }
+
+            if (m_sfmlKeyboard->HandleEvent(event))
+            {
+                m_virtualMachine.NotifyKeyboardChanged();
+            }
         }
-        
-        mainWindow.clear(sf::Color::Black);
 
-        auto display = m_virtualMachine.GetDisplayMemory();
-        if (display.has_value())
+        if (m_busyRender)
         {
-            previousDisplay = display.value();
+            renderer.Update(m_virtualMachine.GetDisplayMemory());
+            mainWindow.clear(m_background);
+            renderer.Draw(mainWindow);
+            mainWindow.display();
+            continue;
         }
-        else
+        
+        if (renderer.Update(m_virtualMachine.GetDisplayMemory()) or redrawWindow)
         {
-            display = previousDisplay;
+            //never present faster than 60 Hz, even when the VM catches up on several frames at once
+            std::this_thread::sleep_until(lastPresentTime + PRESENT_PERIOD);
+            mainWindow.clear(m_background);
+            renderer.Draw(mainWindow);
+            mainWindow.display();
+            lastPresentTime = std::chrono::steady_clock::now();
+            redrawWindow = false;
         }
 
-        for (const auto [rowIndex, row] : display.value() | std::views::enumerate)
-        {
-            for (const auto columnIndex : std::views::iota(0UZ, row.size()))
-            {
-                const auto pixel = row[columnIndex];
-                if (pixel)
-                {
-                    sf::Sprite whiteRect {whiteRectTexture};
-                    whiteRect.setPosition(columnIndex * 10, rowIndex * 10);
-                    mainWindow.draw(whiteRect);
-                }
-            }
-        }
+        //sleep until the VM publishes a frame; SFML cannot wake the sleep on a window event, so it wakes up once per
+        //period to poll them, also while Fx0A waits and nothing is published, which bounds the latency of a key to a period
+        m_virtualMachine.WaitForDisplay(renderer.GetGeneration(), std::chrono::steady_clock::now() + PRESENT_PERIOD);
+    }
 
-        mainWindow.display();
+    const auto endCpuTime = GetThreadCpuTime();
+    if (startCpuTime.has_value() and endCpuTime.has_value())
+    {
+        const std::chrono::duration<double> cpuTime = endCpuTime.value() - startCpuTime.value();
+        const std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - startTime;
+        std::println("Render thread used {:.2f} s of CPU time in {:.2f} s ({:.1f}% of a core)", 
+            cpuTime.count(), wallTime.count(), 100.0 * cpuTime.count() / wallTime.count());
     }
 
+    //stopped first, the queue running dry once the VM stops is not an underrun
+    if (m_sfmlAudioSink != nullptr)
+    {
+        m_sfmlAudioSink->Stop();
+    }
     m_virtualMachine.Stop();
+    PrintRewindStatistics();
+    PrintAudioStatistics();
 }
\ No newline at end of file
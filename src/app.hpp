@@ -16,11 +16,44 @@
     If not, see <https://www.gnu.org/licenses/>. 
 */
 
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <SFML/Graphics/Color.hpp>
 #include "chip8/chip8vm.hpp"
+#include "chip8/gdbStub.hpp"
+#include "sfmlKeyboard.hpp"
+#include "sfmlAudioSink.hpp"
 
 class Emulator 
 {
     CHIP8::VirtualMachine m_virtualMachine;
+    //owned by the VM, null when headless
+    SfmlKeyboard* m_sfmlKeyboard;
+    //owned by the VM, null unless sound is played on the audio device
+    SfmlAudioSink* m_sfmlAudioSink;
+    bool m_headless;
+    std::size_t m_instructionCount, m_frameCount, m_rewindFrameCount;
+    unsigned m_scale;
+    sf::Color m_foreground, m_background;
+    bool m_busyRender;
+    std::string m_profilePath;
+    //the trace of the VM is written there when the program fails
+    std::string m_tracePath;
+    //set once the program has failed, the message is only read after the VM thread has finished
+    std::atomic_bool m_failed;
+    std::string m_failure;
+    //serves GDB and runs the VM in place of Run, null unless debugging
+    std::unique_ptr<CHIP8::GdbStub> m_gdbStub;
+
+    void RunWindowed();
+    void RunHeadless();
+    void PrintState();
+    void PrintRewindStatistics();
+    void PrintAudioStatistics();
+    void WriteProfile();
+    void WriteTrace();
 
 public:
     Emulator(int argc, char** argv);
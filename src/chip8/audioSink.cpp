@@ -0,0 +1,194 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "audioSink.hpp"
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <vector>
+#include "littleEndian.hpp"
+
+namespace
+{
+    constexpr std::uint16_t BITS_PER_SAMPLE = 16;
+    constexpr std::uint32_t FMT_CHUNK_SIZE = 16, DATA_SIZE_OFFSET = 40, RIFF_SIZE_OFFSET = 4;
+}
+
+void CHIP8::AudioSink::Pause()
+{
+
+}
+
+void CHIP8::AudioSink::SkipSilence(std::size_t)
+{
+
+}
+
+CHIP8::NullAudioSink::NullAudioSink(std::uint32_t sampleRate)
+    :
+    m_sampleRate(sampleRate),
+    m_sampleCount(0)
+{
+
+}
+
+std::uint32_t CHIP8::NullAudioSink::GetSampleRate() const
+{
+    return m_sampleRate;
+}
+
+void CHIP8::NullAudioSink::Write(std::span<const std::int16_t> samples)
+{
+    m_sampleCount += samples.size();
+}
+
+void CHIP8::NullAudioSink::SkipSilence(std::size_t sampleCount)
+{
+    m_sampleCount += sampleCount;
+}
+
+std::size_t CHIP8::NullAudioSink::GetSampleCount() const
+{
+    return m_sampleCount;
+}
+
+CHIP8::WavFileSink::WavFileSink(const std::filesystem::path& path, std::uint32_t sampleRate)
+    :
+    m_sampleRate(sampleRate),
+    m_file(path, std::ios::out | std::ios::binary | std::ios::trunc),
+    m_sampleCount(0)
+{
+    if (not m_file.is_open())
+    {
+        throw std::runtime_error {std::format("Cannot write WAV file {}", path.string())};
+    }
+
+    //the sizes are filled in once the samples are known
+    m_file.write("RIFF", 4);
+    WriteLittleEndian(m_file, std::uint32_t {0});
+    m_file.write("WAVEfmt ", 8);
+    WriteLittleEndian(m_file, FMT_CHUNK_SIZE);
+    //integer PCM, mono
+    WriteLittleEndian(m_file, std::uint16_t {1});
+    WriteLittleEndian(m_file, std::uint16_t {1});
+    WriteLittleEndian(m_file, m_sampleRate);
+    WriteLittleEndian(m_file, static_cast<std::uint32_t>(m_sampleRate * BITS_PER_SAMPLE / 8));
+    WriteLittleEndian(m_file, static_cast<std::uint16_t>(BITS_PER_SAMPLE / 8));
+    WriteLittleEndian(m_file, BITS_PER_SAMPLE);
+    m_file.write("data", 4);
+    WriteLittleEndian(m_file, std::uint32_t {0});
+}
+
+CHIP8::WavFileSink::~WavFileSink()
+{
+    const auto dataSize = static_cast<std::uint32_t>(m_sampleCount * BITS_PER_SAMPLE / 8);
+    m_file.seekp(RIFF_SIZE_OFFSET);
+    WriteLittleEndian(m_file, DATA_SIZE_OFFSET - RIFF_SIZE_OFFSET + dataSize);
+    m_file.seekp(DATA_SIZE_OFFSET);
+    WriteLittleEndian(m_file, dataSize);
+}
+
+std::uint32_t CHIP8::WavFileSink::GetSampleRate() const
+{
+    return m_sampleRate;
+}
+
+void CHIP8::WavFileSink::Write(std::span<const std::int16_t> samples)
+{
+    for (const auto sample : samples)
+    {
+        WriteLittleEndian(m_file, static_cast<std::uint16_t>(sample));
+    }
+    m_sampleCount += samples.size();
+}
+
+void CHIP8::WavFileSink::SkipSilence(std::size_t sampleCount)
+{
+    for (std::size_t sample {0}; sample < sampleCount; ++sample)
+    {
+        WriteLittleEndian(m_file, std::uint16_t {0});
+    }
+    m_sampleCount += sampleCount;
+}
+
+CHIP8::StreamingAudioSink::StreamingAudioSink(std::uint32_t sampleRate, std::size_t leadSamples, std::size_t maxQueuedSamples)
+    :
+    m_sampleRate(sampleRate),
+    m_maxQueuedSamples(maxQueuedSamples),
+    m_silentLead(leadSamples, 0),
+    m_queue(maxQueuedSamples),
+    m_paused(true),
+    m_starved(true),
+    m_underruns(0),
+    m_droppedSamples(0)
+{
+
+}
+
+std::uint32_t CHIP8::StreamingAudioSink::GetSampleRate() const
+{
+    return m_sampleRate;
+}
+
+void CHIP8::StreamingAudioSink::Write(std::span<const std::int16_t> samples)
+{
+    const auto write = [this](std::span<const std::int16_t> samples)
+    {
+        //the device clock drifts against the frame timer, samples beyond the limit would only add latency
+        const auto space = m_maxQueuedSamples - std::min(m_queue.GetSize(), m_maxQueuedSamples);
+        const auto written = m_queue.Write(samples.first(std::min(samples.size(), space)));
+        m_droppedSamples.fetch_add(samples.size() - written, std::memory_order_relaxed);
+    };
+
+    if (m_starved.exchange(false, std::memory_order_acq_rel))
+    {
+        write(m_silentLead);
+    }
+    write(samples);
+    m_paused.store(false, std::memory_order_release);
+}
+
+void CHIP8::StreamingAudioSink::Pause()
+{
+    m_paused.store(true, std::memory_order_release);
+    m_starved.store(true, std::memory_order_release);
+}
+
+void CHIP8::StreamingAudioSink::Read(std::span<std::int16_t> samples)
+{
+    const auto read = m_queue.Read(samples);
+    if (read < samples.size())
+    {
+        std::ranges::fill(samples.subspan(read), 0);
+        if (not m_paused.load(std::memory_order_acquire) and not m_starved.exchange(true, std::memory_order_acq_rel))
+        {
+            m_underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+CHIP8::StreamingAudioSink::Statistics CHIP8::StreamingAudioSink::GetStatistics() const
+{
+    return Statistics 
+    {
+        m_underruns.load(std::memory_order_relaxed),
+        m_droppedSamples.load(std::memory_order_relaxed),
+        m_queue.GetSize(),
+        m_maxQueuedSamples
+    };
+}
\ No newline at end of file
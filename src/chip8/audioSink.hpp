@@ -0,0 +1,115 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+#include "ringBuffer.hpp"
+
+namespace CHIP8
+{
+    //receives the sound of every frame the VM runs as 16-bit mono samples, implemented by the frontend
+    class AudioSink
+    {
+    public:
+        virtual ~AudioSink() = default;
+        virtual std::uint32_t GetSampleRate() const = 0;
+        //called by the VM thread after the instructions of every frame
+        virtual void Write(std::span<const std::int16_t> samples) = 0;
+        //called before Run sleeps while the program waits for the keys, nothing is written until it wakes up
+        virtual void Pause();
+        //silence which Run slept through, called when it wakes up before the next Write
+        virtual void SkipSilence(std::size_t sampleCount);
+    };
+
+    //discards the samples, only counts them
+    class NullAudioSink : public AudioSink
+    {
+        std::uint32_t m_sampleRate;
+        std::size_t m_sampleCount;
+
+    public:
+        explicit NullAudioSink(std::uint32_t sampleRate);
+        std::uint32_t GetSampleRate() const override;
+        void Write(std::span<const std::int16_t> samples) override;
+        void SkipSilence(std::size_t sampleCount) override;
+        std::size_t GetSampleCount() const;
+    };
+
+    //writes the samples to a PCM WAV file, whose header is completed when the sink is destroyed
+    class WavFileSink : public AudioSink
+    {
+        std::uint32_t m_sampleRate;
+        std::ofstream m_file;
+        std::size_t m_sampleCount;
+
+    public:
+        //throws std::runtime_error if the file cannot be written
+        WavFileSink(const std::filesystem::path& path, std::uint32_t sampleRate);
+        ~WavFileSink() override;
+        std::uint32_t GetSampleRate() const override;
+        void Write(std::span<const std::int16_t> samples) override;
+        void SkipSilence(std::size_t sampleCount) override;
+    };
+
+    //queues the samples for an audio callback running on another thread, which reads them without locks;
+    //the queue is kept short so the sound stays close to the frames which produced it, a frame arrives at once
+    //while the callback takes a little at a time, so a lead of silence keeps it from running dry before the next one
+    class StreamingAudioSink : public AudioSink
+    {
+    public:
+        struct Statistics
+        {
+            //reads which found fewer samples than requested while the VM was producing them
+            std::size_t underruns;
+            //samples which did not fit into the queue
+            std::size_t droppedSamples;
+            std::size_t queuedSamples;
+            std::size_t maxQueuedSamples;
+        };
+
+    private:
+        std::uint32_t m_sampleRate;
+        std::size_t m_maxQueuedSamples;
+        //queued ahead of the samples whenever the queue ran dry, allocated once so writing never allocates
+        std::vector<std::int16_t> m_silentLead;
+        RingBuffer<std::int16_t> m_queue;
+        //set until the first Write and while Run sleeps, the queue running dry is expected then
+        std::atomic_bool m_paused;
+        //set by the reader when the queue ran dry, the writer queues the lead again
+        std::atomic_bool m_starved;
+        std::atomic<std::size_t> m_underruns, m_droppedSamples;
+
+    public:
+        //maxQueuedSamples must hold the lead and the samples of one frame
+        StreamingAudioSink(std::uint32_t sampleRate, std::size_t leadSamples, std::size_t maxQueuedSamples);
+        std::uint32_t GetSampleRate() const override;
+        void Write(std::span<const std::int16_t> samples) override;
+        void Pause() override;
+        //audio thread, fills what is missing with silence
+        void Read(std::span<std::int16_t> samples);
+        //may be called from any thread
+        Statistics GetStatistics() const;
+    };
+}
\ No newline at end of file
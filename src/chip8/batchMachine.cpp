@@ -0,0 +1,958 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "batchMachine.hpp"
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <limits>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    //byte-wise SIMD primitives, one byte per lane,
+    //the widest instruction set the build targets is used and plain bytes elsewhere
+#if defined(__AVX2__)
+    using Vector = __m256i;
+
+    Vector Load(const std::uint8_t* source) {return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));}
+    void Store(std::uint8_t* destination, Vector value) {_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), value);}
+    Vector Broadcast(std::uint8_t value) {return _mm256_set1_epi8(static_cast<char>(value));}
+    Vector Add(Vector lhs, Vector rhs) {return _mm256_add_epi8(lhs, rhs);}
+    Vector Subtract(Vector lhs, Vector rhs) {return _mm256_sub_epi8(lhs, rhs);}
+    Vector And(Vector lhs, Vector rhs) {return _mm256_and_si256(lhs, rhs);}
+    Vector Or(Vector lhs, Vector rhs) {return _mm256_or_si256(lhs, rhs);}
+    Vector Xor(Vector lhs, Vector rhs) {return _mm256_xor_si256(lhs, rhs);}
+    //~lhs & rhs
+    Vector AndNot(Vector lhs, Vector rhs) {return _mm256_andnot_si256(lhs, rhs);}
+    Vector Equal(Vector lhs, Vector rhs) {return _mm256_cmpeq_epi8(lhs, rhs);}
+    Vector Maximum(Vector lhs, Vector rhs) {return _mm256_max_epu8(lhs, rhs);}
+    //there is no byte-wise shift, shift 16-bit words and drop the bit which crossed into the byte below
+    Vector ShiftRightOne(Vector value) {return _mm256_and_si256(_mm256_srli_epi16(value, 1), Broadcast(0x7F));}
+    bool Any(Vector mask) {return _mm256_movemask_epi8(mask) != 0;}
+#elif defined(__SSE2__)
+    using Vector = __m128i;
+
+    Vector Load(const std::uint8_t* source) {return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));}
+    void Store(std::uint8_t* destination, Vector value) {_mm_storeu_si128(reinterpret_cast<__m128i*>(destination), value);}
+    Vector Broadcast(std::uint8_t value) {return _mm_set1_epi8(static_cast<char>(value));}
+    Vector Add(Vector lhs, Vector rhs) {return _mm_add_epi8(lhs, rhs);}
+    Vector Subtract(Vector lhs, Vector rhs) {return _mm_sub_epi8(lhs, rhs);}
+    Vector And(Vector lhs, Vector rhs) {return _mm_and_si128(lhs, rhs);}
+    Vector Or(Vector lhs, Vector rhs) {return _mm_or_si128(lhs, rhs);}
+    Vector Xor(Vector lhs, Vector rhs) {return _mm_xor_si128(lhs, rhs);}
+    //~lhs & rhs
+    Vector AndNot(Vector lhs, Vector rhs) {return _mm_andnot_si128(lhs, rhs);}
+    Vector Equal(Vector lhs, Vector rhs) {return _mm_cmpeq_epi8(lhs, rhs);}
+    Vector Maximum(Vector lhs, Vector rhs) {return _mm_max_epu8(lhs, rhs);}
+    //there is no byte-wise shift, shift 16-bit words and drop the bit which crossed into the byte below
+    Vector ShiftRightOne(Vector value) {return _mm_and_si128(_mm_srli_epi16(value, 1), Broadcast(0x7F));}
+    bool Any(Vector mask) {return _mm_movemask_epi8(mask) != 0;}
+#else
+    using Vector = std::uint8_t;
+
+    Vector Load(const std::uint8_t* source) {return *source;}
+    void Store(std::uint8_t* destination, Vector value) {*destination = value;}
+    Vector Broadcast(std::uint8_t value) {return value;}
+    Vector Add(Vector lhs, Vector rhs) {return static_cast<Vector>(lhs + rhs);}
+    Vector Subtract(Vector lhs, Vector rhs) {return static_cast<Vector>(lhs - rhs);}
+    Vector And(Vector lhs, Vector rhs) {return lhs & rhs;}
+    Vector Or(Vector lhs, Vector rhs) {return lhs | rhs;}
+    Vector Xor(Vector lhs, Vector rhs) {return lhs ^ rhs;}
+    //~lhs & rhs
+    Vector AndNot(Vector lhs, Vector rhs) {return static_cast<Vector>(~lhs & rhs);}
+    Vector Equal(Vector lhs, Vector rhs) {return lhs == rhs ? 0xFF : 0x00;}
+    Vector Maximum(Vector lhs, Vector rhs) {return std::max(lhs, rhs);}
+    Vector ShiftRightOne(Vector value) {return value >> 1;}
+    bool Any(Vector mask) {return mask != 0;}
+#endif
+
+    constexpr std::size_t VECTOR_WIDTH = sizeof(Vector);
+    //groups with fewer lanes than this per vector they span are executed lane by lane
+    constexpr std::size_t MIN_LANES_PER_VECTOR = 2;
+    //lanes spread over more addresses than this run one after another for DIVERGED_STEPS steps,
+    //the masked kernels would mostly process lanes of other groups and regrouping would pass over every lane each step
+    constexpr std::size_t MAX_LOCKSTEP_GROUPS = 4;
+    constexpr std::size_t DIVERGED_STEPS = 256;
+
+    //all bits set in lanes where lhs >= rhs
+    Vector AtLeast(Vector lhs, Vector rhs) {return Equal(Maximum(lhs, rhs), lhs);}
+    //lanes of value where the mask is set, lanes of otherwise elsewhere
+    Vector Select(Vector mask, Vector value, Vector otherwise) {return Or(And(mask, value), AndNot(mask, otherwise));}
+    //1 where the condition holds, 0 elsewhere
+    Vector ToFlag(Vector condition) {return And(condition, Broadcast(1));}
+
+    //calls the kernel for every vector of lanes between the first and last lane which has a lane of the mask set
+    template <typename Kernel>
+    void ForEachVector(std::size_t firstLane, std::size_t lastLane, const std::uint8_t* mask, Kernel kernel)
+    {
+        for (auto offset = firstLane / VECTOR_WIDTH * VECTOR_WIDTH; offset <= lastLane; offset += VECTOR_WIDTH)
+        {
+            const auto vectorMask = Load(mask + offset);
+            if (Any(vectorMask))
+            {
+                kernel(offset, vectorMask);
+            }
+        }
+    }
+}
+
+CHIP8::BatchMachine::BatchMachine(std::span<const std::byte> program, std::size_t laneCount)
+    :
+    m_laneCount(laneCount),
+    m_paddedLaneCount((laneCount + LANE_ALIGNMENT - 1) / LANE_ALIGNMENT * LANE_ALIGNMENT),
+    m_registers(REGISTER_COUNT * m_paddedLaneCount, 0),
+    m_addressRegisters(m_paddedLaneCount, 0),
+    m_programCounters(m_paddedLaneCount, VirtualMachine::INITIAL_ADDRESS),
+    m_stacks(STACK_SIZE * m_paddedLaneCount, 0),
+    m_stackSizes(m_paddedLaneCount, 0),
+    m_displays(Framebuffer::LOW_HEIGHT * m_paddedLaneCount, 0),
+    m_delayTimers(m_paddedLaneCount, 0),
+    m_soundTimers(m_paddedLaneCount, 0),
+    m_pressedKeys(m_paddedLaneCount, 0),
+    m_awaitedKeys(m_paddedLaneCount, VirtualMachine::NO_AWAITED_KEY),
+    m_randomSources(laneCount),
+    m_activeLanes(m_paddedLaneCount, 0),
+    m_activeLaneCount(laneCount),
+    m_activeLaneListOutdated(true),
+    m_lanesConverged(false),
+    m_errors(laneCount),
+    m_groupMask(m_paddedLaneCount, 0),
+    m_conditions(m_paddedLaneCount, 0),
+    m_groupedLanes(laneCount),
+    m_lanesPerAddress(std::numeric_limits<std::uint16_t>::max() + 1, 0),
+    m_quirkProfile(QuirkProfile::Legacy),
+    m_spriteEdgeMode(),
+    m_executeSteps(nullptr),
+    m_clockSpeed(VirtualMachine::DEFAULT_CLOCK_SPEED),
+    m_clockRemainder(0)
+{
+    if (program.size() > MEMORY_SIZE - VirtualMachine::INITIAL_ADDRESS)
+    {
+        throw std::invalid_argument {"Program does not fit into memory"};
+    }
+
+    m_initialMemory.fill(std::byte {0});
+    std::ranges::copy(VirtualMachine::FONT | std::views::transform([](const auto n) {return std::byte {n};}), 
+        std::begin(m_initialMemory) + VirtualMachine::FONT_ADDRESS_START);
+    //the big font is never selected by classic programs, but stays readable through I like on the virtual machine
+    std::ranges::copy(VirtualMachine::BIG_FONT | std::views::transform([](const auto n) {return std::byte {n};}), 
+        std::begin(m_initialMemory) + VirtualMachine::BIG_FONT_ADDRESS_START);
+    std::ranges::copy(program, std::begin(m_initialMemory) + VirtualMachine::INITIAL_ADDRESS);
+
+    m_memory.resize(laneCount * MEMORY_SIZE);
+    for (const auto lane : std::views::iota(0UZ, laneCount))
+    {
+        std::ranges::copy(m_initialMemory, LaneMemory(lane));
+    }
+
+    std::fill_n(m_activeLanes.begin(), laneCount, ACTIVE_LANE);
+    SelectKernels();
+}
+
+void CHIP8::BatchMachine::SetRandomSeed(std::size_t lane, std::uint32_t seed)
+{
+    m_randomSources.at(lane) = RandomByteSource {seed};
+}
+
+void CHIP8::BatchMachine::SetPressedKeys(std::size_t lane, std::uint16_t pressedKeys)
+{
+    m_pressedKeys.at(lane) = pressedKeys;
+}
+
+void CHIP8::BatchMachine::SetQuirkProfile(QuirkProfile profile)
+{
+    m_quirkProfile = profile;
+    SelectKernels();
+}
+
+void CHIP8::BatchMachine::SetSpriteEdgeMode(std::optional<Framebuffer::EdgeMode> edgeMode)
+{
+    m_spriteEdgeMode = edgeMode;
+    SelectKernels();
+}
+
+void CHIP8::BatchMachine::SetClockSpeed(std::uint32_t instructionsPerSecond)
+{
+    m_clockSpeed = instructionsPerSecond;
+    m_clockRemainder = 0;
+}
+
+std::size_t CHIP8::BatchMachine::Execute(std::size_t instructionCount)
+{
+    return (this->*m_executeSteps)(instructionCount);
+}
+
+void CHIP8::BatchMachine::RunFrames(std::size_t frameCount)
+{
+    for (std::size_t frame {0}; frame < frameCount; ++frame)
+    {
+        const auto budget = m_clockSpeed + m_clockRemainder;
+        Execute(budget / VirtualMachine::FRAME_RATE);
+        m_clockRemainder = budget % VirtualMachine::FRAME_RATE;
+        TickTimers();
+    }
+}
+
+std::size_t CHIP8::BatchMachine::GetLaneCount() const
+{
+    return m_laneCount;
+}
+
+std::array<std::byte, CHIP8::BatchMachine::REGISTER_COUNT> CHIP8::BatchMachine::GetRegisters(std::size_t lane) const
+{
+    std::array<std::byte, REGISTER_COUNT> registers;
+    for (const auto index : std::views::iota(0U, REGISTER_COUNT))
+    {
+        registers[index] = std::byte {m_registers.at(index * m_paddedLaneCount + lane)};
+    }
+    return registers;
+}
+
+std::uint16_t CHIP8::BatchMachine::GetAddressRegister(std::size_t lane) const
+{
+    return m_addressRegisters.at(lane);
+}
+
+std::uint16_t CHIP8::BatchMachine::GetProgramCounter(std::size_t lane) const
+{
+    return m_programCounters.at(lane);
+}
+
+std::array<CHIP8::Framebuffer::Word, CHIP8::Framebuffer::LOW_HEIGHT> CHIP8::BatchMachine::GetDisplayRows(std::size_t lane) const
+{
+    std::array<Framebuffer::Word, Framebuffer::LOW_HEIGHT> rows;
+    for (const auto rowIndex : std::views::iota(0U, Framebuffer::LOW_HEIGHT))
+    {
+        rows[rowIndex] = m_displays.at(rowIndex * m_paddedLaneCount + lane);
+    }
+    return rows;
+}
+
+const std::string& CHIP8::BatchMachine::GetError(std::size_t lane) const
+{
+    return m_errors.at(lane);
+}
+
+std::uint8_t* CHIP8::BatchMachine::Register(unsigned index)
+{
+    return m_registers.data() + index * m_paddedLaneCount;
+}
+
+std::byte* CHIP8::BatchMachine::LaneMemory(std::size_t lane)
+{
+    return m_memory.data() + lane * MEMORY_SIZE;
+}
+
+std::uint16_t CHIP8::BatchMachine::FetchOpcode(std::size_t lane, std::uint16_t address) const
+{
+    //lanes only differ at addresses some lane has written
+    const auto* memory = m_writtenAddresses[address] or m_writtenAddresses[address + 1] ? 
+        m_memory.data() + lane * MEMORY_SIZE : 
+        m_initialMemory.data();
+    return (std::to_integer<std::uint16_t>(memory[address]) << 8) | std::to_integer<std::uint16_t>(memory[address + 1]);
+}
+
+void CHIP8::BatchMachine::Fail(std::size_t lane, std::string error)
+{
+    m_errors[lane] = std::move(error);
+    m_activeLanes[lane] = 0;
+    m_activeLaneCount -= 1;
+    m_activeLaneListOutdated = true;
+}
+
+void CHIP8::BatchMachine::SelectKernels()
+{
+    switch (m_quirkProfile)
+    {
+        case QuirkProfile::CosmacVip: SelectKernels<QuirkProfile::CosmacVip>(); break;
+        case QuirkProfile::Chip48: SelectKernels<QuirkProfile::Chip48>(); break;
+        case QuirkProfile::SuperChip: SelectKernels<QuirkProfile::SuperChip>(); break;
+        case QuirkProfile::XoChip: SelectKernels<QuirkProfile::XoChip>(); break;
+        case QuirkProfile::Legacy: SelectKernels<QuirkProfile::Legacy>(); break;
+    }
+}
+
+template <CHIP8::QuirkProfile profile>
+void CHIP8::BatchMachine::SelectKernels()
+{
+    constexpr auto wrap = Framebuffer::EdgeMode::Wrap, clip = Framebuffer::EdgeMode::Clip;
+    m_executeSteps = m_spriteEdgeMode.value_or(GetQuirks(profile).spriteEdgeMode) == wrap ? 
+        &BatchMachine::ExecuteSteps<profile, wrap> : 
+        &BatchMachine::ExecuteSteps<profile, clip>;
+}
+
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+std::size_t CHIP8::BatchMachine::ExecuteSteps(std::size_t instructionCount)
+{
+    std::size_t steps {0};
+    while (steps < instructionCount and m_activeLaneCount > 0)
+    {
+        BuildGroups();
+        //grouping is tried again afterwards, the lanes may have met at a jump or a key wait
+        if (m_groups.size() > MAX_LOCKSTEP_GROUPS)
+        {
+            steps += ExecuteLanesSeparately<profile, edgeMode>(std::min(DIVERGED_STEPS, instructionCount - steps));
+            continue;
+        }
+        for (const auto& group : m_groups)
+        {
+            ExecuteGroup<profile, edgeMode>(group);
+        }
+        steps += 1;
+    }
+    return steps;
+}
+
+void CHIP8::BatchMachine::BuildGroups()
+{
+    m_groups.clear();
+    if (m_activeLaneListOutdated)
+    {
+        m_activeLaneList.clear();
+        for (std::size_t lane {0}; lane < m_laneCount; ++lane)
+        {
+            if (m_activeLanes[lane] == ACTIVE_LANE)
+            {
+                m_activeLaneList.push_back(static_cast<std::uint32_t>(lane));
+            }
+        }
+        m_activeLaneListOutdated = false;
+    }
+
+    //lanes usually stay at the same address, which makes them a single group without sorting
+    const auto address = m_programCounters[m_activeLaneList.front()];
+    std::uint16_t divergence {0};
+    if (not std::exchange(m_lanesConverged, false))
+    {
+        for (std::size_t lane {0}; lane < m_laneCount; ++lane)
+        {
+            divergence |= (m_programCounters[lane] ^ address) & -static_cast<std::uint16_t>(m_activeLanes[lane] & 1);
+        }
+    }
+    if (divergence == 0 and address + 1U < MEMORY_SIZE and not m_writtenAddresses[address] and not m_writtenAddresses[address + 1])
+    {
+        m_groups.push_back(LaneGroup {address, DecodedOpcode {FetchOpcode(m_activeLaneList.front(), address)}, m_activeLaneList});
+        return;
+    }
+
+    //counting sort of the active lanes by program counter, lanes stay in ascending order within a group
+    m_occupiedAddresses.clear();
+    for (std::size_t lane {0}; lane < m_laneCount; ++lane)
+    {
+        if (m_activeLanes[lane] == ACTIVE_LANE and m_lanesPerAddress[m_programCounters[lane]]++ == 0)
+        {
+            m_occupiedAddresses.push_back(m_programCounters[lane]);
+        }
+    }
+
+    std::uint32_t groupEnd {0};
+    for (const auto address : m_occupiedAddresses)
+    {
+        groupEnd += std::exchange(m_lanesPerAddress[address], groupEnd);
+    }
+    for (std::size_t lane {0}; lane < m_laneCount; ++lane)
+    {
+        if (m_activeLanes[lane] == ACTIVE_LANE)
+        {
+            m_groupedLanes[m_lanesPerAddress[m_programCounters[lane]]++] = static_cast<std::uint32_t>(lane);
+        }
+    }
+
+    std::uint32_t groupBegin {0};
+    for (const auto address : m_occupiedAddresses)
+    {
+        const auto lanes = std::span {m_groupedLanes}.subspan(groupBegin, std::exchange(m_lanesPerAddress[address], 0) - groupBegin);
+        groupBegin += lanes.size();
+
+        if (address + 1U >= MEMORY_SIZE)
+        {
+            for (const auto lane : lanes)
+            {
+                Fail(lane, std::format("Program counter {:04X} is outside of memory", address));
+            }
+            continue;
+        }
+
+        if (not m_writtenAddresses[address] and not m_writtenAddresses[address + 1])
+        {
+            m_groups.push_back(LaneGroup {address, DecodedOpcode {FetchOpcode(lanes.front(), address)}, lanes});
+            continue;
+        }
+
+        //the code was modified, lanes at the same address may see different opcodes
+        std::ranges::stable_sort(lanes, {}, [&](const auto lane) {return FetchOpcode(lane, address);});
+        for (auto run = lanes; not run.empty(); )
+        {
+            const auto opcode = FetchOpcode(run.front(), address);
+            const auto length = std::ranges::find_if(run, [&](const auto lane) {return FetchOpcode(lane, address) != opcode;}) - run.begin();
+            m_groups.push_back(LaneGroup {address, DecodedOpcode {opcode}, run.first(length)});
+            run = run.subspan(length);
+        }
+    }
+}
+
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+std::size_t CHIP8::BatchMachine::ExecuteLanesSeparately(std::size_t stepCount)
+{
+    //lanes only share the opcodes at addresses no lane has written, which are the same for all of them,
+    //so running each lane for every step ends where running them in lockstep would
+    std::size_t steps {0};
+    for (const auto lane : m_activeLaneList)
+    {
+        std::size_t laneSteps {0};
+        for (; laneSteps < stepCount and m_activeLanes[lane] == ACTIVE_LANE; ++laneSteps)
+        {
+            const auto address = m_programCounters[lane];
+            if (address + 1U >= MEMORY_SIZE)
+            {
+                Fail(lane, std::format("Program counter {:04X} is outside of memory", address));
+                break;
+            }
+            ExecuteScalar<profile, edgeMode>(LaneGroup {address, DecodedOpcode {FetchOpcode(lane, address)}, {}}, lane);
+        }
+        steps = std::max(steps, laneSteps);
+    }
+    return steps;
+}
+
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+void CHIP8::BatchMachine::ExecuteGroup(const LaneGroup& group)
+{
+    //masked vectors over a sparse group would mostly process lanes of other groups
+    const auto vectorCount = group.lanes.back() / VECTOR_WIDTH - group.lanes.front() / VECTOR_WIDTH + 1;
+    if (group.lanes.size() < vectorCount * MIN_LANES_PER_VECTOR)
+    {
+        for (const auto lane : group.lanes)
+        {
+            ExecuteScalar<profile, edgeMode>(group, lane);
+        }
+        return;
+    }
+
+    //the only group of a step holds every active lane and is masked by the active lanes themselves
+    const auto wholeBatch = m_groups.size() == 1;
+    if (not wholeBatch)
+    {
+        for (const auto lane : group.lanes)
+        {
+            m_groupMask[lane] = ACTIVE_LANE;
+        }
+    }
+
+    if (not ExecuteVectorized<profile>(group, wholeBatch ? m_activeLanes.data() : m_groupMask.data()))
+    {
+        for (const auto lane : group.lanes)
+        {
+            ExecuteScalar<profile, edgeMode>(group, lane);
+        }
+    }
+
+    if (not wholeBatch)
+    {
+        for (const auto lane : group.lanes)
+        {
+            m_groupMask[lane] = 0;
+        }
+    }
+}
+
+template <CHIP8::QuirkProfile profile>
+bool CHIP8::BatchMachine::ExecuteVectorized(const LaneGroup& group, const std::uint8_t* mask)
+{
+    constexpr auto quirks = GetQuirks(profile);
+    const auto& operands = group.operands;
+    auto* vx = Register(operands.x);
+    auto* vy = Register(operands.y);
+    auto* vf = Register(0xF);
+    auto* conditions = m_conditions.data();
+    const auto nn = Broadcast(operands.nn);
+    const auto one = Broadcast(1);
+
+    const auto forEachVector = [&](auto kernel)
+    {
+        ForEachVector(group.lanes.front(), group.lanes.back(), mask, kernel);
+    };
+
+    //Vx = value, then VF = flag, in this order so VF holds the flag when x is F
+    const auto storeResultAndFlag = [&](std::size_t offset, Vector laneMask, Vector value, Vector flag)
+    {
+        Store(vx + offset, Select(laneMask, value, Load(vx + offset)));
+        Store(vf + offset, Select(laneMask, flag, Load(vf + offset)));
+    };
+    //8xy1, 8xy2 and 8xy3 clear VF after Vx on the COSMAC VIP
+    const auto storeLogicResult = [&](std::size_t offset, Vector laneMask, Vector value)
+    {
+        if constexpr (quirks.logicResetsFlag)
+        {
+            storeResultAndFlag(offset, laneMask, value, Broadcast(0));
+        }
+        else
+        {
+            Store(vx + offset, Select(laneMask, value, Load(vx + offset)));
+        }
+    };
+    //register which 8xy6 and 8xyE shift into Vx
+    const auto* shifted = quirks.shiftsVy ? vy : vx;
+
+    std::uint16_t next = group.programCounter + INSTRUCTION_WIDTH;
+    bool isSkip {false};
+    switch (operands.opcode >> 12)
+    {
+        case 0x1:
+            //every lane jumps to the same address
+            next = operands.nnn;
+            break;
+        case 0x3:
+            isSkip = true;
+            forEachVector([&](std::size_t offset, Vector laneMask)
+            {
+                Store(conditions + offset, And(laneMask, Equal(Load(vx + offset), nn)));
+            });
+            break;
+        case 0x4:
+            isSkip = true;
+            forEachVector([&](std::size_t offset, Vector laneMask)
+            {
+                Store(conditions + offset, AndNot(Equal(Load(vx + offset), nn), laneMask));
+            });
+            break;
+        case 0x5:
+            if (operands.n != 0)
+            {
+                return false;
+            }
+            isSkip = true;
+            forEachVector([&](std::size_t offset, Vector laneMask)
+            {
+                Store(conditions + offset, And(laneMask, Equal(Load(vx + offset), Load(vy + offset))));
+            });
+            break;
+        case 0x9:
+            isSkip = true;
+            forEachVector([&](std::size_t offset, Vector laneMask)
+            {
+                Store(conditions + offset, AndNot(Equal(Load(vx + offset), Load(vy + offset)), laneMask));
+            });
+            break;
+        case 0x6:
+            forEachVector([&](std::size_t offset, Vector laneMask)
+            {
+                Store(vx + offset, Select(laneMask, nn, Load(vx + offset)));
+            });
+            break;
+        case 0x7:
+            forEachVector([&](std::size_t offset, Vector laneMask)
+            {
+                const auto x = Load(vx + offset);
+                Store(vx + offset, Select(laneMask, Add(x, nn), x));
+            });
+            break;
+        case 0x8:
+            switch (operands.n)
+            {
+                case 0x0:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        Store(vx + offset, Select(laneMask, Load(vy + offset), Load(vx + offset)));
+                    });
+                    break;
+                case 0x1:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        storeLogicResult(offset, laneMask, Or(Load(vx + offset), Load(vy + offset)));
+                    });
+                    break;
+                case 0x2:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        storeLogicResult(offset, laneMask, And(Load(vx + offset), Load(vy + offset)));
+                    });
+                    break;
+                case 0x3:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        storeLogicResult(offset, laneMask, Xor(Load(vx + offset), Load(vy + offset)));
+                    });
+                    break;
+                case 0x4:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        const auto x = Load(vx + offset);
+                        const auto sum = Add(x, Load(vy + offset));
+                        //the addition overflowed if the sum is smaller than an addend
+                        storeResultAndFlag(offset, laneMask, sum, AndNot(AtLeast(sum, x), one));
+                    });
+                    break;
+                case 0x5:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        const auto x = Load(vx + offset);
+                        const auto y = Load(vy + offset);
+                        storeResultAndFlag(offset, laneMask, Subtract(x, y), ToFlag(AtLeast(x, y)));
+                    });
+                    break;
+                case 0x6:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        const auto value = Load(shifted + offset);
+                        storeResultAndFlag(offset, laneMask, ShiftRightOne(value), And(value, one));
+                    });
+                    break;
+                case 0x7:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        const auto x = Load(vx + offset);
+                        const auto y = Load(vy + offset);
+                        storeResultAndFlag(offset, laneMask, Subtract(y, x), ToFlag(AtLeast(y, x)));
+                    });
+                    break;
+                case 0xE:
+                    forEachVector([&](std::size_t offset, Vector laneMask)
+                    {
+                        const auto value = Load(shifted + offset);
+                        storeResultAndFlag(offset, laneMask, Add(value, value), ToFlag(AtLeast(value, Broadcast(0x80))));
+                    });
+                    break;
+                default: 
+                    return false;
+            }
+            break;
+        default: 
+            return false;
+    }
+
+    //every lane of the group is at the same address, only skips make them part ways
+    const std::uint8_t skipWidth = isSkip ? INSTRUCTION_WIDTH : 0;
+    if (mask == m_activeLanes.data())
+    {
+        //contiguous instead of indexed by the lane list, so the loop vectorizes
+        for (std::size_t lane {0}; lane < m_laneCount; ++lane)
+        {
+            m_programCounters[lane] = m_activeLanes[lane] != 0 ? next + (conditions[lane] & skipWidth) : m_programCounters[lane];
+        }
+        m_lanesConverged = not isSkip;
+    }
+    else
+    {
+        for (const auto lane : group.lanes)
+        {
+            m_programCounters[lane] = next + (conditions[lane] & skipWidth);
+        }
+    }
+    return true;
+}
+
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+void CHIP8::BatchMachine::ExecuteScalar(const LaneGroup& group, std::size_t lane)
+{
+    constexpr auto quirks = GetQuirks(profile);
+    const auto& operands = group.operands;
+    const auto reg = [&](unsigned index) -> std::uint8_t&
+    {
+        return m_registers[index * m_paddedLaneCount + lane];
+    };
+    const auto unimplemented = [&]
+    {
+        Fail(lane, std::format("Encountered unimplemented opcode: {:04X}", operands.opcode));
+    };
+    const auto unsupportedExtension = [&]
+    {
+        Fail(lane, std::format("Opcode {:04X} belongs to SUPER-CHIP or XO-CHIP, which the batch machine does not run", operands.opcode));
+    };
+    //memory instructions must stay inside the memory of their own lane
+    const auto failOutsideMemory = [&](std::size_t address, std::size_t length)
+    {
+        if (address + length > MEMORY_SIZE)
+        {
+            Fail(lane, std::format("Opcode {:04X} accesses memory outside of {:04X}", operands.opcode, MEMORY_SIZE));
+            return true;
+        }
+        return false;
+    };
+
+    auto& addressRegister = m_addressRegisters[lane];
+    //Fx55 and Fx65 move I past the registers they copied as far as the profile does
+    const auto advanceAddressRegister = [&]
+    {
+        if constexpr (quirks.addressIncrement != AddressIncrement::None)
+        {
+            addressRegister += operands.x + (quirks.addressIncrement == AddressIncrement::ByXPlusOne ? 1 : 0);
+        }
+    };
+    auto& stackSize = m_stackSizes[lane];
+    auto* memory = LaneMemory(lane);
+    std::uint16_t next = group.programCounter + INSTRUCTION_WIDTH;
+
+    switch (operands.opcode >> 12)
+    {
+        case 0x0:
+            if ((operands.opcode & 0xFFE0) == 0x00C0 or (operands.opcode >= 0x00FB and operands.opcode <= 0x00FF))
+            {
+                unsupportedExtension();
+                return;
+            }
+            if (operands.opcode == 0x00E0)
+            {
+                for (const auto rowIndex : std::views::iota(0U, Framebuffer::LOW_HEIGHT))
+                {
+                    m_displays[rowIndex * m_paddedLaneCount + lane] = 0;
+                }
+            }
+            else if (operands.opcode == 0x00EE)
+            {
+                if (stackSize == 0)
+                {
+                    Fail(lane, "Return with an empty stack");
+                    return;
+                }
+                stackSize -= 1;
+                next = m_stacks[stackSize * m_paddedLaneCount + lane] + INSTRUCTION_WIDTH;
+            }
+            break;
+        case 0x1: 
+            next = operands.nnn; 
+            break;
+        case 0x2:
+            if (stackSize == STACK_SIZE)
+            {
+                Fail(lane, "Stack overflow");
+                return;
+            }
+            m_stacks[stackSize * m_paddedLaneCount + lane] = group.programCounter;
+            stackSize += 1;
+            next = operands.nnn;
+            break;
+        case 0x3:
+            next += reg(operands.x) == operands.nn ? INSTRUCTION_WIDTH : 0;
+            break;
+        case 0x4:
+            next += reg(operands.x) != operands.nn ? INSTRUCTION_WIDTH : 0;
+            break;
+        case 0x5:
+            if (operands.n != 0)
+            {
+                unsupportedExtension();
+                return;
+            }
+            next += reg(operands.x) == reg(operands.y) ? INSTRUCTION_WIDTH : 0;
+            break;
+        case 0x6:
+            reg(operands.x) = operands.nn;
+            break;
+        case 0x7:
+            reg(operands.x) += operands.nn;
+            break;
+        case 0x8:
+        {
+            //VF is written after Vx, as the VM does
+            const auto x = reg(operands.x), y = reg(operands.y);
+            const auto shifted = quirks.shiftsVy ? y : x;
+            //the COSMAC VIP clears VF after 8xy1, 8xy2 and 8xy3
+            const auto resetFlag = [&]
+            {
+                if constexpr (quirks.logicResetsFlag)
+                {
+                    reg(0xF) = 0;
+                }
+            };
+            switch (operands.n)
+            {
+                case 0x0: reg(operands.x) = y; break;
+                case 0x1: reg(operands.x) = x | y; resetFlag(); break;
+                case 0x2: reg(operands.x) = x & y; resetFlag(); break;
+                case 0x3: reg(operands.x) = x ^ y; resetFlag(); break;
+                case 0x4: reg(operands.x) = x + y; reg(0xF) = x + y > 0xFF ? 1 : 0; break;
+                case 0x5: reg(operands.x) = x - y; reg(0xF) = x >= y ? 1 : 0; break;
+                case 0x6: reg(operands.x) = shifted >> 1; reg(0xF) = shifted & 1; break;
+                case 0x7: reg(operands.x) = y - x; reg(0xF) = y >= x ? 1 : 0; break;
+                case 0xE: reg(operands.x) = shifted << 1; reg(0xF) = shifted >> 7; break;
+                default:
+                    unimplemented();
+                    return;
+            }
+            break;
+        }
+        case 0x9:
+            next += reg(operands.x) != reg(operands.y) ? INSTRUCTION_WIDTH : 0;
+            break;
+        case 0xA: 
+            addressRegister = operands.nnn; 
+            break;
+        case 0xB: 
+            next = operands.nnn + reg(quirks.jumpsWithVx ? operands.x : 0); 
+            break;
+        case 0xC: 
+            reg(operands.x) = m_randomSources[lane]() & operands.nn; 
+            break;
+        case 0xD:
+        {
+            if (operands.n == 0)
+            {
+                unsupportedExtension();
+                return;
+            }
+            if (failOutsideMemory(addressRegister, operands.n))
+            {
+                return;
+            }
+            const unsigned x = reg(operands.x), y = reg(operands.y);
+            Framebuffer::Word collision {0};
+            constexpr auto clipped = edgeMode == Framebuffer::EdgeMode::Clip;
+            if (not clipped or (x < Framebuffer::LOW_WIDTH and y < Framebuffer::LOW_HEIGHT))
+            {
+                for (unsigned rowOffset {0}; rowOffset < operands.n; ++rowOffset)
+                {
+                    auto rowIndex = y + rowOffset;
+                    if (not clipped)
+                    {
+                        rowIndex %= Framebuffer::LOW_HEIGHT;
+                    }
+                    else if (rowIndex >= Framebuffer::LOW_HEIGHT)
+                    {
+                        break;
+                    }
+                    const auto mask = Framebuffer::PlaceSpriteRow(memory[addressRegister + rowOffset], x, edgeMode);
+                    auto& row = m_displays[rowIndex * m_paddedLaneCount + lane];
+                    collision |= row & mask;
+                    row ^= mask;
+                }
+            }
+            reg(0xF) = collision != 0 ? 1 : 0;
+            break;
+        }
+        case 0xE:
+        {
+            const auto key = reg(operands.x);
+            const auto pressed = key < Keyboard::KEYS and ((m_pressedKeys[lane] >> key) & 1) != 0;
+            if (operands.nn == 0x9E or operands.nn == 0xA1)
+            {
+                if (pressed == (operands.nn == 0x9E))
+                {
+                    next += INSTRUCTION_WIDTH;
+                }
+            }
+            else
+            {
+                unimplemented();
+                return;
+            }
+            break;
+        }
+        case 0xF:
+            switch (operands.nn)
+            {
+                case 0x07: 
+                    reg(operands.x) = m_delayTimers[lane]; 
+                    break;
+                case 0x0A:
+                {
+                    //wait for a press and its release by executing the instruction again, as the VM does
+                    auto& awaitedKey = m_awaitedKeys[lane];
+                    if (awaitedKey == VirtualMachine::NO_AWAITED_KEY and m_pressedKeys[lane] != 0)
+                    {
+                        awaitedKey = static_cast<std::uint8_t>(std::countr_zero(m_pressedKeys[lane]));
+                    }
+                    if (awaitedKey == VirtualMachine::NO_AWAITED_KEY or ((m_pressedKeys[lane] >> awaitedKey) & 1) != 0)
+                    {
+                        next = group.programCounter;
+                    }
+                    else
+                    {
+                        reg(operands.x) = std::exchange(awaitedKey, VirtualMachine::NO_AWAITED_KEY);
+                    }
+                    break;
+                }
+                case 0x15: 
+                    m_delayTimers[lane] = reg(operands.x); 
+                    break;
+                case 0x18: 
+                    m_soundTimers[lane] = reg(operands.x); 
+                    break;
+                case 0x1E: 
+                    addressRegister += reg(operands.x); 
+                    break;
+                case 0x29: 
+                    addressRegister = VirtualMachine::FONT_ADDRESS_START + reg(operands.x) * VirtualMachine::HEX_DIGIT_SPRITE_SIZE; 
+                    break;
+                case 0x33:
+                {
+                    if (failOutsideMemory(addressRegister, 3))
+                    {
+                        return;
+                    }
+                    const auto value = reg(operands.x);
+                    memory[addressRegister] = std::byte {static_cast<std::uint8_t>(value / 100)};
+                    memory[addressRegister + 1] = std::byte {static_cast<std::uint8_t>(value / 10 % 10)};
+                    memory[addressRegister + 2] = std::byte {static_cast<std::uint8_t>(value % 10)};
+                    for (const auto address : std::views::iota(addressRegister, static_cast<std::uint16_t>(addressRegister + 3)))
+                    {
+                        m_writtenAddresses.set(address);
+                    }
+                    break;
+                }
+                case 0x55:
+                    if (failOutsideMemory(addressRegister, operands.x + 1U))
+                    {
+                        return;
+                    }
+                    for (const auto index : std::views::iota(0U, operands.x + 1U))
+                    {
+                        memory[addressRegister + index] = std::byte {reg(index)};
+                        m_writtenAddresses.set(addressRegister + index);
+                    }
+                    advanceAddressRegister();
+                    break;
+                case 0x65:
+                    if (failOutsideMemory(addressRegister, operands.x + 1U))
+                    {
+                        return;
+                    }
+                    for (const auto index : std::views::iota(0U, operands.x + 1U))
+                    {
+                        reg(index) = std::to_integer<std::uint8_t>(memory[addressRegister + index]);
+                    }
+                    advanceAddressRegister();
+                    break;
+                default:
+                    unimplemented();
+                    return;
+            }
+            break;
+        default:
+            unimplemented();
+            return;
+    }
+
+    m_programCounters[lane] = next;
+}
+
+void CHIP8::BatchMachine::TickTimers()
+{
+    for (std::size_t lane {0}; lane < m_paddedLaneCount; ++lane)
+    {
+        m_delayTimers[lane] -= m_delayTimers[lane] > 0 ? 1 : 0;
+        m_soundTimers[lane] -= m_soundTimers[lane] > 0 ? 1 : 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "chip8vm.hpp"
+#include "framebuffer.hpp"
+#include "instruction.hpp"
+#include "randomByteSrc.hpp"
+#include "quirks.hpp"
+
+namespace CHIP8
+{
+    //runs the same program on many VMs in lockstep, one instruction per lane per step;
+    //the state of the lanes is stored as structure of arrays so arithmetic instructions
+    //execute for a whole group of lanes at once with SIMD kernels; once the lanes spread over
+    //many addresses they run one after another for a while, as separate VMs would;
+    //only classic CHIP-8 is run, lanes fail on the instructions of SUPER-CHIP and XO-CHIP
+    class BatchMachine
+    {
+        static constexpr unsigned MEMORY_SIZE = 4096;
+        static constexpr auto REGISTER_COUNT = VirtualMachine::REGISTER_COUNT;
+        static constexpr auto STACK_SIZE = VirtualMachine::STACK_SIZE;
+        static constexpr auto INSTRUCTION_WIDTH = VirtualMachine::INSTRUCTION_WIDTH;
+        //lane arrays are padded to a whole number of the widest SIMD vectors
+        static constexpr std::size_t LANE_ALIGNMENT = 32;
+        static constexpr std::uint8_t ACTIVE_LANE = 0xFF;
+
+        //lanes which are at the same address and see the same opcode there
+        struct LaneGroup
+        {
+            std::uint16_t programCounter;
+            DecodedOpcode operands;
+            std::span<const std::uint32_t> lanes;
+        };
+
+        std::size_t m_laneCount, m_paddedLaneCount;
+
+        //indexed as [register * m_paddedLaneCount + lane]
+        std::vector<std::uint8_t> m_registers;
+        std::vector<std::uint16_t> m_addressRegisters, m_programCounters;
+        //indexed as [level * m_paddedLaneCount + lane]
+        std::vector<std::uint16_t> m_stacks;
+        std::vector<std::uint8_t> m_stackSizes;
+        //indexed as [row * m_paddedLaneCount + lane]
+        std::vector<Framebuffer::Word> m_displays;
+        std::vector<std::uint8_t> m_delayTimers, m_soundTimers;
+        std::vector<std::uint16_t> m_pressedKeys;
+        //key Fx0A waits to be released, as in VirtualMachine
+        std::vector<std::uint8_t> m_awaitedKeys;
+        std::vector<RandomByteSource> m_randomSources;
+
+        //memory of every lane, indexed as [lane * MEMORY_SIZE + address]
+        std::vector<std::byte> m_memory;
+        //memory as loaded, opcodes are fetched from here unless a lane has written the address
+        std::array<std::byte, MEMORY_SIZE> m_initialMemory;
+        std::bitset<MEMORY_SIZE> m_writtenAddresses;
+
+        //ACTIVE_LANE for lanes which still run, 0 for failed lanes and padding
+        std::vector<std::uint8_t> m_activeLanes;
+        std::size_t m_activeLaneCount;
+        //indices of the active lanes, rebuilt after a lane fails
+        std::vector<std::uint32_t> m_activeLaneList;
+        bool m_activeLaneListOutdated;
+        //set when the last step moved every active lane to the same address
+        bool m_lanesConverged;
+        std::vector<std::string> m_errors;
+
+        //scratch space of a step
+        std::vector<std::uint8_t> m_groupMask, m_conditions;
+        std::vector<std::uint32_t> m_groupedLanes;
+        std::vector<LaneGroup> m_groups;
+        //covers every 16-bit program counter, jumps with an offset and skips may leave memory
+        std::vector<std::uint32_t> m_lanesPerAddress;
+        std::vector<std::uint16_t> m_occupiedAddresses;
+
+        QuirkProfile m_quirkProfile;
+        //replaces the edge mode of the quirk profile when set
+        std::optional<Framebuffer::EdgeMode> m_spriteEdgeMode;
+        //ExecuteSteps specialized for the profile and edge mode, no kernel checks the quirks while it runs
+        std::size_t (BatchMachine::*m_executeSteps)(std::size_t instructionCount);
+        std::uint32_t m_clockSpeed, m_clockRemainder;
+
+        std::uint8_t* Register(unsigned index);
+        std::byte* LaneMemory(std::size_t lane);
+        std::uint16_t FetchOpcode(std::size_t lane, std::uint16_t address) const;
+        void Fail(std::size_t lane, std::string error);
+        //points m_executeSteps at the kernels of the quirk profile and sprite edge mode
+        void SelectKernels();
+        template <QuirkProfile profile>
+        void SelectKernels();
+        //stops early once no lane is active, returns the steps taken
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
+        std::size_t ExecuteSteps(std::size_t instructionCount);
+        void BuildGroups();
+        //runs every active lane on its own for up to stepCount steps, returns the most steps a lane took
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
+        std::size_t ExecuteLanesSeparately(std::size_t stepCount);
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
+        void ExecuteGroup(const LaneGroup& group);
+        //returns false if the opcode is not an arithmetic, skip or jump instruction
+        template <QuirkProfile profile>
+        bool ExecuteVectorized(const LaneGroup& group, const std::uint8_t* mask);
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
+        void ExecuteScalar(const LaneGroup& group, std::size_t lane);
+        void TickTimers();
+
+    public:
+        BatchMachine(std::span<const std::byte> program, std::size_t laneCount);
+        //makes Cxnn of the lane reproducible, lanes are seeded randomly otherwise
+        void SetRandomSeed(std::size_t lane, std::uint32_t seed);
+        //bit k is set while key k is held down
+        void SetPressedKeys(std::size_t lane, std::uint16_t pressedKeys);
+        //legacy unless set, like on the virtual machine
+        void SetQuirkProfile(QuirkProfile profile);
+        //like on the virtual machine, the quirk profile decides unless set
+        void SetSpriteEdgeMode(std::optional<Framebuffer::EdgeMode> edgeMode);
+        void SetClockSpeed(std::uint32_t instructionsPerSecond);
+        //runs every lane which has not failed for the given number of instructions, returns the steps taken
+        std::size_t Execute(std::size_t instructionCount);
+        //runs as VirtualMachine::RunFrames does
+        void RunFrames(std::size_t frameCount);
+
+        std::size_t GetLaneCount() const;
+        std::array<std::byte, REGISTER_COUNT> GetRegisters(std::size_t lane) const;
+        std::uint16_t GetAddressRegister(std::size_t lane) const;
+        std::uint16_t GetProgramCounter(std::size_t lane) const;
+        std::array<Framebuffer::Word, Framebuffer::LOW_HEIGHT> GetDisplayRows(std::size_t lane) const;
+        //why the lane stopped, empty while it runs
+        const std::string& GetError(std::size_t lane) const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "beeper.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //eight bits on, eight bits off, 250 Hz at the default pitch
+    constexpr CHIP8::Beeper::Pattern SQUARE_WAVE 
+    {
+        std::byte {0xFF}, std::byte {0x00}, std::byte {0xFF}, std::byte {0x00}, 
+        std::byte {0xFF}, std::byte {0x00}, std::byte {0xFF}, std::byte {0x00}, 
+        std::byte {0xFF}, std::byte {0x00}, std::byte {0xFF}, std::byte {0x00}, 
+        std::byte {0xFF}, std::byte {0x00}, std::byte {0xFF}, std::byte {0x00}
+    };
+}
+
+CHIP8::Beeper::Beeper()
+    :
+    m_pattern(SQUARE_WAVE),
+    m_pitch(DEFAULT_PITCH),
+    m_sampleRate(DEFAULT_SAMPLE_RATE),
+    m_bitsPerSample(0.0),
+    m_phase(0.0)
+{
+    UpdateBitsPerSample();
+}
+
+void CHIP8::Beeper::Reset()
+{
+    m_pattern = SQUARE_WAVE;
+    m_pitch = DEFAULT_PITCH;
+    m_phase = 0.0;
+    UpdateBitsPerSample();
+}
+
+void CHIP8::Beeper::UpdateBitsPerSample()
+{
+    m_bitsPerSample = BASE_BIT_RATE * std::exp2((m_pitch - DEFAULT_PITCH) / 48.0) / m_sampleRate;
+}
+
+void CHIP8::Beeper::SetSampleRate(std::uint32_t sampleRate)
+{
+    m_sampleRate = sampleRate;
+    UpdateBitsPerSample();
+}
+
+std::uint32_t CHIP8::Beeper::GetSampleRate() const
+{
+    return m_sampleRate;
+}
+
+void CHIP8::Beeper::SetPattern(const Pattern& pattern)
+{
+    m_pattern = pattern;
+}
+
+const CHIP8::Beeper::Pattern& CHIP8::Beeper::GetPattern() const
+{
+    return m_pattern;
+}
+
+void CHIP8::Beeper::SetPitch(std::uint8_t pitch)
+{
+    m_pitch = pitch;
+    UpdateBitsPerSample();
+}
+
+std::uint8_t CHIP8::Beeper::GetPitch() const
+{
+    return m_pitch;
+}
+
+void CHIP8::Beeper::Synthesize(bool playing, std::span<std::int16_t> samples)
+{
+    if (not playing)
+    {
+        std::ranges::fill(samples, 0);
+        return;
+    }
+
+    for (auto& sample : samples)
+    {
+        const auto bit = static_cast<unsigned>(m_phase);
+        const auto high = (std::to_integer<unsigned>(m_pattern[bit / 8]) >> (7 - bit % 8)) & 1;
+        sample = high ? AMPLITUDE : -AMPLITUDE;
+        m_phase += m_bitsPerSample;
+        if (m_phase >= PATTERN_BITS)
+        {
+            m_phase -= PATTERN_BITS;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace CHIP8
+{
+    //synthesizes the tone played while the sound timer runs, a 1-bit pattern looped at a rate set by the pitch
+    //as XO-CHIP defines it; until a program loads its own, the pattern is a plain square wave
+    class Beeper
+    {
+    public:
+        //128 bits, played from the most significant bit of the first byte
+        using Pattern = std::array<std::byte, 16>;
+
+        static constexpr std::uint8_t DEFAULT_PITCH = 64;
+        static constexpr std::uint32_t DEFAULT_SAMPLE_RATE = 44100;
+
+    private:
+        static constexpr unsigned PATTERN_BITS = 128;
+        //pattern bits per second at the default pitch, doubling every 48 steps of the pitch
+        static constexpr double BASE_BIT_RATE = 4000.0;
+        static constexpr std::int16_t AMPLITUDE = 6000;
+
+        Pattern m_pattern;
+        std::uint8_t m_pitch;
+        std::uint32_t m_sampleRate;
+        //pattern bits advanced per sample and the position in the pattern, in bits
+        double m_bitsPerSample, m_phase;
+
+        void UpdateBitsPerSample();
+
+    public:
+        Beeper();
+        //resets the pattern and pitch, keeps the sample rate
+        void Reset();
+        void SetSampleRate(std::uint32_t sampleRate);
+        std::uint32_t GetSampleRate() const;
+        void SetPattern(const Pattern& pattern);
+        const Pattern& GetPattern() const;
+        void SetPitch(std::uint8_t pitch);
+        std::uint8_t GetPitch() const;
+        //fills the samples with the tone, or with silence when not playing, continuing where the last call ended
+        void Synthesize(bool playing, std::span<std::int16_t> samples);
+    };
+}
\ No newline at end of file
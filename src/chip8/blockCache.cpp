@@ -0,0 +1,92 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "blockCache.hpp"
+#include <algorithm>
+#include <ranges>
+
+CHIP8::BlockCache::BlockCache(std::size_t memorySize)
+    :
+    m_blocks(memorySize),
+    m_coveredBytes(memorySize, false)
+{
+
+}
+
+CHIP8::BasicBlock* CHIP8::BlockCache::Find(std::uint16_t entry)
+{
+    m_retiredBlocks.clear();
+    return m_blocks.at(entry).get();
+}
+
+CHIP8::BasicBlock& CHIP8::BlockCache::Insert(BasicBlock block)
+{
+    const auto entry = block.start;
+    std::fill(m_coveredBytes.begin() + block.start, m_coveredBytes.begin() + block.end, true);
+    if (not m_blocks.at(entry))
+    {
+        m_entries.push_back(entry);
+    }
+    m_blocks.at(entry) = std::make_unique<BasicBlock>(std::move(block));
+    return *m_blocks.at(entry);
+}
+
+void CHIP8::BlockCache::Retire(std::uint16_t entry)
+{
+    m_retiredBlocks.push_back(std::move(m_blocks[entry]));
+}
+
+void CHIP8::BlockCache::Invalidate(std::size_t address, std::size_t length)
+{
+    const auto first = std::min(address, m_coveredBytes.size());
+    const auto last = std::min(address + length, m_coveredBytes.size());
+    //writes into data are the common case and do not touch any block
+    if (std::none_of(m_coveredBytes.begin() + first, m_coveredBytes.begin() + last, std::identity {}))
+    {
+        return;
+    }
+
+    const auto overlaps = [&](std::uint16_t entry)
+    {
+        const auto& block = *m_blocks[entry];
+        return block.start < last and first < block.end;
+    };
+
+    for (const auto entry : m_entries | std::views::filter(overlaps))
+    {
+        Retire(entry);
+    }
+    std::erase_if(m_entries, [&](std::uint16_t entry) {return not m_blocks[entry];});
+
+    std::fill(m_coveredBytes.begin(), m_coveredBytes.end(), false);
+    for (const auto entry : m_entries)
+    {
+        const auto& block = *m_blocks[entry];
+        std::fill(m_coveredBytes.begin() + block.start, m_coveredBytes.begin() + block.end, true);
+    }
+}
+
+void CHIP8::BlockCache::Clear()
+{
+    for (const auto entry : m_entries)
+    {
+        Retire(entry);
+    }
+    m_entries.clear();
+    std::fill(m_coveredBytes.begin(), m_coveredBytes.end(), false);
+}
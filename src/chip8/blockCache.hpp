@@ -0,0 +1,64 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "instruction.hpp"
+
+namespace CHIP8
+{
+    using NativeCode = void (*)();
+
+    //straight-line sequence of instructions which ends with a control transfer
+    struct BasicBlock
+    {
+        std::uint16_t start, end;
+        //bytes a skip ending the block jumps over, the width of the instruction at end
+        std::uint16_t skipWidth;
+        std::size_t instructionCount;
+        std::vector<PredecodedInstruction> code;
+        //filled in by the JIT once the block gets hot
+        std::size_t executionCount;
+        NativeCode native;
+    };
+
+    //translated blocks indexed by their entry address
+    class BlockCache
+    {
+        std::vector<std::unique_ptr<BasicBlock>> m_blocks;
+        std::vector<std::uint16_t> m_entries;
+        //bytes covered by at least one cached block
+        std::vector<bool> m_coveredBytes;
+        //invalidated blocks may still be executing, they are released on the next lookup
+        std::vector<std::unique_ptr<BasicBlock>> m_retiredBlocks;
+
+        void Retire(std::uint16_t entry);
+
+    public:
+        BlockCache(std::size_t memorySize);
+
+        BasicBlock* Find(std::uint16_t entry);
+        BasicBlock& Insert(BasicBlock block);
+        void Invalidate(std::size_t address, std::size_t length);
+        void Clear();
+    };
+}
@@ -19,14 +19,16 @@
 #include "chip8vm.hpp"
 #include "keyboard.hpp"
 #include <algorithm>
-#include <bitset>
+#include <cstring>
 #include <cstddef>
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <print>
 #include <stdexcept>
+#include <utility>
 #include <ranges>
 #include <source_location>
 #include <format>
@@ -54,546 +56,1883 @@ namespace
     }
 }
 
-CHIP8::DecodedOpcode::DecodedOpcode(std::uint16_t opcode)
+CHIP8::VirtualMachine::VirtualMachine()
+    :
+    m_addressRegister(0x000),
+    m_programCounter(INITIAL_ADDRESS),
+    m_delayTimer(),
+    m_soundTimer(),
+    m_displayMemory(),
+    m_publishedGeneration(0),
+    m_latestPublishedGeneration(0),
+    m_spriteEdgeMode(),
+    m_planeMask(1),
+    m_state(State::Shutdown),
+    m_clockSpeed(DEFAULT_CLOCK_SPEED),
+    m_clockRemainder(0),
+    m_keyboard(std::make_unique<NullKeyboard>()),
+    m_awaitedKey(NO_AWAITED_KEY),
+    m_waitingForKey(false),
+    m_keyWaitPeriod(0),
+    m_sleeping(false),
+    m_paused(false),
+    m_sampleRemainder(0),
+    m_frame(0),
+    m_executionEngine(ExecutionEngine::Interpreter),
+    m_quirkProfile(QuirkProfile::Legacy),
+    m_instructionTable(nullptr),
+    m_setRegAndDraw(nullptr),
+    m_blockCache(0),
+    m_unfinishedFrameInstructions(0),
+    m_rewindHistoryFrames(0),
+    m_rewindArenaBytes(0),
+    m_rewinding(false)
+{
+    m_registers.fill(std::byte{0});
+    m_flagRegisters.fill(std::byte{0});
+    ResizeMemory(GetQuirks(m_quirkProfile).memorySize);
+    std::ranges::copy(FONT | std::views::transform([](const auto n) {return std::byte{n};}), 
+        std::begin(m_memory) + FONT_ADDRESS_START);
+    std::ranges::copy(BIG_FONT | std::views::transform([](const auto n) {return std::byte{n};}), 
+        std::begin(m_memory) + BIG_FONT_ADDRESS_START);
+
+
+    UpdateHandlers();
+}
+
+void CHIP8::VirtualMachine::LoadProgram(std::span<const std::byte> program)
 {
-    std::bitset<16> opcodeBits {opcode};
-    for (auto&& [nibbleIndex, nibble] : nibbles | std::views::enumerate)
+    if (program.size() > m_memory.size() - INITIAL_ADDRESS)
     {
-        std::bitset<NIBBLE_SIZE> nibbleValue;
-        for (const auto bitIndex : std::views::iota(0, NIBBLE_SIZE))
-        {
-            nibbleValue[bitIndex] = opcodeBits.test(nibbleIndex * NIBBLE_SIZE + bitIndex);
-        }
-        nibble = nibbleValue.to_ulong();
+        throw std::invalid_argument {"Program does not fit into memory"};
     }
+    std::ranges::copy(program, std::begin(m_memory) + INITIAL_ADDRESS);
+    InvalidateInstructionCache(INITIAL_ADDRESS, program.size());
+    AnalyzeProgram();
 }
 
-std::uint16_t CHIP8::DecodedOpcode::ToUInt16(size_t nibbleCount) const
+void CHIP8::VirtualMachine::SetExecutionEngine(ExecutionEngine engine)
 {
-    if (nibbleCount > nibbles.size())
+    if (engine == ExecutionEngine::Jit and not m_jit)
     {
-        const auto srcLoc = std::source_location::current();
-        throw std::invalid_argument(std::format("{}:{}:{}: nibbleCount must be less or equal to {}", srcLoc.file_name(), srcLoc.line(), srcLoc.column(), nibbles.size()));
+        m_jit = std::make_unique<JitCompiler>(JitCompiler::GuestState
+        {
+            this,
+            m_registers.data(),
+            &m_addressRegister,
+            &m_programCounter,
+            &CHIP8::VirtualMachine::CallFromNative
+        });
     }
 
-    std::uint16_t result {0};
-    for (auto&& [nibbleIndex, nibble] : nibbles | std::views::take(nibbleCount) | std::views::enumerate)
+    if (engine == ExecutionEngine::Jit and not m_jit->IsAvailable())
     {
-        const auto offset = nibbleIndex * DecodedOpcode::NIBBLE_SIZE;
-        result |= (nibble << offset);
+        engine = ExecutionEngine::Threaded;
     }
-    return result;
+
+    m_executionEngine = engine;
 }
 
-std::byte CHIP8::DecodedOpcode::GetValue() const
+CHIP8::VirtualMachine::ExecutionEngine CHIP8::VirtualMachine::GetExecutionEngine() const
 {
-    return std::byte {static_cast<std::uint8_t>(ToUInt16(2))};
+    return m_executionEngine;
 }
 
-std::uint16_t CHIP8::DecodedOpcode::GetAddress() const
+void CHIP8::VirtualMachine::SetRandomSeed(std::uint32_t seed)
 {
-    return ToUInt16(3);
+    m_randomByteSrc = RandomByteSource {seed};
 }
 
-std::pair<std::uint8_t, std::uint8_t> CHIP8::DecodedOpcode::GetRegIndices() const
+void CHIP8::VirtualMachine::SetQuirkProfile(QuirkProfile profile)
 {
-    return {nibbles.at(2), nibbles.at(1)};
+    m_quirkProfile = profile;
+    ResizeMemory(GetQuirks(profile).memorySize);
+    UpdateHandlers();
 }
 
+CHIP8::QuirkProfile CHIP8::VirtualMachine::GetQuirkProfile() const
+{
+    return m_quirkProfile;
+}
 
-CHIP8::VirtualMachine::VirtualMachine()
-    :
-    m_addressRegister(0x000),
-    m_programCounter(INITIAL_ADDRESS),
-    m_ioCtx(),
-    m_delayTimer(m_ioCtx),
-    m_soundTimer(m_ioCtx),
-    m_clock(m_ioCtx),
-    m_displayMemory(boost::extents[DISPLAY_HEIGHT][DISPLAY_WIDTH]),
-    m_state(State::Shutdown)
+void CHIP8::VirtualMachine::SetSpriteEdgeMode(std::optional<Framebuffer::EdgeMode> edgeMode)
 {
-    m_registers.fill(std::byte{0});
-    m_memory.fill(std::byte{0});
-    std::ranges::copy(FONT | std::views::transform([](const auto n) {return std::byte{n};}), 
-        std::begin(m_memory) + FONT_ADDRESS_START);
-    
-    m_clock.expires_after(CLOCK_PERIOD);
-    m_clock.async_wait(std::bind(&CHIP8::VirtualMachine::OnClock, this, std::placeholders::_1));
-
-    m_instructionTable.fill(Instruction {&CHIP8::VirtualMachine::UnimplementedInstruction});
-
-    m_instructionTable = 
-    {
-        Instruction {&CHIP8::VirtualMachine::ZeroPrefixInstuctions},
-        Instruction {&CHIP8::VirtualMachine::Jump},
-        Instruction {&CHIP8::VirtualMachine::Call},
-        Instruction {&CHIP8::VirtualMachine::SkipOnRegValEqual},
-        Instruction {&CHIP8::VirtualMachine::SkipOnRegValNotEqual},
-        Instruction {&CHIP8::VirtualMachine::SkipOnRegsEqual},
-        Instruction {&CHIP8::VirtualMachine::SetReg},
-        Instruction {&CHIP8::VirtualMachine::Add},
-        Instruction {&CHIP8::VirtualMachine::EightPrefixInstructions},
-        Instruction {&CHIP8::VirtualMachine::SkipOnRegsNotEqual},
-        Instruction {&CHIP8::VirtualMachine::SetAddressReg},
-        Instruction {&CHIP8::VirtualMachine::JumpWithOffset},
-        Instruction {&CHIP8::VirtualMachine::AndWithRandom},
-        Instruction {&CHIP8::VirtualMachine::Draw},
-        Instruction {&CHIP8::VirtualMachine::SkipOnKeyState},
-        Instruction {&CHIP8::VirtualMachine::FPrefixInstructions},
-    };
+    m_spriteEdgeMode = edgeMode;
+    UpdateHandlers();
 }
 
-void CHIP8::VirtualMachine::LoadProgram(std::span<const std::byte> program)
+void CHIP8::VirtualMachine::UpdateHandlers()
 {
-    std::ranges::copy(program, std::begin(m_memory) + INITIAL_ADDRESS);
+    switch (m_quirkProfile)
+    {
+        case QuirkProfile::CosmacVip: SelectHandlers<QuirkProfile::CosmacVip>(); break;
+        case QuirkProfile::Chip48: SelectHandlers<QuirkProfile::Chip48>(); break;
+        case QuirkProfile::SuperChip: SelectHandlers<QuirkProfile::SuperChip>(); break;
+        case QuirkProfile::XoChip: SelectHandlers<QuirkProfile::XoChip>(); break;
+        case QuirkProfile::Legacy: SelectHandlers<QuirkProfile::Legacy>(); break;
+    }
+    //whatever was predecoded or compiled so far calls the handlers of the previous profile,
+    //and what the analysis of a loaded program proved depends on the quirks as well
+    if (m_analysis.code.empty())
+    {
+        InvalidateInstructionCache(0, m_memory.size());
+    }
+    else
+    {
+        AnalyzeProgram();
+    }
 }
 
-unsigned int CHIP8::VirtualMachine::GetDisplayHeight() const
+void CHIP8::VirtualMachine::ResizeMemory(std::size_t memorySize)
 {
-    return DISPLAY_HEIGHT;
+    if (memorySize == m_memory.size())
+    {
+        return;
+    }
+    m_memory.resize(memorySize, std::byte{0});
+    m_instructionCache.assign(memorySize, PredecodedInstruction {&Invoke<&CHIP8::VirtualMachine::PredecodeAndExecute>, DecodedOpcode {}, DecodedOpcode {}});
+    m_blockCache = BlockCache {memorySize};
+    if (m_jit)
+    {
+        m_jit->Reset();
+    }
+    m_idleLoops.assign(memorySize, IdleLoop::None);
+    m_lastIdleLoopVisit.reset();
+    //the history cannot step back into snapshots of the previous size
+    if (m_rewindBuffer)
+    {
+        m_rewindBuffer = std::make_unique<RewindBuffer>(GetSnapshotSize(), m_rewindHistoryFrames, m_rewindArenaBytes);
+    }
 }
 
-unsigned int CHIP8::VirtualMachine::GetDisplayWidth() const
+const CHIP8::ProgramAnalysis& CHIP8::VirtualMachine::GetProgramAnalysis() const
 {
-    return DISPLAY_WIDTH; 
+    return m_analysis;
 }
 
-void CHIP8::VirtualMachine::ClearDisplay()
+void CHIP8::VirtualMachine::AnalyzeProgram()
 {
-    for (auto&& row : m_displayMemory)
-    {
-        std::ranges::fill(row, false);
-    }
+    DiscardAnalysis();
+    m_analysis = CHIP8::AnalyzeProgram(m_memory, AnalysisEntry {m_programCounter, m_addressRegister, m_registers, std::span {m_stack.data(), m_stack.size()}}, 
+        GetQuirks(m_quirkProfile));
+}
+
+void CHIP8::VirtualMachine::DiscardAnalysis()
+{
+    m_analysis = {};
+    //instructions predecoded or compiled so far may rely on what it proved
+    InvalidateInstructionCache(0, m_memory.size());
 }
 
-void CHIP8::VirtualMachine::OnClock(const boost::system::error_code& errc)
+void CHIP8::VirtualMachine::EnableJitPerfMap()
 {
-    if (errc or m_state == State::Shutdown)
+    if (m_jit)
     {
-        m_ioCtx.stop();
-        return;
+        m_jit->EnablePerfMap();
     }
-    //fetch instruction
-    const auto opcode = FetchNextInstruction();
-    //decode it
-    const auto decodedOpcode = DecodedOpcode{opcode};
-    //find instruction
-    const auto instruction = GetInstruction(decodedOpcode);
-    //execute it
-    instruction(this, std::cref(decodedOpcode));
-    //increase value of program counter
-    m_programCounter += INSTRUCTION_WIDTH;
-    
-    m_clock.expires_after(CLOCK_PERIOD);
-    m_clock.async_wait(std::bind(&CHIP8::VirtualMachine::OnClock, this, std::placeholders::_1));
 }
 
-std::uint16_t CHIP8::VirtualMachine::FetchNextInstruction() const
+void CHIP8::VirtualMachine::EnableRewind(std::size_t historyFrames, std::size_t arenaBytes)
 {
-    //read first and second bytes which program counter points to
-    const auto mostSignificatByte = std::to_integer<std::uint16_t>(m_memory.at(m_programCounter));
-    const auto leastSignificantByte = std::to_integer<std::uint16_t>(m_memory.at(m_programCounter + 1));
-    //compose opcode value from these bytes
-    const std::uint16_t opcodeValue = (mostSignificatByte << 8) | leastSignificantByte;
-    return opcodeValue;
+    m_rewindBuffer = std::make_unique<RewindBuffer>(GetSnapshotSize(), historyFrames, arenaBytes);
+    m_rewindHistoryFrames = historyFrames;
+    m_rewindArenaBytes = arenaBytes;
 }
 
-CHIP8::VirtualMachine::Instruction CHIP8::VirtualMachine::GetInstruction(const DecodedOpcode& decodedOpcode) const
+void CHIP8::VirtualMachine::SetRewinding(bool rewinding)
 {
-    return m_instructionTable.at(decodedOpcode.nibbles.back());
+    m_rewinding = rewinding;
+    WakeUp();
 }
 
-void CHIP8::VirtualMachine::DrawSprite(std::uint8_t x, std::uint8_t y, std::span<std::byte> sprite)
+std::size_t CHIP8::VirtualMachine::RewindFrames(std::size_t frameCount)
 {
-    if (x >= DISPLAY_WIDTH or y >= DISPLAY_HEIGHT)
+    std::size_t rewoundFrames {0};
+    while (m_rewindBuffer and rewoundFrames < frameCount and StepBack())
     {
-        return;
+        rewoundFrames += 1;
     }
-    std::lock_guard loc {m_displayMemoryMtx};
-    const auto logicalXor = [](bool lhs, bool rhs)
-    {
-        return (not lhs and rhs) or (lhs and not rhs);
-    };
+    return rewoundFrames;
+}
 
-    const auto toBitsetAndReverse = [](std::byte n)
+std::optional<CHIP8::RewindBuffer::Statistics> CHIP8::VirtualMachine::GetRewindStatistics() const
+{
+    if (not m_rewindBuffer)
     {
-        std::bitset<8> rev {std::to_integer<std::uint8_t>(n)};
+        return {};
+    }
+    return m_rewindBuffer->GetStatistics();
+}
 
-        for (const auto i : std::views::iota(0UZ, rev.size() / 2))
-        {
-            const bool temp = rev[i];
-            rev[i] = static_cast<bool>(rev[rev.size() - i - 1]);
-            rev[rev.size() - i - 1] = temp;
-        }
+void CHIP8::VirtualMachine::EnableProfiler()
+{
+    if constexpr (Profiler::ENABLED)
+    {
+        m_profiler = std::make_unique<Profiler>();
+    }
+}
 
-        return rev;
-    };
+const CHIP8::Profiler* CHIP8::VirtualMachine::GetProfiler() const
+{
+    return m_profiler.get();
+}
 
-    bool erasedPixel {false};
+const CHIP8::ExecutionTrace& CHIP8::VirtualMachine::GetExecutionTrace() const
+{
+    return m_trace;
+}
 
-    const auto rowsToDraw = std::min(DISPLAY_HEIGHT - y, static_cast<unsigned>(sprite.size()));
-    const auto columnsToDraw = std::min(DISPLAY_WIDTH - x, 8U);
+std::size_t CHIP8::VirtualMachine::GetSnapshotSize() const
+{
+    return m_memory.size() + SNAPSHOT_STATE_SIZE;
+}
 
-    for (const auto [rowOffset, spriteRow] : 
-        sprite | 
-        std::views::transform(toBitsetAndReverse) |
-        std::views::take(rowsToDraw) |
-        std::views::enumerate)
+void CHIP8::VirtualMachine::CaptureSnapshot(std::span<std::byte> snapshot) const
+{
+    auto* output = snapshot.data();
+    const auto write = [&output](const void* source, std::size_t size)
     {
-        auto&& displayRow = m_displayMemory[y + rowOffset];
-        for (const auto columnOffset : 
-            std::views::iota(0UZ, columnsToDraw))
-        {
-            const auto oldPixel = displayRow[x + columnOffset];
-            const auto newPixel = logicalXor(oldPixel, spriteRow[columnOffset]);
-            if (oldPixel == true and newPixel == false)
-            {
-                erasedPixel = true;
-            }
-            displayRow[x + columnOffset] = newPixel;
-        }
-    }
+        std::memcpy(output, source, size);
+        output += size;
+    };
 
-    if (erasedPixel)
-    {
-        m_registers.at(0xF) = std::byte {1};
-    }
-    else
+    const auto stackSize = static_cast<std::uint8_t>(m_stack.size());
+    std::array<std::uint16_t, STACK_SIZE> stack {};
+    std::ranges::copy(m_stack, stack.begin());
+    const std::uint8_t timers[] {m_delayTimer.GetValue(m_frame), m_soundTimer.GetValue(m_frame)};
+    const auto resolution = m_displayMemory.GetResolution();
+    const auto pitch = m_beeper.GetPitch();
+
+    write(m_memory.data(), m_memory.size());
+    write(m_registers.data(), REGISTER_COUNT);
+    write(&m_addressRegister, sizeof(m_addressRegister));
+    write(&m_programCounter, sizeof(m_programCounter));
+    write(&stackSize, sizeof(stackSize));
+    write(stack.data(), sizeof(stack));
+    write(timers, sizeof(timers));
+    write(&m_awaitedKey, sizeof(m_awaitedKey));
+    write(&m_clockRemainder, sizeof(m_clockRemainder));
+    write(&resolution, sizeof(resolution));
+    write(&m_planeMask, sizeof(m_planeMask));
+    write(m_flagRegisters.data(), FLAG_REGISTER_COUNT);
+    for (unsigned plane {0}; plane < Framebuffer::PLANES; ++plane)
     {
-        m_registers.at(0xF) = std::byte {0};
+        write(m_displayMemory.GetPlane(plane).data(), sizeof(Framebuffer::Plane));
     }
+    write(m_beeper.GetPattern().data(), sizeof(Beeper::Pattern));
+    write(&pitch, sizeof(pitch));
 }
 
-std::optional<CHIP8::VirtualMachine::DisplayMemory> CHIP8::VirtualMachine::GetDisplayMemory()
+void CHIP8::VirtualMachine::RestoreSnapshot(std::span<const std::byte> snapshot)
 {
-    struct AutoUnlock
+    const auto* input = snapshot.data();
+    const auto read = [&input](void* destination, std::size_t size)
     {
-        std::reference_wrapper<std::mutex> acquiredMutex;
-        AutoUnlock(std::mutex& mtx)
-            :
-            acquiredMutex(std::ref(mtx))
-        {
+        std::memcpy(destination, input, size);
+        input += size;
+    };
 
+    //only the code which differs has to be translated again; the analysis holds for the states of this run
+    //the history keeps, unless one of them has overwritten the code, which discards it anyway
+    for (std::size_t address {0}; address < m_memory.size(); )
+    {
+        if (m_memory[address] == input[address])
+        {
+            address += 1;
+            continue;
         }
-        ~AutoUnlock()
+        const auto changeStart = address;
+        while (address < m_memory.size() and m_memory[address] != input[address])
         {
-            acquiredMutex.get().unlock();
+            m_memory[address] = input[address];
+            address += 1;
         }
-    };
-
-    if (m_displayMemoryMtx.try_lock())
-    {
-        AutoUnlock _{m_displayMemoryMtx};
-        return m_displayMemory;
+        InvalidateInstructionCache(changeStart, address - changeStart);
     }
-    else
+    input += m_memory.size();
+
+    std::uint8_t stackSize;
+    std::array<std::uint16_t, STACK_SIZE> stack;
+    std::uint8_t timers[2];
+    Framebuffer::Resolution resolution;
+    std::array<Framebuffer::Plane, Framebuffer::PLANES> planes;
+    Beeper::Pattern pattern;
+    std::uint8_t pitch;
+
+    read(m_registers.data(), REGISTER_COUNT);
+    read(&m_addressRegister, sizeof(m_addressRegister));
+    read(&m_programCounter, sizeof(m_programCounter));
+    read(&stackSize, sizeof(stackSize));
+    read(stack.data(), sizeof(stack));
+    read(timers, sizeof(timers));
+    read(&m_awaitedKey, sizeof(m_awaitedKey));
+    read(&m_clockRemainder, sizeof(m_clockRemainder));
+    read(&resolution, sizeof(resolution));
+    read(&m_planeMask, sizeof(m_planeMask));
+    read(m_flagRegisters.data(), FLAG_REGISTER_COUNT);
+    read(planes.data(), sizeof(planes));
+    read(pattern.data(), sizeof(pattern));
+    read(&pitch, sizeof(pitch));
+
+    m_stack.assign(stack.begin(), stack.begin() + stackSize);
+    m_delayTimer.Set(timers[0], m_frame);
+    m_soundTimer.Set(timers[1], m_frame);
+    m_beeper.SetPattern(pattern);
+    m_beeper.SetPitch(pitch);
+    m_displayMemory.SetPlanes(resolution, planes);
+    if (m_displayMemory.GetGeneration() != m_publishedGeneration)
     {
-        return {};
+        PublishDisplay();
     }
 }
 
-void CHIP8::VirtualMachine::Run()
+bool CHIP8::VirtualMachine::StepBack()
 {
-    m_state = State::Running;
-    m_ioCtx.run();
+    const auto snapshot = m_rewindBuffer->StepBack();
+    if (snapshot.empty())
+    {
+        return false;
+    }
+    RestoreSnapshot(snapshot);
+    return true;
 }
 
-void CHIP8::VirtualMachine::Stop()
+unsigned int CHIP8::VirtualMachine::GetDisplayHeight() const
 {
-    m_state = State::Shutdown;
+    return m_displayMemory.GetHeight();
 }
 
-#pragma region Instructions
-
-void CHIP8::VirtualMachine::UnimplementedInstruction(const DecodedOpcode& decodedOpcode)
+unsigned int CHIP8::VirtualMachine::GetDisplayWidth() const
 {
-    throw std::runtime_error(std::format("Encountered unimplemented opcode: {}", decodedOpcode.ToUInt16(decodedOpcode.nibbles.size())));
+    return m_displayMemory.GetWidth(); 
 }
 
-void CHIP8::VirtualMachine::ZeroPrefixInstuctions(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::AttachDebugger(DebugStopHandler onStop)
 {
-    switch (decodedOpcode.nibbles.front()) 
-    {   
-        //clear display
-        case 0x0:
-            ClearDisplay();
-        break;
-
-        //return from subroutine
-        case 0xE:
-            m_programCounter = m_stack.back();
-            m_stack.pop_back();
-        break;
-
-        //ignore anything else
-        default:
-            break;
-    }
+    m_debugState = std::make_unique<DebugState>();
+    m_debugState->stop = DebugStop {DebugStopReason::None, 0};
+    m_debugState->onStop = std::move(onStop);
+    //a debugger finds the program stopped
+    Pause();
 }
 
-void CHIP8::VirtualMachine::Call(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::DetachDebugger()
 {
-    m_stack.push_back(m_programCounter);
-    m_programCounter = decodedOpcode.GetAddress() - INSTRUCTION_WIDTH;
+    m_debugState.reset();
+    Resume();
 }
 
-void CHIP8::VirtualMachine::Jump(const DecodedOpcode& decodedOpcode)
+bool CHIP8::VirtualMachine::IsDebuggerAttached() const
 {
-    std::uint16_t address = decodedOpcode.GetAddress();
-    m_programCounter = address - INSTRUCTION_WIDTH;
+    return m_debugState != nullptr;
 }
 
-void CHIP8::VirtualMachine::SkipNextInstruction()
+void CHIP8::VirtualMachine::SetBreakpoint(std::uint16_t address, bool enabled)
 {
-    m_programCounter += INSTRUCTION_WIDTH;
+    if (m_debugState)
+    {
+        m_debugState->breakpoints[address] = enabled;
+    }
 }
 
-void CHIP8::VirtualMachine::SkipOnRegValEqual(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::SetWatchpoint(std::uint16_t address, std::size_t length, bool enabled)
 {
-    const auto [registerIndex, _] = decodedOpcode.GetRegIndices();
-    const auto value = decodedOpcode.GetValue();
-    if (m_registers.at(registerIndex) == value)
+    if (m_debugState)
     {
-        SkipNextInstruction();
+        const auto end = std::min<std::size_t>(address + length, m_memory.size());
+        for (std::size_t watchedAddress {address}; watchedAddress < end; ++watchedAddress)
+        {
+            m_debugState->watchpoints[watchedAddress] = enabled;
+        }
     }
 }
 
-void CHIP8::VirtualMachine::SkipOnRegValNotEqual(const DecodedOpcode& decodedOpcode)
+CHIP8::VirtualMachine::DebugStop CHIP8::VirtualMachine::GetDebugStop() const
 {
-    const auto [registerIndex, _] = decodedOpcode.GetRegIndices();
-    const auto value = decodedOpcode.GetValue();
-    if (m_registers.at(registerIndex) != value)
-    {
-        SkipNextInstruction();
-    }
+    return m_debugState ? m_debugState->stop : DebugStop {DebugStopReason::None, 0};
 }
 
-void CHIP8::VirtualMachine::SkipOnRegsEqual(const DecodedOpcode& decodedOpcode)
+std::span<const std::byte> CHIP8::VirtualMachine::GetMemory() const
+{
+    return m_memory;
+}
+
+void CHIP8::VirtualMachine::WriteMemory(std::uint16_t address, std::span<const std::byte> bytes)
 {
-    const auto regIndices = decodedOpcode.GetRegIndices();
-    if (m_registers.at(regIndices.first) == m_registers.at(regIndices.second))
+    if (address > m_memory.size() or bytes.size() > m_memory.size() - address)
     {
-        SkipNextInstruction();
+        throw std::invalid_argument {"Bytes do not fit into memory"};
     }
+    std::ranges::copy(bytes, std::begin(m_memory) + address);
+    InvalidateInstructionCache(address, bytes.size());
 }
 
-void CHIP8::VirtualMachine::SetReg(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::SetRegister(std::size_t index, std::byte value)
 {
-    const auto [registerIndex, _] = decodedOpcode.GetRegIndices();
-    const auto value = decodedOpcode.GetValue();
-    m_registers.at(registerIndex) = value;
+    m_registers.at(index) = value;
+    DiscardAnalysisOfState();
 }
 
-void CHIP8::VirtualMachine::Add(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::SetAddressRegister(std::uint16_t value)
 {
-    const auto [regIndex, _] = decodedOpcode.GetRegIndices();
-    const auto value = decodedOpcode.GetValue();
-    const std::uint8_t additionRes = std::to_integer<std::uint8_t>(m_registers.at(regIndex)) + std::to_integer<std::uint8_t>(value);
-    m_registers.at(regIndex) = std::byte{additionRes};
+    m_addressRegister = value;
+    DiscardAnalysisOfState();
 }
 
-void CHIP8::VirtualMachine::EightPrefixInstructions(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::SetProgramCounter(std::uint16_t value)
 {
-    const auto [firstRegIndex, secondRegIndex] = decodedOpcode.GetRegIndices();
-    auto& firstReg = m_registers.at(firstRegIndex);
-    auto& secondReg = m_registers.at(secondRegIndex);
+    m_programCounter = value;
+    DiscardAnalysisOfState();
+}
 
-    switch (decodedOpcode.nibbles.front()) 
+void CHIP8::VirtualMachine::DiscardAnalysisOfState()
+{
+    //the analysis only covers the states reachable from where the program started, not one set from outside;
+    //once discarded, setting the rest of the registers does not translate everything again
+    if (not m_analysis.code.empty())
     {
-        //Vx = Vy
-        case 0:
-            firstReg = secondReg;
-            break;
+        DiscardAnalysis();
+    }
+}
 
-        //Vx = Vx OR Vy
-        case 1:
-            firstReg |= secondReg;
-            break;
+void CHIP8::VirtualMachine::ClearDisplay()
+{
+    m_displayMemory.Clear(m_planeMask);
+}
 
-        //Vx = Vx AND Vy
-        case 2:
-            firstReg &= secondReg;
-            break;
+void CHIP8::VirtualMachine::OnFrame(const boost::system::error_code& errc)
+{
+    //the sleep while Fx0A waits ends by cancelling the wait
+    if ((errc and errc != asio::error::operation_aborted) or m_state == State::Shutdown)
+    {
+        m_ioCtx->stop();
+        return;
+    }
+    //a wait cancelled by Pause is over for good, Resume schedules a new one
+    if (m_paused or (errc == asio::error::operation_aborted and not m_sleeping))
+    {
+        return;
+    }
 
-        //Vx = Vx XOR Vy
-        case 3:
-            firstReg ^= secondReg;
-            break;
+    const auto now = asio::steady_timer::clock_type::now();
+    if (std::exchange(m_sleeping, false) and m_nextFrame <= now)
+    {
+        const auto skippedFrames = static_cast<std::size_t>((now - m_nextFrame) / FRAME_PERIOD);
+        SkipIdleFrames(skippedFrames);
+        m_nextFrame += skippedFrames * FRAME_PERIOD;
+    }
 
-        //Vx = Vx + Vy, VF = 1 if overflow, 0 otherwise
-        case 4:
+    //a late wakeup runs every frame which became due in the meantime
+    unsigned frame {0};
+    for (; frame < MAX_CATCH_UP_FRAMES and m_nextFrame <= now; ++frame)
+    {
+        std::exception_ptr failure;
+        try
         {
-            auto result = std::to_integer<std::uint16_t>(firstReg);
-            result += std::to_integer<std::uint16_t>(secondReg);
-            firstReg = std::byte {static_cast<std::uint8_t>(result & 0xFF)};
-            m_registers.at(0xF) = result > std::numeric_limits<std::uint8_t>::max() ? std::byte {1} : std::byte {0};
-        }
-            break;
-        
-        //Vx = Vx - Vy, VF = 1 if no borrow, 0 otherwise
-        case 5:
-        {
-            const auto carry = firstReg >= secondReg ? std::byte {1} : std::byte {0};
-            auto result = std::to_integer<std::uint8_t>(firstReg);
-            result -= std::to_integer<std::uint8_t>(secondReg);
-            firstReg = std::byte {result};
-            m_registers.at(0xF) = carry;
+            RunFrame();
         }
-            break;
-
-        //Vx = Vx >> 1, VF = least significant bit of Vx before shift
-        case 6:
+        catch (...)
         {
-            const auto carry = firstReg & std::byte {1};
-            firstReg >>= 1;
-            m_registers.at(0xF) = carry;
+            //without a debugger the failure ends Run
+            if (not m_debugState)
+            {
+                throw;
+            }
+            failure = std::current_exception();
         }
-            break;
+        m_nextFrame += FRAME_PERIOD;
 
-        //Vx = Vy - Vx, VF = 1 if no borrow, 0 otherwise
-        case 7:
+        //the debugger takes over until it resumes the program, which finishes the frame first
+        if (m_debugState and (failure or m_debugState->stop.reason != DebugStopReason::None))
         {
-            auto result = std::to_integer<std::uint8_t>(secondReg);
-            result -= std::to_integer<std::uint8_t>(firstReg);
-            firstReg = std::byte {result};
-            m_registers.at(0xF) = secondReg > firstReg ? std::byte {1} : std::byte {0};
+            Pause();
+            if (m_debugState->onStop)
+            {
+                m_debugState->onStop(failure);
+            }
+            return;
         }
-            break;
+    }
+    //too far behind, continue from now instead of speeding up to catch up
+    if (m_nextFrame <= now)
+    {
+        m_nextFrame = now + FRAME_PERIOD;
+    }
 
-        //Vx = Vx << 1, VF = most significant bit of Vx before shift
-        case 0xE:
+    //the program would only look at the same keys again, sleep until they change unless a tone
+    //still has to be played out; a wakeup before the next frame was due still has to run that frame
+    if (frame > 0 and m_keyWaitPeriod != 0 and not m_rewinding and m_soundTimer.GetValue(m_frame) == 0)
+    {
+        if (m_audioSink)
         {
-            const auto carry = (firstReg & std::byte {0b1000'0000}) >> 7;
-            firstReg <<= 1;
-            m_registers.at(0xF) = carry;
+            m_audioSink->Pause();
         }
-            break;
+        m_sleeping = true;
+        m_frameTimer->expires_at(asio::steady_timer::time_point::max());
+        m_frameTimer->async_wait(std::bind(&CHIP8::VirtualMachine::OnFrame, this, std::placeholders::_1));
+        return;
     }
+
+    ScheduleNextFrame();
 }
 
-void CHIP8::VirtualMachine::SkipOnRegsNotEqual(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::SkipIdleFrames(std::size_t frameCount)
 {
-    const auto [firstRegIndex, secondRegIndex] = decodedOpcode.GetRegIndices();
-    const auto& firstReg = m_registers.at(firstRegIndex);
-    const auto& secondReg = m_registers.at(secondRegIndex);
-
-    if (firstReg != secondReg)
+    m_keyboard->SkipFrames(frameCount);
+    m_frame += frameCount;
+    if (m_audioSink)
     {
-        SkipNextInstruction();
+        m_audioSink->SkipSilence(CountFrameSamples(frameCount));
     }
+
+    //the frames would only have moved the program counter around the loop, by their instructions modulo its length
+    const auto budget = frameCount * m_clockSpeed + m_clockRemainder;
+    m_clockRemainder = budget % FRAME_RATE;
+    Execute(budget / FRAME_RATE % m_keyWaitPeriod);
 }
 
-void CHIP8::VirtualMachine::SetAddressReg(const DecodedOpcode& decodedOpcode)
+std::size_t CHIP8::VirtualMachine::CountFrameSamples(std::size_t frameCount)
 {
-    m_addressRegister = decodedOpcode.GetAddress();
+    const auto samples = frameCount * m_audioSink->GetSampleRate() + m_sampleRemainder;
+    m_sampleRemainder = samples % FRAME_RATE;
+    return samples / FRAME_RATE;
 }
 
-void CHIP8::VirtualMachine::JumpWithOffset(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::PlayFrameSound(bool playing)
 {
-    m_programCounter = decodedOpcode.GetAddress() + std::to_integer<std::uint16_t>(m_registers.at(0));
+    if (not m_audioSink)
+    {
+        return;
+    }
+    m_frameSamples.resize(CountFrameSamples(1));
+    m_beeper.Synthesize(playing, m_frameSamples);
+    m_audioSink->Write(m_frameSamples);
 }
 
-void CHIP8::VirtualMachine::AndWithRandom(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::WakeUp()
 {
-    const auto randByte = std::byte {m_randomByteSrc()};
-    const auto value = decodedOpcode.GetValue();
-    const auto [regIndex, _] = decodedOpcode.GetRegIndices();
-    m_registers.at(regIndex) = randByte & value;
+    std::lock_guard lock {m_ioCtxMtx};
+    if (m_ioCtx)
+    {
+        asio::post(*m_ioCtx, [this]
+        {
+            //no frame may be scheduled while paused, Run ends right away
+            if (m_state == State::Shutdown)
+            {
+                m_ioCtx->stop();
+            }
+            else if (m_sleeping)
+            {
+                m_frameTimer->cancel();
+            }
+        });
+    }
 }
 
-void CHIP8::VirtualMachine::Draw(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::ScheduleNextFrame()
 {
-    const auto [firstRegIndex, secondRegIndex] = decodedOpcode.GetRegIndices();
-    const auto x = std::to_integer<std::uint8_t>(m_registers.at(firstRegIndex));
-    const auto y = std::to_integer<std::uint8_t>(m_registers.at(secondRegIndex));
-    const auto spriteSize = decodedOpcode.nibbles.front();
-    const auto sprite = std::span {std::begin(m_memory) + m_addressRegister, spriteSize};
-    DrawSprite(x, y, sprite);
+    //deadlines are absolute so the time spent executing a frame does not accumulate as drift
+    m_frameTimer->expires_at(m_nextFrame);
+    m_frameTimer->async_wait(std::bind(&CHIP8::VirtualMachine::OnFrame, this, std::placeholders::_1));
 }
 
-void CHIP8::VirtualMachine::SkipOnKeyState(const DecodedOpcode& decodedOpcode)
+void CHIP8::VirtualMachine::RunFrame()
 {
-    const auto [regIndex, _] = decodedOpcode.GetRegIndices();
-    const auto operationCode = decodedOpcode.GetValue();
-    const auto keyCode = std::to_integer<std::uint8_t>(m_registers.at(regIndex));
-    
-    if (operationCode == std::byte {0x9E} and m_keyboard.IsKeyPressed(CHIP8::Key{keyCode}))
+    if (m_rewindBuffer and m_rewinding)
     {
-        SkipNextInstruction();
+        StepBack();
+        PlayFrameSound(false);
         return;
     }
 
-    if (operationCode == std::byte {0xA1} and not m_keyboard.IsKeyPressed(CHIP8::Key{keyCode}))
+    //a frame a debugger stopped in is finished first, with the keys it began with
+    if (m_unfinishedFrameInstructions == 0)
+    {
+        m_keyboard->BeginFrame();
+        const auto budget = m_clockSpeed + m_clockRemainder;
+        m_unfinishedFrameInstructions = budget / FRAME_RATE;
+        m_clockRemainder = budget % FRAME_RATE;
+    }
+    m_unfinishedFrameInstructions -= Execute(m_unfinishedFrameInstructions);
+    if (m_unfinishedFrameInstructions > 0)
     {
-        SkipNextInstruction();
         return;
     }
+    //the tone sounds for as many frames as the sound timer was set to
+    PlayFrameSound(m_soundTimer.GetValue(m_frame) > 0);
+    //counts both timers down
+    m_frame += 1;
+
+    if (m_rewindBuffer)
+    {
+        CaptureSnapshot(m_rewindBuffer->BeginCapture());
+        m_rewindBuffer->EndCapture();
+    }
 }
 
-void CHIP8::VirtualMachine::FPrefixInstructions(const DecodedOpcode& decodedOpcode)
+std::size_t CHIP8::VirtualMachine::ExecuteNextInstruction()
 {
-    const auto [regIndex, _] = decodedOpcode.GetRegIndices();
-    const auto operationCode = std::to_integer<std::uint8_t>(decodedOpcode.GetValue());
-
-    switch(operationCode)
+    //the cached entry already holds the final handler and its operands,
+    //addresses which have not been decoded yet point to PredecodeAndExecute
+    const auto& instruction = m_instructionCache[m_programCounter];
+    if constexpr (Profiler::ENABLED)
     {
-        //Vx = delay timer
-        case 0x07:
-            m_registers.at(regIndex) = std::byte{m_delayTimer.GetValue()};
-            break;
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountExecution(m_programCounter, FetchInstruction(m_programCounter));
+        }
+    }
+    const auto address = m_programCounter;
+    //copied first, a handler writing to memory may reset the entry, even all of them when the analysis is discarded;
+    //entries which are not predecoded yet hold opcode 0, decode the opcode the handler is about to see
+    auto operands = instruction.operands;
+    const auto fusedOperands = instruction.fusedOperands;
+    if (operands.opcode == 0)
+    {
+        operands = DecodedOpcode {FetchInstruction(address)};
+    }
+    instruction.handler(*this, instruction);
+    TraceInstruction(address, operands, fusedOperands);
+    //increase value of program counter
+    m_programCounter += INSTRUCTION_WIDTH;
+    return 1;
+}
 
-        //wait for a key to be pressed and store the key code in Vx 
-        case 0x0A:
+std::size_t CHIP8::VirtualMachine::ExecuteNextBlock()
+{
+    auto block = m_blockCache.Find(m_programCounter);
+    if (block == nullptr)
+    {
+        block = &m_blockCache.Insert(TranslateBlock(m_programCounter));
+        if (not block->code.empty() and (block->code.back().operands.opcode >> 12) == 0x1)
         {
-            const auto pressedKey = static_cast<std::uint8_t>(m_keyboard.WaitForKeyPress());
-            m_registers.at(regIndex) = std::byte{pressedKey};
+            DetectIdleLoop(block->end - INSTRUCTION_WIDTH, block->code.back().operands);
         }
-            break;
-        
-        //delay timer = Vx
-        case 0x15:
-            m_delayTimer.Set(std::to_integer<std::uint8_t>(m_registers.at(regIndex)));
-            break;
-        
-        //sound timer = Vx
-        case 0x18:
-            m_soundTimer.Set(std::to_integer<std::uint8_t>(m_registers.at(regIndex)));
-            break;
+    }
 
-        //I = I + Vx
-        case 0x1E:
-            m_addressRegister += std::to_integer<std::uint16_t>(m_registers.at(regIndex));
-            break;
+    //nothing could be translated at the end of memory, let the interpreter report it
+    if (block->code.empty())
+    {
+        return ExecuteNextInstruction();
+    }
 
-        //I = memory location of digit Vx
-        case 0x29:
+    if (m_executionEngine == ExecutionEngine::Jit)
+    {
+        if (block->native == nullptr and ++block->executionCount == HOT_BLOCK_THRESHOLD)
         {
-            const auto digit = std::to_integer<std::uint16_t>(m_registers.at(regIndex));
-            const auto digitAddressStart = FONT_ADDRESS_START + digit * HEX_DIGIT_SPRITE_SIZE;
-            m_addressRegister = digitAddressStart;
+            CompileBlock(*block);
         }
-            break;
 
-        //store BCD of Vx in memory
-        case 0x33:
+        if (block->native != nullptr)
         {
-            const auto bcd = ToBCD(std::to_integer<std::uint8_t>(m_registers.at(regIndex)));
-            std::ranges::copy(bcd, std::begin(m_memory) + m_addressRegister);
+            //instructions translated to machine code are not recorded, only the instructions calling their handlers are
+            const auto& entry = block->code.front().operands;
+            m_trace.Record(TraceEntry {m_programCounter, entry.opcode, m_addressRegister, 
+                std::to_integer<std::uint8_t>(m_registers[entry.x]), TraceEvent::EnteredBlock});
+            block->native();
+            if (m_nativeException)
+            {
+                std::rethrow_exception(std::exchange(m_nativeException, nullptr));
+            }
+            return block->instructionCount;
         }
-            break;
-        
-        //store registers from 0 to x in memory
-        case 0x55:
-            std::copy(std::begin(m_registers), std::begin(m_registers) + regIndex + 1, 
-                std::begin(m_memory) + m_addressRegister);
-            break;
-        
-        //read registers from 0 to x from memory
-        case 0x65:
-            std::copy(std::begin(m_memory) + m_addressRegister, std::begin(m_memory) + m_addressRegister + regIndex + 1, 
-                std::begin(m_registers));
-            break;
     }
+
+    for (const auto& instruction : block->code)
+    {
+        const auto address = m_programCounter;
+        instruction.handler(*this, instruction);
+        //translated code stays alive until the next lookup, even if the handler invalidates its block
+        TraceInstruction(address, instruction.operands, instruction.fusedOperands);
+        m_programCounter += INSTRUCTION_WIDTH;
+    }
+    return block->instructionCount;
+}
+
+void CHIP8::VirtualMachine::CompileBlock(BasicBlock& block)
+{
+    block.native = m_jit->Compile(block, GetQuirks(m_quirkProfile));
+    if (block.native == nullptr)
+    {
+        //the code buffer is full, start over; retired blocks stay alive until the next lookup,
+        //so this one still runs as threaded code
+        m_blockCache.Clear();
+        m_jit->Reset();
+    }
+}
+
+std::uint32_t CHIP8::VirtualMachine::CallFromNative(VirtualMachine& vm, const PredecodedInstruction& instruction) noexcept
+{
+    try
+    {
+        //compiled code stores the program counter before every call
+        const auto address = vm.m_programCounter;
+        instruction.handler(vm, instruction);
+        vm.TraceInstruction(address, instruction.operands, instruction.fusedOperands);
+        return 0;
+    }
+    catch (...)
+    {
+        vm.m_nativeException = std::current_exception();
+        return 1;
+    }
+}
+
+std::uint16_t CHIP8::VirtualMachine::FetchInstruction(std::uint16_t address) const
+{
+    if (address + 1U >= m_memory.size())
+    {
+        throw std::runtime_error(std::format("Program counter {:04X} is outside of memory", address));
+    }
+    //read first and second bytes which the address points to
+    const auto mostSignificatByte = std::to_integer<std::uint16_t>(m_memory[address]);
+    const auto leastSignificantByte = std::to_integer<std::uint16_t>(m_memory[address + 1]);
+    //compose opcode value from these bytes
+    const std::uint16_t opcodeValue = (mostSignificatByte << 8) | leastSignificantByte;
+    return opcodeValue;
+}
+
+CHIP8::BasicBlock CHIP8::VirtualMachine::TranslateBlock(std::uint16_t entry) const
+{
+    BasicBlock block {entry, entry, INSTRUCTION_WIDTH, 0, {}, 0, nullptr};
+
+    //the end of a block must stay addressable, the last instructions of memory are left to the interpreter
+    std::size_t address = entry;
+    while (address + 1 < m_memory.size() and block.instructionCount < MAX_BLOCK_LENGTH)
+    {
+        const auto opcode = FetchInstruction(static_cast<std::uint16_t>(address));
+        const auto width = IsLongInstruction(opcode) ? 2 * INSTRUCTION_WIDTH : INSTRUCTION_WIDTH;
+        if (address + width >= m_memory.size())
+        {
+            break;
+        }
+
+        const auto instruction = PredecodedInstruction {SelectHandler(static_cast<std::uint16_t>(address), opcode), DecodedOpcode {opcode}, DecodedOpcode {}};
+        if (block.code.empty() or not TryFuse(block.code.back(), instruction))
+        {
+            block.code.push_back(instruction);
+        }
+        block.instructionCount += 1;
+        address += width;
+
+        if (EndsBasicBlock(opcode))
+        {
+            break;
+        }
+    }
+
+    block.end = static_cast<std::uint16_t>(address);
+    if (address + 1 < m_memory.size() and IsLongInstruction(FetchInstruction(block.end)))
+    {
+        block.skipWidth = 2 * INSTRUCTION_WIDTH;
+    }
+    return block;
+}
+
+bool CHIP8::VirtualMachine::EndsBasicBlock(std::uint16_t opcode)
+{
+    const auto decodedOpcode = DecodedOpcode {opcode};
+    switch (opcode >> 12)
+    {
+        //return from subroutine and exit, which waits like Fx0A
+        case 0x0: return opcode == 0x00EE or opcode == 0x00FD;
+        //jumps and calls
+        case 0x1: case 0x2: case 0xB: return true;
+        //skips, 5xy2 and 5xy3 end blocks as well, 5xy2 writes to memory
+        case 0x3: case 0x4: case 0x5: case 0x9: case 0xE: return true;
+        //waiting for a key and writes to memory, which may modify the block itself
+        case 0xF: return decodedOpcode.nn == 0x0A or decodedOpcode.nn == 0x33 or decodedOpcode.nn == 0x55;
+        default: return false;
+    }
+}
+
+bool CHIP8::VirtualMachine::TryFuse(PredecodedInstruction& previous, const PredecodedInstruction& next) const
+{
+    //superinstructions are never fused again, and checked instructions keep their check
+    if (previous.handler != (*m_instructionTable)[previous.operands.opcode] or next.handler != (*m_instructionTable)[next.operands.opcode])
+    {
+        return false;
+    }
+
+    const auto& first = previous.operands;
+    const auto& second = next.operands;
+
+    if ((first.opcode & 0xF000) == 0x6000 and (second.opcode & 0xF000) == 0xD000)
+    {
+        previous = PredecodedInstruction {m_setRegAndDraw, first, second};
+        return true;
+    }
+
+    if ((first.opcode & 0xF0FF) == 0xF007 and (second.opcode & 0xF0FF) == 0x3000 and first.x == second.x)
+    {
+        previous = PredecodedInstruction {&InvokeSuperinstruction<&CHIP8::VirtualMachine::LoadDelayTimerAndSkipIfZero>, first, second};
+        return true;
+    }
+
+    return false;
+}
+
+void CHIP8::VirtualMachine::InvalidateInstructionCache(std::size_t address, std::size_t length)
+{
+    //overwritten code may reach states the analysis never considered, nothing it proved holds any longer
+    const auto& analyzedCode = m_analysis.code;
+    if (not analyzedCode.empty() and 
+        std::any_of(analyzedCode.begin() + address, analyzedCode.begin() + std::min<std::size_t>(address + length, m_memory.size()), std::identity {}))
+    {
+        DiscardAnalysis();
+        return;
+    }
+
+    //a block ending right before the written range knows the width of the instruction its skip jumps over
+    const auto blockStart = address - std::min<std::size_t>(address, INSTRUCTION_WIDTH);
+    m_blockCache.Invalidate(blockStart, address + length - blockStart);
+
+    //an instruction starting one byte before the written range overlaps it as well
+    const auto first = address > 0 ? address - 1 : address;
+    const auto last = std::min<std::size_t>(address + length, m_memory.size());
+    for (const auto cacheIndex : std::views::iota(first, last))
+    {
+        m_instructionCache[cacheIndex] = PredecodedInstruction {&Invoke<&CHIP8::VirtualMachine::PredecodeAndExecute>, DecodedOpcode {}, DecodedOpcode {}};
+    }
+
+    //so do idle loops starting a whole loop before it, they are detected again once their jump is predecoded
+    const auto firstLoopEntry = first - std::min<std::size_t>(first, (MAX_IDLE_LOOP_LENGTH + 1) * INSTRUCTION_WIDTH);
+    std::fill(std::begin(m_idleLoops) + firstLoopEntry, std::begin(m_idleLoops) + last, IdleLoop::None);
+}
+
+CHIP8::Instruction CHIP8::VirtualMachine::SelectHandler(std::uint16_t address, std::uint16_t opcode) const
+{
+    const auto handler = (*m_instructionTable)[opcode];
+    const auto provenInBounds = not m_analysis.inBounds.empty() and m_analysis.inBounds[address];
+    if (provenInBounds or GetMemoryAccessLength(opcode, Framebuffer::PLANES) == 0)
+    {
+        return handler;
+    }
+    return &InvokeChecked;
+}
+
+void CHIP8::VirtualMachine::InvokeChecked(VirtualMachine& vm, const PredecodedInstruction& instruction)
+{
+    vm.CheckMemoryAccess(instruction.operands);
+    (*vm.m_instructionTable)[instruction.operands.opcode](vm, instruction);
+}
+
+void CHIP8::VirtualMachine::CheckMemoryAccess(const DecodedOpcode& decodedOpcode) const
+{
+    const auto planeCount = static_cast<unsigned>(std::popcount(m_planeMask & ((1U << Framebuffer::PLANES) - 1)));
+    const auto length = GetMemoryAccessLength(decodedOpcode.opcode, planeCount);
+    if (m_addressRegister + length > m_memory.size())
+    {
+        throw std::runtime_error(std::format("Instruction {:04X} at {:04X} accesses {} bytes at I = {:04X}, past the end of memory", 
+            decodedOpcode.opcode, m_programCounter, length, m_addressRegister));
+    }
+}
+
+void CHIP8::VirtualMachine::DetectIdleLoop(std::uint16_t jumpAddress, const DecodedOpcode& jump)
+{
+    const auto entry = jump.nnn;
+    if (entry > jumpAddress)
+    {
+        return;
+    }
+    const unsigned bodySize = jumpAddress - entry;
+    if (bodySize > MAX_IDLE_LOOP_LENGTH * INSTRUCTION_WIDTH or bodySize % INSTRUCTION_WIDTH != 0)
+    {
+        return;
+    }
+
+    //every instruction of the body may only compute registers, skipping over the jump is the only way out
+    auto idleLoop = IdleLoop::KeyChange;
+    for (auto address = entry; address < jumpAddress; address += INSTRUCTION_WIDTH)
+    {
+        const auto operands = DecodedOpcode {FetchInstruction(address)};
+        switch (operands.opcode >> 12)
+        {
+            case 0x0: 
+                if ((*m_instructionTable)[operands.opcode] != &Invoke<&CHIP8::VirtualMachine::NoOperation>)
+                {
+                    return;
+                }
+                break;
+            case 0x5:
+                if (operands.n == 0x2)
+                {
+                    return;
+                }
+                break;
+            case 0x3: case 0x4: case 0x6: case 0x7: case 0x9: case 0xA: 
+                break;
+            case 0x8: 
+                if (operands.n > 0x7 and operands.n != 0xE)
+                {
+                    return;
+                }
+                break;
+            case 0xE: 
+                if (operands.nn != 0x9E and operands.nn != 0xA1)
+                {
+                    return;
+                }
+                break;
+            case 0xF:
+                if (operands.nn == 0x07)
+                {
+                    idleLoop = IdleLoop::NextFrame;
+                }
+                else if (operands.nn != 0x1E and operands.nn != 0x29 and operands.nn != 0x30 and operands.nn != 0x65)
+                {
+                    return;
+                }
+                break;
+            default: 
+                return;
+        }
+    }
+    m_idleLoops[entry] = idleLoop;
+}
+
+std::size_t CHIP8::VirtualMachine::FastForwardIdleLoop(std::size_t executedInstructions, std::size_t instructionCount)
+{
+    const auto& previousVisit = m_lastIdleLoopVisit;
+    if (previousVisit.has_value() and previousVisit->entry == m_programCounter and 
+        previousVisit->registers == m_registers and previousVisit->addressRegister == m_addressRegister)
+    {
+        //the keys and timers do not change within a batch, so the remaining iterations would all be the same
+        const auto period = executedInstructions - previousVisit->executedInstructions;
+        executedInstructions += (instructionCount - executedInstructions) / period * period;
+        if (m_idleLoops[m_programCounter] == IdleLoop::KeyChange)
+        {
+            m_keyWaitPeriod = period;
+        }
+    }
+    const auto jumpAddress = previousVisit.has_value() and previousVisit->entry == m_programCounter ? 
+        previousVisit->jumpAddress : FindIdleLoopJump(m_programCounter);
+    m_lastIdleLoopVisit = IdleLoopVisit {m_programCounter, jumpAddress, m_registers, m_addressRegister, executedInstructions};
+    return executedInstructions;
+}
+
+std::uint16_t CHIP8::VirtualMachine::FindIdleLoopJump(std::uint16_t entry) const
+{
+    const auto closingJump = static_cast<std::uint16_t>(0x1000 | entry);
+    const auto last = std::min<std::size_t>(entry + MAX_IDLE_LOOP_LENGTH * INSTRUCTION_WIDTH, m_memory.size() - INSTRUCTION_WIDTH);
+    for (std::size_t address = entry; address <= last; address += INSTRUCTION_WIDTH)
+    {
+        if (FetchInstruction(static_cast<std::uint16_t>(address)) == closingJump)
+        {
+            return static_cast<std::uint16_t>(address);
+        }
+    }
+    //not closed any longer, a loop of the entry alone is left as soon as the program counter moves
+    return entry;
+}
+
+void CHIP8::VirtualMachine::CheckWatchpoints(std::size_t address, std::size_t length)
+{
+    const auto end = std::min<std::size_t>(address + length, m_memory.size());
+    for (auto writtenAddress = address; writtenAddress < end; ++writtenAddress)
+    {
+        if (m_debugState->watchpoints[writtenAddress])
+        {
+            m_debugState->stop = DebugStop {DebugStopReason::Watchpoint, static_cast<std::uint16_t>(writtenAddress)};
+            return;
+        }
+    }
+}
+
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+const CHIP8::VirtualMachine::InstructionTable& CHIP8::VirtualMachine::GetInstructionTable()
+{
+    //one table per profile and edge mode, built the first time a VM selects it
+    static const auto instructionTable = []
+    {
+        auto table = std::make_unique<InstructionTable>();
+        for (const auto opcode : std::views::iota(0UZ, table->size()))
+        {
+            (*table)[opcode] = Decode<profile, edgeMode>(static_cast<std::uint16_t>(opcode));
+        }
+        return table;
+    }();
+    return *instructionTable;
+}
+
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::SelectHandlers()
+{
+    constexpr auto wrap = Framebuffer::EdgeMode::Wrap, clip = Framebuffer::EdgeMode::Clip;
+    if (m_spriteEdgeMode.value_or(GetQuirks(profile).spriteEdgeMode) == wrap)
+    {
+        m_instructionTable = &GetInstructionTable<profile, wrap>();
+        m_setRegAndDraw = &InvokeSuperinstruction<&CHIP8::VirtualMachine::SetRegAndDraw<profile, wrap>>;
+    }
+    else
+    {
+        m_instructionTable = &GetInstructionTable<profile, clip>();
+        m_setRegAndDraw = &InvokeSuperinstruction<&CHIP8::VirtualMachine::SetRegAndDraw<profile, clip>>;
+    }
+}
+
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+CHIP8::Instruction CHIP8::VirtualMachine::Decode(std::uint16_t opcode)
+{
+    const auto decodedOpcode = DecodedOpcode {opcode};
+
+    switch (opcode >> 12)
+    {
+        case 0x0:
+            switch (opcode & 0xFFF0)
+            {
+                case 0x00C0: return &Invoke<&CHIP8::VirtualMachine::ScrollDown>;
+                case 0x00D0: return &Invoke<&CHIP8::VirtualMachine::ScrollUp>;
+            }
+            switch (opcode)
+            {
+                case 0x00E0: return &Invoke<&CHIP8::VirtualMachine::ClearScreen>;
+                case 0x00EE: return &Invoke<&CHIP8::VirtualMachine::Return>;
+                case 0x00FB: return &Invoke<&CHIP8::VirtualMachine::ScrollRight>;
+                case 0x00FC: return &Invoke<&CHIP8::VirtualMachine::ScrollLeft>;
+                case 0x00FD: return &Invoke<&CHIP8::VirtualMachine::Exit>;
+                case 0x00FE: return &Invoke<&CHIP8::VirtualMachine::SetLowResolution>;
+                case 0x00FF: return &Invoke<&CHIP8::VirtualMachine::SetHighResolution>;
+                default: return &Invoke<&CHIP8::VirtualMachine::NoOperation>;
+            }
+        case 0x1: return &Invoke<&CHIP8::VirtualMachine::Jump>;
+        case 0x2: return &Invoke<&CHIP8::VirtualMachine::Call>;
+        case 0x3: return &Invoke<&CHIP8::VirtualMachine::SkipOnRegValEqual>;
+        case 0x4: return &Invoke<&CHIP8::VirtualMachine::SkipOnRegValNotEqual>;
+        case 0x5:
+            switch (decodedOpcode.n)
+            {
+                case 0x2: return &Invoke<&CHIP8::VirtualMachine::StoreRegRange>;
+                case 0x3: return &Invoke<&CHIP8::VirtualMachine::LoadRegRange>;
+                default: return &Invoke<&CHIP8::VirtualMachine::SkipOnRegsEqual>;
+            }
+        case 0x6: return &Invoke<&CHIP8::VirtualMachine::SetReg>;
+        case 0x7: return &Invoke<&CHIP8::VirtualMachine::Add>;
+        case 0x8:
+            switch (decodedOpcode.n)
+            {
+                case 0x0: return &Invoke<&CHIP8::VirtualMachine::CopyReg>;
+                case 0x1: return &Invoke<&CHIP8::VirtualMachine::OrRegs<profile>>;
+                case 0x2: return &Invoke<&CHIP8::VirtualMachine::AndRegs<profile>>;
+                case 0x3: return &Invoke<&CHIP8::VirtualMachine::XorRegs<profile>>;
+                case 0x4: return &Invoke<&CHIP8::VirtualMachine::AddRegs>;
+                case 0x5: return &Invoke<&CHIP8::VirtualMachine::SubtractRegs>;
+                case 0x6: return &Invoke<&CHIP8::VirtualMachine::ShiftRight<profile>>;
+                case 0x7: return &Invoke<&CHIP8::VirtualMachine::SubtractRegsReversed>;
+                case 0xE: return &Invoke<&CHIP8::VirtualMachine::ShiftLeft<profile>>;
+                default: return &Invoke<&CHIP8::VirtualMachine::UnimplementedInstruction>;
+            }
+        case 0x9: return &Invoke<&CHIP8::VirtualMachine::SkipOnRegsNotEqual>;
+        case 0xA: return &Invoke<&CHIP8::VirtualMachine::SetAddressReg>;
+        case 0xB: return &Invoke<&CHIP8::VirtualMachine::JumpWithOffset<profile>>;
+        case 0xC: return &Invoke<&CHIP8::VirtualMachine::AndWithRandom>;
+        case 0xD: return &Invoke<&CHIP8::VirtualMachine::Draw<profile, edgeMode>>;
+        case 0xE:
+            switch (decodedOpcode.nn)
+            {
+                case 0x9E: return &Invoke<&CHIP8::VirtualMachine::SkipOnKeyPressed>;
+                case 0xA1: return &Invoke<&CHIP8::VirtualMachine::SkipOnKeyNotPressed>;
+                default: return &Invoke<&CHIP8::VirtualMachine::UnimplementedInstruction>;
+            }
+        case 0xF:
+            switch (opcode)
+            {
+                case 0xF000: return &Invoke<&CHIP8::VirtualMachine::SetAddressRegLong>;
+                case 0xF002: return &Invoke<&CHIP8::VirtualMachine::LoadAudioPattern>;
+            }
+            switch (decodedOpcode.nn)
+            {
+                case 0x01: return &Invoke<&CHIP8::VirtualMachine::SelectPlanes>;
+                case 0x07: return &Invoke<&CHIP8::VirtualMachine::LoadDelayTimer>;
+                case 0x0A: return &Invoke<&CHIP8::VirtualMachine::WaitForKey>;
+                case 0x15: return &Invoke<&CHIP8::VirtualMachine::SetDelayTimer>;
+                case 0x18: return &Invoke<&CHIP8::VirtualMachine::SetSoundTimer>;
+                case 0x1E: return &Invoke<&CHIP8::VirtualMachine::AddToAddressReg>;
+                case 0x29: return &Invoke<&CHIP8::VirtualMachine::SetAddressRegToDigit>;
+                case 0x30: return &Invoke<&CHIP8::VirtualMachine::SetAddressRegToBigDigit>;
+                case 0x33: return &Invoke<&CHIP8::VirtualMachine::StoreBCD>;
+                case 0x3A: return &Invoke<&CHIP8::VirtualMachine::SetPitch>;
+                case 0x55: return &Invoke<&CHIP8::VirtualMachine::StoreRegs<profile>>;
+                case 0x65: return &Invoke<&CHIP8::VirtualMachine::LoadRegs<profile>>;
+                case 0x75: return &Invoke<&CHIP8::VirtualMachine::StoreFlags>;
+                case 0x85: return &Invoke<&CHIP8::VirtualMachine::LoadFlags>;
+                default: return &Invoke<&CHIP8::VirtualMachine::UnimplementedInstruction>;
+            }
+    }
+
+    return &Invoke<&CHIP8::VirtualMachine::UnimplementedInstruction>;
+}
+
+void CHIP8::VirtualMachine::DrawSprite(std::uint8_t x, std::uint8_t y, std::span<const std::byte> sprite, unsigned spriteWidth, 
+    Framebuffer::EdgeMode edgeMode)
+{
+    const auto erasedPixel = m_displayMemory.DrawSprite(x, y, sprite, edgeMode, spriteWidth, m_planeMask);
+    m_registers[0xF] = erasedPixel ? std::byte {1} : std::byte {0};
+}
+
+void CHIP8::VirtualMachine::PublishDisplay()
+{
+    m_publishedDisplay.GetBackBuffer().Update(m_displayMemory);
+    m_publishedDisplay.Publish();
+    m_publishedGeneration = m_displayMemory.GetGeneration();
+
+    {
+        //without the mutex a renderer between checking the generation and sleeping would miss the wakeup
+        std::lock_guard lock {m_publishedDisplayMtx};
+        m_latestPublishedGeneration = m_publishedGeneration;
+    }
+    m_displayPublished.notify_all();
+}
+
+const CHIP8::VirtualMachine::DisplayMemory& CHIP8::VirtualMachine::GetDisplayMemory()
+{
+    return m_publishedDisplay.GetFrontBuffer();
+}
+
+bool CHIP8::VirtualMachine::WaitForDisplay(Framebuffer::Generation seenGeneration, std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock lock {m_publishedDisplayMtx};
+    return m_displayPublished.wait_until(lock, deadline, [&]
+    {
+        return m_latestPublishedGeneration != seenGeneration;
+    });
+}
+
+void CHIP8::VirtualMachine::Run()
+{
+    auto& ioCtx = GetIoContext();
+    m_state = State::Running;
+    m_sleeping = false;
+    if (not m_paused)
+    {
+        m_nextFrame = asio::steady_timer::clock_type::now() + FRAME_PERIOD;
+        ScheduleNextFrame();
+    }
+    ioCtx.run();
+}
+
+CHIP8::asio::io_context& CHIP8::VirtualMachine::GetIoContext()
+{
+    std::lock_guard lock {m_ioCtxMtx};
+    if (not m_ioCtx)
+    {
+        m_ioCtx = std::make_unique<asio::io_context>();
+        m_frameTimer = std::make_unique<asio::steady_timer>(*m_ioCtx);
+    }
+    return *m_ioCtx;
+}
+
+void CHIP8::VirtualMachine::Pause()
+{
+    if (m_paused)
+    {
+        return;
+    }
+    m_paused = true;
+    //time spent paused is not spent waiting for the keys, the frames are not skipped
+    m_sleeping = false;
+    if (m_frameTimer)
+    {
+        m_frameTimer->cancel();
+    }
+    if (m_audioSink)
+    {
+        m_audioSink->Pause();
+    }
+}
+
+void CHIP8::VirtualMachine::Resume()
+{
+    if (not m_paused)
+    {
+        return;
+    }
+    m_paused = false;
+    //before Run starts, Run schedules the first frame itself
+    if (m_state == State::Running)
+    {
+        m_nextFrame = asio::steady_timer::clock_type::now();
+        ScheduleNextFrame();
+    }
+}
+
+void CHIP8::VirtualMachine::Stop()
+{
+    m_state = State::Shutdown;
+    WakeUp();
+}
+
+void CHIP8::VirtualMachine::SetKeyboard(std::unique_ptr<Keyboard> keyboard)
+{
+    m_keyboard = std::move(keyboard);
+}
+
+void CHIP8::VirtualMachine::SetAudioSink(std::unique_ptr<AudioSink> audioSink)
+{
+    m_audioSink = std::move(audioSink);
+    m_sampleRemainder = 0;
+    if (m_audioSink)
+    {
+        m_beeper.SetSampleRate(m_audioSink->GetSampleRate());
+    }
+}
+
+void CHIP8::VirtualMachine::NotifyKeyboardChanged()
+{
+    WakeUp();
+}
+
+std::size_t CHIP8::VirtualMachine::Execute(std::size_t instructionCount)
+{
+    //the display is complete at the end of a batch, publish it for the renderer
+    const auto publishChangedDisplay = [this]
+    {
+        if (m_displayMemory.GetGeneration() != m_publishedGeneration)
+        {
+            PublishDisplay();
+        }
+    };
+
+    std::size_t executedInstructions {0};
+    if (m_debugState)
+    {
+        m_debugState->stop = DebugStop {DebugStopReason::None, 0};
+    }
+    m_waitingForKey = false;
+    m_keyWaitPeriod = 0;
+    m_lastIdleLoopVisit.reset();
+    try
+    {
+        //read once per batch, without a debugger the loop only tests a register
+        const bool debugging = m_debugState != nullptr;
+        while (executedInstructions < instructionCount and not m_waitingForKey)
+        {
+            //the caches have an entry per address of memory, Bnnn can jump past the 4 KiB most profiles have
+            if (m_programCounter >= m_memory.size())
+            {
+                throw std::runtime_error(std::format("Program counter {:04X} is outside of memory", m_programCounter));
+            }
+            //a whole block may not fit into what is left, finish one instruction at a time,
+            //blocks do not report the instructions they run to the profiler either, nor stop at breakpoints
+            const auto remainingInstructions = instructionCount - executedInstructions;
+            executedInstructions += m_executionEngine == ExecutionEngine::Interpreter or remainingInstructions < MAX_BLOCK_LENGTH or
+                (Profiler::ENABLED and m_profiler != nullptr) or debugging ?
+                ExecuteNextInstruction() :
+                ExecuteNextBlock();
+
+            if (debugging)
+            {
+                if (StopsForDebugger())
+                {
+                    break;
+                }
+            }
+            else
+            {
+                //a skip over the closing jump may run code outside the loop and come back with the same registers,
+                //only iterations which stayed within the loop are known to repeat
+                const auto& visit = m_lastIdleLoopVisit;
+                if (visit.has_value() and (m_programCounter < visit->entry or m_programCounter > visit->jumpAddress))
+                {
+                    m_lastIdleLoopVisit.reset();
+                }
+                if (m_programCounter < m_idleLoops.size() and m_idleLoops[m_programCounter] != IdleLoop::None)
+                {
+                    executedInstructions = FastForwardIdleLoop(executedInstructions, instructionCount);
+                }
+            }
+        }
+    }
+    catch (...)
+    {
+        //the failing instruction never got to record itself, every engine leaves the program counter at it
+        const auto opcode = m_programCounter + 1U < m_memory.size() ? FetchInstruction(m_programCounter) : std::uint16_t {0};
+        m_trace.Record(TraceEntry {m_programCounter, opcode, m_addressRegister, 
+            std::to_integer<std::uint8_t>(m_registers[DecodedOpcode {opcode}.x]), TraceEvent::Failed});
+        //a failing program still shows what it drew up to the failure
+        publishChangedDisplay();
+        throw;
+    }
+
+    //the keys cannot change within the batch, Fx0A would have been executed for the rest of it
+    if (m_waitingForKey)
+    {
+        executedInstructions = instructionCount;
+    }
+    publishChangedDisplay();
+    return executedInstructions;
+}
+
+bool CHIP8::VirtualMachine::StopsForDebugger()
+{
+    //checked after every instruction, so resuming from a breakpoint runs the instruction at it
+    if (m_debugState->stop.reason == DebugStopReason::None and m_debugState->breakpoints[m_programCounter])
+    {
+        m_debugState->stop = DebugStop {DebugStopReason::Breakpoint, m_programCounter};
+    }
+    return m_debugState->stop.reason != DebugStopReason::None;
+}
+
+void CHIP8::VirtualMachine::RunFrames(std::size_t frameCount)
+{
+    for (std::size_t frame {0}; frame < frameCount; ++frame)
+    {
+        RunFrame();
+        if (m_debugState and m_debugState->stop.reason != DebugStopReason::None)
+        {
+            break;
+        }
+    }
+}
+
+void CHIP8::VirtualMachine::SetClockSpeed(std::uint32_t instructionsPerSecond)
+{
+    m_clockSpeed = instructionsPerSecond;
+    m_clockRemainder = 0;
+}
+
+std::span<const std::byte> CHIP8::VirtualMachine::GetRegisters() const
+{
+    return m_registers;
+}
+
+std::uint16_t CHIP8::VirtualMachine::GetAddressRegister() const
+{
+    return m_addressRegister;
+}
+
+std::uint16_t CHIP8::VirtualMachine::GetProgramCounter() const
+{
+    return m_programCounter;
+}
+
+#pragma region Instructions
+
+void CHIP8::VirtualMachine::PredecodeAndExecute(const DecodedOpcode&)
+{
+    const auto opcode = FetchInstruction(m_programCounter);
+    auto& instruction = m_instructionCache[m_programCounter];
+    instruction = PredecodedInstruction {SelectHandler(m_programCounter, opcode), DecodedOpcode {opcode}, DecodedOpcode {}};
+    if ((opcode >> 12) == 0x1)
+    {
+        DetectIdleLoop(m_programCounter, instruction.operands);
+    }
+    instruction.handler(*this, instruction);
+}
+
+void CHIP8::VirtualMachine::UnimplementedInstruction(const DecodedOpcode& decodedOpcode)
+{
+    throw std::runtime_error(std::format("Encountered unimplemented opcode: {:04X}", decodedOpcode.opcode));
+}
+
+void CHIP8::VirtualMachine::NoOperation(const DecodedOpcode&)
+{
+
+}
+
+//scroll the selected planes down by n pixels
+void CHIP8::VirtualMachine::ScrollDown(const DecodedOpcode& decodedOpcode)
+{
+    m_displayMemory.ScrollDown(decodedOpcode.n, m_planeMask);
+}
+
+//scroll the selected planes up by n pixels
+void CHIP8::VirtualMachine::ScrollUp(const DecodedOpcode& decodedOpcode)
+{
+    m_displayMemory.ScrollUp(decodedOpcode.n, m_planeMask);
+}
+
+void CHIP8::VirtualMachine::ClearScreen(const DecodedOpcode&)
+{
+    ClearDisplay();
+}
+
+void CHIP8::VirtualMachine::Return(const DecodedOpcode&)
+{
+    if (m_stack.empty())
+    {
+        throw std::runtime_error(std::format("Return with an empty stack at {:04X}", m_programCounter));
+    }
+    m_programCounter = m_stack.back();
+    m_stack.pop_back();
+}
+
+void CHIP8::VirtualMachine::ScrollRight(const DecodedOpcode&)
+{
+    m_displayMemory.ScrollRight(HORIZONTAL_SCROLL, m_planeMask);
+}
+
+void CHIP8::VirtualMachine::ScrollLeft(const DecodedOpcode&)
+{
+    m_displayMemory.ScrollLeft(HORIZONTAL_SCROLL, m_planeMask);
+}
+
+//the program has ended, it stays at this instruction and the VM sleeps as it does while Fx0A waits
+void CHIP8::VirtualMachine::Exit(const DecodedOpcode&)
+{
+    m_programCounter -= INSTRUCTION_WIDTH;
+    m_waitingForKey = true;
+    m_keyWaitPeriod = 1;
+}
+
+void CHIP8::VirtualMachine::SetLowResolution(const DecodedOpcode&)
+{
+    m_displayMemory.SetResolution(Framebuffer::Resolution::Low);
+}
+
+void CHIP8::VirtualMachine::SetHighResolution(const DecodedOpcode&)
+{
+    m_displayMemory.SetResolution(Framebuffer::Resolution::High);
+}
+
+void CHIP8::VirtualMachine::Call(const DecodedOpcode& decodedOpcode)
+{
+    if (m_stack.size() == STACK_SIZE)
+    {
+        throw std::runtime_error(std::format("Stack overflow at {:04X}", m_programCounter));
+    }
+    m_stack.push_back(m_programCounter);
+    m_programCounter = decodedOpcode.nnn - INSTRUCTION_WIDTH;
+}
+
+void CHIP8::VirtualMachine::Jump(const DecodedOpcode& decodedOpcode)
+{
+    m_programCounter = decodedOpcode.nnn - INSTRUCTION_WIDTH;
+}
+
+void CHIP8::VirtualMachine::SkipNextInstruction()
+{
+    //F000 nnnn is skipped as a whole
+    const auto next = static_cast<std::uint16_t>(m_programCounter + INSTRUCTION_WIDTH);
+    m_programCounter += IsLongInstruction(FetchInstruction(next)) ? 2 * INSTRUCTION_WIDTH : INSTRUCTION_WIDTH;
+}
+
+void CHIP8::VirtualMachine::SkipOnRegValEqual(const DecodedOpcode& decodedOpcode)
+{
+    if (m_registers[decodedOpcode.x] == std::byte {decodedOpcode.nn})
+    {
+        SkipNextInstruction();
+    }
+}
+
+void CHIP8::VirtualMachine::SkipOnRegValNotEqual(const DecodedOpcode& decodedOpcode)
+{
+    if (m_registers[decodedOpcode.x] != std::byte {decodedOpcode.nn})
+    {
+        SkipNextInstruction();
+    }
+}
+
+void CHIP8::VirtualMachine::SkipOnRegsEqual(const DecodedOpcode& decodedOpcode)
+{
+    if (m_registers[decodedOpcode.x] == m_registers[decodedOpcode.y])
+    {
+        SkipNextInstruction();
+    }
+}
+
+//store registers from x to y in memory, in descending order if x > y; I is left as it is
+void CHIP8::VirtualMachine::StoreRegRange(const DecodedOpcode& decodedOpcode)
+{
+    const auto count = std::max(decodedOpcode.x, decodedOpcode.y) - std::min(decodedOpcode.x, decodedOpcode.y) + 1;
+    const auto step = decodedOpcode.x <= decodedOpcode.y ? 1 : -1;
+    if constexpr (Profiler::ENABLED)
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountWrites(m_addressRegister, count);
+        }
+    }
+    for (int index {0}; index < count; ++index)
+    {
+        m_memory[m_addressRegister + index] = m_registers[decodedOpcode.x + index * step];
+    }
+    if (m_debugState)
+    {
+        CheckWatchpoints(m_addressRegister, count);
+    }
+    InvalidateInstructionCache(m_addressRegister, count);
+}
+
+//read registers from x to y from memory, in descending order if x > y; I is left as it is
+void CHIP8::VirtualMachine::LoadRegRange(const DecodedOpcode& decodedOpcode)
+{
+    const auto count = std::max(decodedOpcode.x, decodedOpcode.y) - std::min(decodedOpcode.x, decodedOpcode.y) + 1;
+    const auto step = decodedOpcode.x <= decodedOpcode.y ? 1 : -1;
+    if constexpr (Profiler::ENABLED)
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountReads(m_addressRegister, count);
+        }
+    }
+    for (int index {0}; index < count; ++index)
+    {
+        m_registers[decodedOpcode.x + index * step] = m_memory[m_addressRegister + index];
+    }
+}
+
+void CHIP8::VirtualMachine::SetReg(const DecodedOpcode& decodedOpcode)
+{
+    m_registers[decodedOpcode.x] = std::byte {decodedOpcode.nn};
+}
+
+void CHIP8::VirtualMachine::Add(const DecodedOpcode& decodedOpcode)
+{
+    const std::uint8_t additionRes = std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]) + decodedOpcode.nn;
+    m_registers[decodedOpcode.x] = std::byte {additionRes};
+}
+
+//Vx = Vy
+void CHIP8::VirtualMachine::CopyReg(const DecodedOpcode& decodedOpcode)
+{
+    m_registers[decodedOpcode.x] = m_registers[decodedOpcode.y];
+}
+
+//Vx = Vx OR Vy, the COSMAC VIP leaves VF at 0
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::OrRegs(const DecodedOpcode& decodedOpcode)
+{
+    m_registers[decodedOpcode.x] |= m_registers[decodedOpcode.y];
+    if constexpr (GetQuirks(profile).logicResetsFlag)
+    {
+        m_registers[0xF] = std::byte {0};
+    }
+}
+
+//Vx = Vx AND Vy, the COSMAC VIP leaves VF at 0
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::AndRegs(const DecodedOpcode& decodedOpcode)
+{
+    m_registers[decodedOpcode.x] &= m_registers[decodedOpcode.y];
+    if constexpr (GetQuirks(profile).logicResetsFlag)
+    {
+        m_registers[0xF] = std::byte {0};
+    }
+}
+
+//Vx = Vx XOR Vy, the COSMAC VIP leaves VF at 0
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::XorRegs(const DecodedOpcode& decodedOpcode)
+{
+    m_registers[decodedOpcode.x] ^= m_registers[decodedOpcode.y];
+    if constexpr (GetQuirks(profile).logicResetsFlag)
+    {
+        m_registers[0xF] = std::byte {0};
+    }
+}
+
+//Vx = Vx + Vy, VF = 1 if overflow, 0 otherwise
+void CHIP8::VirtualMachine::AddRegs(const DecodedOpcode& decodedOpcode)
+{
+    auto& firstReg = m_registers[decodedOpcode.x];
+    auto result = std::to_integer<std::uint16_t>(firstReg);
+    result += std::to_integer<std::uint16_t>(m_registers[decodedOpcode.y]);
+    firstReg = std::byte {static_cast<std::uint8_t>(result & 0xFF)};
+    m_registers[0xF] = result > std::numeric_limits<std::uint8_t>::max() ? std::byte {1} : std::byte {0};
+}
+
+//Vx = Vx - Vy, VF = 1 if no borrow, 0 otherwise
+void CHIP8::VirtualMachine::SubtractRegs(const DecodedOpcode& decodedOpcode)
+{
+    auto& firstReg = m_registers[decodedOpcode.x];
+    const auto secondReg = m_registers[decodedOpcode.y];
+    const auto carry = firstReg >= secondReg ? std::byte {1} : std::byte {0};
+    auto result = std::to_integer<std::uint8_t>(firstReg);
+    result -= std::to_integer<std::uint8_t>(secondReg);
+    firstReg = std::byte {result};
+    m_registers[0xF] = carry;
+}
+
+//Vx = Vx >> 1 or Vy >> 1 depending on the profile, VF = least significant bit of the shifted register
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::ShiftRight(const DecodedOpcode& decodedOpcode)
+{
+    const auto source = m_registers[GetQuirks(profile).shiftsVy ? decodedOpcode.y : decodedOpcode.x];
+    m_registers[decodedOpcode.x] = source >> 1;
+    m_registers[0xF] = source & std::byte {1};
+}
+
+//Vx = Vy - Vx, VF = 1 if no borrow, 0 otherwise
+void CHIP8::VirtualMachine::SubtractRegsReversed(const DecodedOpcode& decodedOpcode)
+{
+    auto& firstReg = m_registers[decodedOpcode.x];
+    const auto secondReg = m_registers[decodedOpcode.y];
+    const auto carry = secondReg >= firstReg ? std::byte {1} : std::byte {0};
+    auto result = std::to_integer<std::uint8_t>(secondReg);
+    result -= std::to_integer<std::uint8_t>(firstReg);
+    firstReg = std::byte {result};
+    m_registers[0xF] = carry;
+}
+
+//Vx = Vx << 1 or Vy << 1 depending on the profile, VF = most significant bit of the shifted register
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::ShiftLeft(const DecodedOpcode& decodedOpcode)
+{
+    const auto source = m_registers[GetQuirks(profile).shiftsVy ? decodedOpcode.y : decodedOpcode.x];
+    m_registers[decodedOpcode.x] = source << 1;
+    m_registers[0xF] = (source & std::byte {0b1000'0000}) >> 7;
+}
+
+void CHIP8::VirtualMachine::SkipOnRegsNotEqual(const DecodedOpcode& decodedOpcode)
+{
+    if (m_registers[decodedOpcode.x] != m_registers[decodedOpcode.y])
+    {
+        SkipNextInstruction();
+    }
+}
+
+void CHIP8::VirtualMachine::SetAddressReg(const DecodedOpcode& decodedOpcode)
+{
+    m_addressRegister = decodedOpcode.nnn;
+}
+
+//CHIP-48 and SUPER-CHIP read Bnnn as Bxnn and add Vx instead of V0
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::JumpWithOffset(const DecodedOpcode& decodedOpcode)
+{
+    const auto offsetRegister = GetQuirks(profile).jumpsWithVx ? decodedOpcode.x : 0;
+    m_programCounter = decodedOpcode.nnn + std::to_integer<std::uint16_t>(m_registers[offsetRegister]) - INSTRUCTION_WIDTH;
+}
+
+void CHIP8::VirtualMachine::AndWithRandom(const DecodedOpcode& decodedOpcode)
+{
+    const auto randByte = std::byte {m_randomByteSrc()};
+    m_registers[decodedOpcode.x] = randByte & std::byte {decodedOpcode.nn};
+}
+
+//Dxy0 draws a 16x16 sprite, every selected plane takes its own rows of the sprite one after another
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+void CHIP8::VirtualMachine::Draw(const DecodedOpcode& decodedOpcode)
+{
+    const auto x = std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]);
+    const auto y = std::to_integer<std::uint8_t>(m_registers[decodedOpcode.y]);
+    const auto spriteWidth = decodedOpcode.n == 0 ? 16U : 8U;
+    const auto spriteHeight = decodedOpcode.n == 0 ? 16U : decodedOpcode.n;
+    const auto planeCount = static_cast<unsigned>(std::popcount(m_planeMask & ((1U << Framebuffer::PLANES) - 1)));
+    const auto sprite = std::span {std::begin(m_memory) + m_addressRegister, spriteHeight * spriteWidth / 8 * planeCount};
+    if constexpr (Profiler::ENABLED)
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountReads(m_addressRegister, sprite.size());
+        }
+    }
+    DrawSprite(x, y, sprite, spriteWidth, edgeMode);
+}
+
+void CHIP8::VirtualMachine::SkipOnKeyPressed(const DecodedOpcode& decodedOpcode)
+{
+    const auto keyCode = std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]);
+    if (keyCode < Keyboard::KEYS and ((m_keyboard->GetPressedKeys() >> keyCode) & 1) != 0)
+    {
+        SkipNextInstruction();
+    }
+}
+
+void CHIP8::VirtualMachine::SkipOnKeyNotPressed(const DecodedOpcode& decodedOpcode)
+{
+    const auto keyCode = std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]);
+    if (keyCode >= Keyboard::KEYS or ((m_keyboard->GetPressedKeys() >> keyCode) & 1) == 0)
+    {
+        SkipNextInstruction();
+    }
+}
+
+//I = the address in the word after the opcode, which is skipped
+void CHIP8::VirtualMachine::SetAddressRegLong(const DecodedOpcode&)
+{
+    m_programCounter += INSTRUCTION_WIDTH;
+    m_addressRegister = FetchInstruction(m_programCounter);
+}
+
+//draw, scroll and clear the planes selected by the bits of n
+void CHIP8::VirtualMachine::SelectPlanes(const DecodedOpcode& decodedOpcode)
+{
+    m_planeMask = decodedOpcode.x & ((1U << Framebuffer::PLANES) - 1);
+}
+
+//load the 16 bytes at I as the pattern of the tone
+void CHIP8::VirtualMachine::LoadAudioPattern(const DecodedOpcode&)
+{
+    Beeper::Pattern pattern;
+    if constexpr (Profiler::ENABLED)
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountReads(m_addressRegister, pattern.size());
+        }
+    }
+    std::copy_n(std::begin(m_memory) + m_addressRegister, pattern.size(), pattern.begin());
+    m_beeper.SetPattern(pattern);
+}
+
+//Vx = delay timer
+void CHIP8::VirtualMachine::LoadDelayTimer(const DecodedOpcode& decodedOpcode)
+{
+    m_registers[decodedOpcode.x] = std::byte {m_delayTimer.GetValue(m_frame)};
+}
+
+//wait for a key to be pressed and released and store the key code in Vx, as the COSMAC VIP does;
+//the instruction is executed again until then, which ends the batch so the VM thread can sleep
+void CHIP8::VirtualMachine::WaitForKey(const DecodedOpcode& decodedOpcode)
+{
+    const auto pressedKeys = m_keyboard->GetPressedKeys();
+    if (m_awaitedKey == NO_AWAITED_KEY and pressedKeys != 0)
+    {
+        m_awaitedKey = static_cast<std::uint8_t>(std::countr_zero(pressedKeys));
+    }
+    if (m_awaitedKey == NO_AWAITED_KEY or ((pressedKeys >> m_awaitedKey) & 1) != 0)
+    {
+        m_programCounter -= INSTRUCTION_WIDTH;
+        m_waitingForKey = true;
+        m_keyWaitPeriod = 1;
+        return;
+    }
+    m_registers[decodedOpcode.x] = std::byte {m_awaitedKey};
+    m_awaitedKey = NO_AWAITED_KEY;
+}
+
+//delay timer = Vx
+void CHIP8::VirtualMachine::SetDelayTimer(const DecodedOpcode& decodedOpcode)
+{
+    m_delayTimer.Set(std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]), m_frame);
+}
+
+//sound timer = Vx
+void CHIP8::VirtualMachine::SetSoundTimer(const DecodedOpcode& decodedOpcode)
+{
+    m_soundTimer.Set(std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]), m_frame);
+}
+
+//I = I + Vx
+void CHIP8::VirtualMachine::AddToAddressReg(const DecodedOpcode& decodedOpcode)
+{
+    m_addressRegister += std::to_integer<std::uint16_t>(m_registers[decodedOpcode.x]);
+}
+
+//I = memory location of digit Vx
+void CHIP8::VirtualMachine::SetAddressRegToDigit(const DecodedOpcode& decodedOpcode)
+{
+    const auto digit = std::to_integer<std::uint16_t>(m_registers[decodedOpcode.x]);
+    m_addressRegister = FONT_ADDRESS_START + digit * HEX_DIGIT_SPRITE_SIZE;
+}
+
+//I = memory location of the big digit Vx
+void CHIP8::VirtualMachine::SetAddressRegToBigDigit(const DecodedOpcode& decodedOpcode)
+{
+    const auto digit = std::to_integer<std::uint16_t>(m_registers[decodedOpcode.x]);
+    m_addressRegister = BIG_FONT_ADDRESS_START + digit * BIG_HEX_DIGIT_SPRITE_SIZE;
+}
+
+//store BCD of Vx in memory
+void CHIP8::VirtualMachine::StoreBCD(const DecodedOpcode& decodedOpcode)
+{
+    const auto bcd = ToBCD(std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]));
+    if constexpr (Profiler::ENABLED)
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountWrites(m_addressRegister, bcd.size());
+        }
+    }
+    std::ranges::copy(bcd, std::begin(m_memory) + m_addressRegister);
+    if (m_debugState)
+    {
+        CheckWatchpoints(m_addressRegister, bcd.size());
+    }
+    InvalidateInstructionCache(m_addressRegister, bcd.size());
+}
+
+//pitch of the tone = Vx
+void CHIP8::VirtualMachine::SetPitch(const DecodedOpcode& decodedOpcode)
+{
+    m_beeper.SetPitch(std::to_integer<std::uint8_t>(m_registers[decodedOpcode.x]));
+}
+
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::AdvanceAddressRegister(const DecodedOpcode& decodedOpcode)
+{
+    constexpr auto addressIncrement = GetQuirks(profile).addressIncrement;
+    if constexpr (addressIncrement == AddressIncrement::ByX)
+    {
+        m_addressRegister += decodedOpcode.x;
+    }
+    else if constexpr (addressIncrement == AddressIncrement::ByXPlusOne)
+    {
+        m_addressRegister += decodedOpcode.x + 1;
+    }
+}
+
+//store registers from 0 to x in memory
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::StoreRegs(const DecodedOpcode& decodedOpcode)
+{
+    if constexpr (Profiler::ENABLED)
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountWrites(m_addressRegister, decodedOpcode.x + 1);
+        }
+    }
+    const auto address = m_addressRegister;
+    const auto count = decodedOpcode.x + 1U;
+    std::copy(std::begin(m_registers), std::begin(m_registers) + count, std::begin(m_memory) + address);
+    //the write may invalidate the cache entry holding the operands, they are not read past this point;
+    //the trace records a copy of them
+    AdvanceAddressRegister<profile>(decodedOpcode);
+    if (m_debugState)
+    {
+        CheckWatchpoints(address, count);
+    }
+    InvalidateInstructionCache(address, count);
+}
+
+//read registers from 0 to x from memory
+template <CHIP8::QuirkProfile profile>
+void CHIP8::VirtualMachine::LoadRegs(const DecodedOpcode& decodedOpcode)
+{
+    if constexpr (Profiler::ENABLED)
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->CountReads(m_addressRegister, decodedOpcode.x + 1);
+        }
+    }
+    std::copy(std::begin(m_memory) + m_addressRegister, std::begin(m_memory) + m_addressRegister + decodedOpcode.x + 1,
+        std::begin(m_registers));
+    AdvanceAddressRegister<profile>(decodedOpcode);
+}
+
+//store registers from 0 to x in the flag registers
+void CHIP8::VirtualMachine::StoreFlags(const DecodedOpcode& decodedOpcode)
+{
+    std::copy(std::begin(m_registers), std::begin(m_registers) + decodedOpcode.x + 1, std::begin(m_flagRegisters));
+}
+
+//read registers from 0 to x from the flag registers
+void CHIP8::VirtualMachine::LoadFlags(const DecodedOpcode& decodedOpcode)
+{
+    std::copy(std::begin(m_flagRegisters), std::begin(m_flagRegisters) + decodedOpcode.x + 1, std::begin(m_registers));
+}
+
+#pragma endregion Instructions
+
+#pragma region Superinstructions
+
+template <CHIP8::QuirkProfile profile, CHIP8::Framebuffer::EdgeMode edgeMode>
+void CHIP8::VirtualMachine::SetRegAndDraw(const PredecodedInstruction& instruction)
+{
+    SetReg(instruction.operands);
+    m_programCounter += INSTRUCTION_WIDTH;
+    Draw<profile, edgeMode>(instruction.fusedOperands);
+}
+
+void CHIP8::VirtualMachine::LoadDelayTimerAndSkipIfZero(const PredecodedInstruction& instruction)
+{
+    LoadDelayTimer(instruction.operands);
+    m_programCounter += INSTRUCTION_WIDTH;
+    SkipOnRegValEqual(instruction.fusedOperands);
 }
 
-#pragma endregion Instructions
\ No newline at end of file
+#pragma endregion Superinstructions
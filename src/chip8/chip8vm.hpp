@@ -20,65 +20,120 @@
 
 #include <array>
 #include <bit>
-#include <functional>
+#include <bitset>
 #include <span>
-#include <mutex>
 #include <optional>
 #include <cstddef>
 #include <cstdint>
 #include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
 #include <boost/container/static_vector.hpp>
 #include <boost/asio.hpp>
-#include <boost/multi_array.hpp>
 #include "timer.hpp"
+#include "framebuffer.hpp"
+#include "tripleBuffer.hpp"
 #include "randomByteSrc.hpp"
 #include "keyboard.hpp"
+#include "instruction.hpp"
+#include "blockCache.hpp"
+#include "jit.hpp"
+#include "rewindBuffer.hpp"
+#include "profiler.hpp"
+#include "executionTrace.hpp"
+#include "beeper.hpp"
+#include "audioSink.hpp"
+#include "quirks.hpp"
+#include "staticAnalyzer.hpp"
 
 namespace CHIP8
 {
     namespace asio = boost::asio;
 
-    struct DecodedOpcode
-    {
-        static constexpr auto NIBBLE_SIZE = 4;
-        std::array<std::uint8_t, 4> nibbles;
-
-        DecodedOpcode(std::uint16_t opcode);
-
-        std::uint16_t ToUInt16(size_t nibbleCount) const;
-        std::byte GetValue() const;
-        std::uint16_t GetAddress() const;
-
-        //first = x, second = y
-        std::pair<std::uint8_t, std::uint8_t> GetRegIndices() const;
-    };
-
     class VirtualMachine
     {
+        //shares the memory layout and font
+        friend class BatchMachine;
+
     public:
-        using DisplayMemory = boost::multi_array<bool, 2>;
+        using DisplayMemory = Framebuffer;
         enum class State 
         {
             Running,
             Shutdown
         };
+
+        enum class ExecutionEngine
+        {
+            //dispatches one predecoded instruction at a time
+            Interpreter,
+            //runs whole basic blocks of threaded code with superinstructions
+            Threaded,
+            //threaded code which compiles hot blocks to x86-64 machine code
+            Jit
+        };
+
+        enum class DebugStopReason
+        {
+            None,
+            //the program counter reached a breakpoint, the instruction there has not run yet
+            Breakpoint,
+            //an instruction wrote to watched memory and has finished
+            Watchpoint
+        };
+
+        //why Execute ended before running all of its instructions while a debugger is attached
+        struct DebugStop
+        {
+            DebugStopReason reason;
+            //of the breakpoint or of the first watched byte written
+            std::uint16_t address;
+        };
+
+        //called on the thread running Run once a frame stopped for the debugger, with what the program threw if it failed
+        using DebugStopHandler = std::function<void(std::exception_ptr failure)>;
         
     private:
 
         static constexpr unsigned int 
-            MEMORY_SIZE = 4096, 
+            //of XO-CHIP, the other profiles have 4 KiB of memory
+            MAX_MEMORY_SIZE = 0x10000, 
             REGISTER_COUNT = 16,
-            DISPLAY_WIDTH = 64,
-            DISPLAY_HEIGHT = 32,
-            ADDRESS_BUS_WIDTH = std::bit_width(MEMORY_SIZE),
+            //SUPER-CHIP keeps 8 of them, XO-CHIP all 16
+            FLAG_REGISTER_COUNT = 16,
             INITIAL_ADDRESS = 0x200,
             INSTRUCTION_WIDTH = 2,
             STACK_SIZE = 16,
             HEX_DIGIT_SPRITE_SIZE = 5,
             FONT_SIZE = HEX_DIGIT_SPRITE_SIZE * 16,
-            FONT_ADDRESS_START = 0x50;
-
-        static constexpr auto CLOCK_PERIOD = 2ms;
+            FONT_ADDRESS_START = 0x50,
+            BIG_HEX_DIGIT_SPRITE_SIZE = 10,
+            BIG_FONT_SIZE = BIG_HEX_DIGIT_SPRITE_SIZE * 16,
+            BIG_FONT_ADDRESS_START = FONT_ADDRESS_START + FONT_SIZE,
+            //SUPER-CHIP scrolls sideways by 4 pixels
+            HORIZONTAL_SCROLL = 4,
+            MAX_BLOCK_LENGTH = 64,
+            HOT_BLOCK_THRESHOLD = 16,
+            FRAME_RATE = 60,
+            DEFAULT_CLOCK_SPEED = 500,
+            //frames run at once after a late wakeup, anything older is dropped
+            MAX_CATCH_UP_FRAMES = 4,
+            NO_AWAITED_KEY = 0xFF,
+            //instructions of an idle loop before the jump which closes it
+            MAX_IDLE_LOOP_LENGTH = 8;
+
+        //a snapshot is the memory, followed by the registers, I, PC, stack depth and stack, timers, awaited key, clock remainder,
+        //resolution, selected planes, flag registers, display planes, audio pattern and pitch
+        static constexpr std::size_t SNAPSHOT_STATE_SIZE = REGISTER_COUNT + 2 * sizeof(std::uint16_t) + 
+            1 + STACK_SIZE * sizeof(std::uint16_t) + 2 + 1 + sizeof(std::uint32_t) + 1 + 1 + FLAG_REGISTER_COUNT + 
+            sizeof(Framebuffer::Plane) * Framebuffer::PLANES + sizeof(Beeper::Pattern) + 1;
+
+        static constexpr auto FRAME_PERIOD = std::chrono::nanoseconds {1'000'000'000 / FRAME_RATE};
 
         static constexpr std::array<std::uint8_t, FONT_SIZE> FONT = 
         {
@@ -99,39 +154,275 @@ namespace CHIP8
             0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
             0xF0, 0x80, 0xF0, 0x80, 0x80  // F
         };
+
+        //8x10 digits of SUPER-CHIP, with the letters XO-CHIP adds
+        static constexpr std::array<std::uint8_t, BIG_FONT_SIZE> BIG_FONT = 
+        {
+            0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+            0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+            0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+            0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+            0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+            0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+            0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+            0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+            0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+            0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+            0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+            0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+            0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+        };
         
-        using Instruction = std::function<void(VirtualMachine* vm, const DecodedOpcode&)>;
+        //final handler for every possible 16-bit opcode, shared by all instances
+        using InstructionTable = std::array<Instruction, 0x10000>;
 
-        std::array<std::byte, MEMORY_SIZE> m_memory;
+        //what the loop starting at an address waits for, if it is an idle loop
+        enum class IdleLoop : std::uint8_t
+        {
+            None,
+            //only reads the keys, registers and memory, so it can only end once the keys change
+            KeyChange,
+            //reads the delay timer as well, which changes with the next frame
+            NextFrame
+        };
+
+        //state at the previous visit of an idle loop entry in the current batch
+        struct IdleLoopVisit
+        {
+            std::uint16_t entry;
+            //the jump back closing the loop, the visit is forgotten once the program counter leaves the loop
+            std::uint16_t jumpAddress;
+            std::array<std::byte, REGISTER_COUNT> registers;
+            std::uint16_t addressRegister;
+            std::size_t executedInstructions;
+        };
+
+        //sized by the quirk profile, as are the caches holding an entry per address
+        std::vector<std::byte> m_memory;
+        //indexed by nibbles of opcodes, which cannot go past the last register, so accesses are not checked
         std::array<std::byte, REGISTER_COUNT> m_registers;
+        //saved and restored by Fx75 and Fx85, SUPER-CHIP keeps them across programs
+        std::array<std::byte, FLAG_REGISTER_COUNT> m_flagRegisters;
         std::uint16_t m_addressRegister, m_programCounter;
         boost::container::static_vector<std::uint16_t, STACK_SIZE> m_stack;
 
-        std::mutex m_displayMemoryMtx;
+        //only touched by the thread running the VM, finished frames are published to m_publishedDisplay
         DisplayMemory m_displayMemory;
+        Framebuffer::Generation m_publishedGeneration;
+        //lets the renderer sleep until a frame is published, the VM only holds the mutex to notify
+        std::mutex m_publishedDisplayMtx;
+        std::condition_variable m_displayPublished;
+        std::atomic<Framebuffer::Generation> m_latestPublishedGeneration;
+        TripleBuffer<DisplayMemory> m_publishedDisplay;
+        //replaces the edge mode of the quirk profile when set
+        std::optional<Framebuffer::EdgeMode> m_spriteEdgeMode;
+        //bitplanes drawn, scrolled and cleared by the display instructions, selected by Fn01
+        Framebuffer::PlaneMask m_planeMask;
         
         RandomByteSource m_randomByteSrc;
-        Keyboard m_keyboard;
-
-        asio::io_context m_ioCtx;
+        std::unique_ptr<Keyboard> m_keyboard;
+        //key which Fx0A saw pressed and waits to be released, NO_AWAITED_KEY while it waits for a press
+        std::uint8_t m_awaitedKey;
+        //set by Fx0A while it waits and by 00FD once the program has exited, which ends the current batch of instructions
+        bool m_waitingForKey;
+        //instructions per iteration of the loop the last batch ended in while waiting for the keys, 1 for Fx0A,
+        //0 if it did not end waiting for them
+        std::size_t m_keyWaitPeriod;
+
+        //only created by Run or GetIoContext, a VM driven through Execute does not hold any OS resources
+        std::unique_ptr<asio::io_context> m_ioCtx;
+        //lets other threads wake Run up while it is being created
+        std::mutex m_ioCtxMtx;
+        //no frames are scheduled while Fx0A waits, Run sleeps until it is woken up
+        bool m_sleeping;
+        //no frames are scheduled either while a debugger keeps the program stopped
+        bool m_paused;
         Timer m_delayTimer, m_soundTimer;
-        asio::steady_timer m_clock;
+        //null unless set, no samples are synthesized without a sink
+        std::unique_ptr<AudioSink> m_audioSink;
+        Beeper m_beeper;
+        //samples of the current frame, kept to avoid allocating every frame
+        std::vector<std::int16_t> m_frameSamples;
+        //fraction of a sample carried over between frames, in 1 / FRAME_RATE units
+        std::uint32_t m_sampleRemainder;
+        //frames run by RunFrame, the clock the timers count down with
+        Timer::Frame m_frame;
+        //fires once per frame, the instructions of a frame are executed in one go
+        std::unique_ptr<asio::steady_timer> m_frameTimer;
+        asio::steady_timer::time_point m_nextFrame;
         std::atomic<State> m_state;
+        //instructions per second
+        std::uint32_t m_clockSpeed;
+        //fraction of an instruction carried over between frames, in 1 / FRAME_RATE units
+        std::uint32_t m_clockRemainder;
+
+        ExecutionEngine m_executionEngine;
+        QuirkProfile m_quirkProfile;
+        //handlers specialized for the quirk profile, no handler checks the quirks while it runs
+        const InstructionTable* m_instructionTable;
+        Instruction m_setRegAndDraw;
+        //one entry per address, kept on the heap since it is too large for the stack the machine may live on
+        std::vector<PredecodedInstruction> m_instructionCache;
+        //made by LoadProgram, instructions accessing memory at I which it does not prove in bounds run checked;
+        //discarded once the program overwrites its own code
+        ProgramAnalysis m_analysis;
+        BlockCache m_blockCache;
+        std::unique_ptr<JitCompiler> m_jit;
+        //thrown by a handler called from compiled code, rethrown once the block has returned
+        std::exception_ptr m_nativeException;
+
+        //entries of loops which are closed by a jump back and only compute registers from the keys, timers and memory;
+        //once an iteration leaves the registers as they were, every further one does the same until an input changes
+        std::vector<IdleLoop> m_idleLoops;
+        std::optional<IdleLoopVisit> m_lastIdleLoopVisit;
+
+        //breakpoints and watchpoints of an attached debugger, one bit per address
+        struct DebugState
+        {
+            std::bitset<MAX_MEMORY_SIZE> breakpoints, watchpoints;
+            DebugStop stop;
+            DebugStopHandler onStop;
+        };
 
-        std::array<Instruction, 16> m_instructionTable;
+        //only exists while a debugger is attached, nothing looks at breakpoints or watchpoints otherwise
+        std::unique_ptr<DebugState> m_debugState;
+        //instructions left of the frame a debugger stopped in, the next frame finishes them first
+        std::size_t m_unfinishedFrameInstructions;
+
+        //captures every frame once rewinding is enabled
+        std::unique_ptr<RewindBuffer> m_rewindBuffer;
+        //kept to make the history again when the snapshots change size with the memory
+        std::size_t m_rewindHistoryFrames, m_rewindArenaBytes;
+        //set by the frontend while frames should step back instead of running
+        std::atomic_bool m_rewinding;
+
+        //only created by EnableProfiler in builds with the profiler compiled in
+        std::unique_ptr<Profiler> m_profiler;
+        //always recorded, idle loops record only the iterations which are not fast-forwarded
+        ExecutionTrace m_trace;
+
+        //adapts a member function to the Instruction signature
+        template <void (VirtualMachine::*handler)(const DecodedOpcode&)>
+        static void Invoke(VirtualMachine& vm, const PredecodedInstruction& instruction)
+        {
+            (vm.*handler)(instruction.operands);
+        }
 
-        std::uint16_t FetchNextInstruction() const;
-        Instruction GetInstruction(const DecodedOpcode& decodedOpcode) const;
+        //same for superinstructions, which need the operands of both fused opcodes
+        template <void (VirtualMachine::*handler)(const PredecodedInstruction&)>
+        static void InvokeSuperinstruction(VirtualMachine& vm, const PredecodedInstruction& instruction)
+        {
+            (vm.*handler)(instruction);
+        }
 
-        void DrawSprite(std::uint8_t x, std::uint8_t y, std::span<std::byte> sprite);
+        //records an instruction which started at the address and has run, both halves of a superinstruction;
+        //called for every instruction, so it is kept inline
+        void TraceInstruction(std::uint16_t address, const DecodedOpcode& operands, const DecodedOpcode& fusedOperands)
+        {
+            m_trace.Record(TraceEntry {address, operands.opcode, m_addressRegister, 
+                std::to_integer<std::uint8_t>(m_registers[operands.x]), TraceEvent::Executed});
+            if (fusedOperands.opcode != 0)
+            {
+                m_trace.Record(TraceEntry {static_cast<std::uint16_t>(address + INSTRUCTION_WIDTH), fusedOperands.opcode, m_addressRegister, 
+                    std::to_integer<std::uint8_t>(m_registers[fusedOperands.x]), TraceEvent::Executed});
+            }
+        }
+
+        //checks the memory access of an instruction the analysis could not prove in bounds before running its handler
+        static void InvokeChecked(VirtualMachine& vm, const PredecodedInstruction& instruction);
+
+        //entry point for compiled code, which must not be unwound through
+        static std::uint32_t CallFromNative(VirtualMachine& vm, const PredecodedInstruction& instruction) noexcept;
+
+        //the edge mode is a parameter of its own, so --wrap-sprites does not cost a branch per draw either
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
+        static const InstructionTable& GetInstructionTable();
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
+        static Instruction Decode(std::uint16_t opcode);
+        static bool EndsBasicBlock(std::uint16_t opcode);
+        //selects the handlers of the profile and the sprite edge mode, everything translated with the previous ones is dropped
+        void UpdateHandlers();
+        //gives memory and the caches an entry per address of the new size, the bytes past a smaller size are lost
+        void ResizeMemory(std::size_t memorySize);
+        //points the instruction table and the superinstructions at the handlers of the profile
+        template <QuirkProfile profile>
+        void SelectHandlers();
+        bool TryFuse(PredecodedInstruction& previous, const PredecodedInstruction& next) const;
+        //the handler from the instruction table, wrapped by InvokeChecked unless the analysis proved the instruction in bounds
+        Instruction SelectHandler(std::uint16_t address, std::uint16_t opcode) const;
+        //throws if the instruction would read or write past the end of memory at I
+        void CheckMemoryAccess(const DecodedOpcode& decodedOpcode) const;
+        //analyzes the program from the current state with the quirks of the profile
+        void AnalyzeProgram();
+        //every instruction accessing memory at I runs checked from now on
+        void DiscardAnalysis();
+        //called once registers, I or the program counter are set from outside of the program
+        void DiscardAnalysisOfState();
+
+        std::uint16_t FetchInstruction(std::uint16_t address) const;
+        BasicBlock TranslateBlock(std::uint16_t entry) const;
+        std::size_t ExecuteNextInstruction();
+        std::size_t ExecuteNextBlock();
+        void CompileBlock(BasicBlock& block);
+        void InvalidateInstructionCache(std::size_t address, std::size_t length);
+        //called whenever a jump is predecoded or translated
+        void DetectIdleLoop(std::uint16_t jumpAddress, const DecodedOpcode& jump);
+        //skips the whole iterations of an idle loop left in the batch, returns the instructions executed by then
+        std::size_t FastForwardIdleLoop(std::size_t executedInstructions, std::size_t instructionCount);
+        std::uint16_t FindIdleLoopJump(std::uint16_t entry) const;
+        //true once Execute has to stop at a breakpoint or watchpoint, only called while a debugger is attached
+        bool StopsForDebugger();
+        //stops Execute after the current instruction if it wrote to watched memory, only called while a debugger is attached
+        void CheckWatchpoints(std::size_t address, std::size_t length);
+
+        std::size_t GetSnapshotSize() const;
+        void CaptureSnapshot(std::span<std::byte> snapshot) const;
+        void RestoreSnapshot(std::span<const std::byte> snapshot);
+        bool StepBack();
+
+        void DrawSprite(std::uint8_t x, std::uint8_t y, std::span<const std::byte> sprite, unsigned spriteWidth, Framebuffer::EdgeMode edgeMode);
         void ClearDisplay();
+        void PublishDisplay();
 
         /*Instructions*/ 
 
+        //fills the cache entry for the current address and executes it
+        void PredecodeAndExecute(const DecodedOpcode& decodedOpcode);
+
         void UnimplementedInstruction(const DecodedOpcode& decodedOpcode);
 
-        //prefix = 0
-        void ZeroPrefixInstuctions(const DecodedOpcode& decodedOpcode);
+        //prefix = 0, machine code routines are ignored
+        void NoOperation(const DecodedOpcode& decodedOpcode);
+
+        //00Cn
+        void ScrollDown(const DecodedOpcode& decodedOpcode);
+
+        //00Dn
+        void ScrollUp(const DecodedOpcode& decodedOpcode);
+
+        //00E0
+        void ClearScreen(const DecodedOpcode& decodedOpcode);
+
+        //00EE
+        void Return(const DecodedOpcode& decodedOpcode);
+
+        //00FB
+        void ScrollRight(const DecodedOpcode& decodedOpcode);
+
+        //00FC
+        void ScrollLeft(const DecodedOpcode& decodedOpcode);
+
+        //00FD
+        void Exit(const DecodedOpcode& decodedOpcode);
+
+        //00FE
+        void SetLowResolution(const DecodedOpcode& decodedOpcode);
+
+        //00FF
+        void SetHighResolution(const DecodedOpcode& decodedOpcode);
 
         //prefix = 1
         void Jump(const DecodedOpcode& decodedOpcode);
@@ -142,23 +433,62 @@ namespace CHIP8
         //helper function
         void SkipNextInstruction();
 
+        //helper function, moves I past the registers Fx55 and Fx65 copied as far as the profile does
+        template <QuirkProfile profile>
+        void AdvanceAddressRegister(const DecodedOpcode& decodedOpcode);
+
         //prefix = 3
         void SkipOnRegValEqual(const DecodedOpcode& decodedOpcode);
 
         //prefix = 4
         void SkipOnRegValNotEqual(const DecodedOpcode& decodedOpcode);
 
-        //prefix = 5
+        //5xy0
         void SkipOnRegsEqual(const DecodedOpcode& decodedOpcode);
 
+        //5xy2
+        void StoreRegRange(const DecodedOpcode& decodedOpcode);
+
+        //5xy3
+        void LoadRegRange(const DecodedOpcode& decodedOpcode);
+
         //prefix = 6
         void SetReg(const DecodedOpcode& decodedOpcode);
 
         //prefix = 7
         void Add(const DecodedOpcode& decodedOpcode);
 
-        //prefix = 8
-        void EightPrefixInstructions(const DecodedOpcode& decodedOpcode);
+        //8xy0
+        void CopyReg(const DecodedOpcode& decodedOpcode);
+
+        //8xy1
+        template <QuirkProfile profile>
+        void OrRegs(const DecodedOpcode& decodedOpcode);
+
+        //8xy2
+        template <QuirkProfile profile>
+        void AndRegs(const DecodedOpcode& decodedOpcode);
+
+        //8xy3
+        template <QuirkProfile profile>
+        void XorRegs(const DecodedOpcode& decodedOpcode);
+
+        //8xy4
+        void AddRegs(const DecodedOpcode& decodedOpcode);
+
+        //8xy5
+        void SubtractRegs(const DecodedOpcode& decodedOpcode);
+
+        //8xy6
+        template <QuirkProfile profile>
+        void ShiftRight(const DecodedOpcode& decodedOpcode);
+
+        //8xy7
+        void SubtractRegsReversed(const DecodedOpcode& decodedOpcode);
+
+        //8xyE
+        template <QuirkProfile profile>
+        void ShiftLeft(const DecodedOpcode& decodedOpcode);
 
         //prefix = 9
         void SkipOnRegsNotEqual(const DecodedOpcode& decodedOpcode);
@@ -167,29 +497,182 @@ namespace CHIP8
         void SetAddressReg(const DecodedOpcode& decodedOpcode);
 
         //prefix = B
+        template <QuirkProfile profile>
         void JumpWithOffset(const DecodedOpcode& decodedOpcode);
 
         //prefix = C
         void AndWithRandom(const DecodedOpcode& decodedOpcode);
 
         //prefix = D
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
         void Draw(const DecodedOpcode& decodedOpcode);
 
-        //prefix = E
-        void SkipOnKeyState(const DecodedOpcode& decodedOpcode);
+        //Ex9E
+        void SkipOnKeyPressed(const DecodedOpcode& decodedOpcode);
+
+        //ExA1
+        void SkipOnKeyNotPressed(const DecodedOpcode& decodedOpcode);
 
-        //prefix = F
-        void FPrefixInstructions(const DecodedOpcode& decodedOpcode);
+        //F000 nnnn
+        void SetAddressRegLong(const DecodedOpcode& decodedOpcode);
 
-        void OnClock(const boost::system::error_code& errc);
+        //Fn01
+        void SelectPlanes(const DecodedOpcode& decodedOpcode);
+
+        //F002
+        void LoadAudioPattern(const DecodedOpcode& decodedOpcode);
+
+        //Fx07
+        void LoadDelayTimer(const DecodedOpcode& decodedOpcode);
+
+        //Fx0A
+        void WaitForKey(const DecodedOpcode& decodedOpcode);
+
+        //Fx15
+        void SetDelayTimer(const DecodedOpcode& decodedOpcode);
+
+        //Fx18
+        void SetSoundTimer(const DecodedOpcode& decodedOpcode);
+
+        //Fx1E
+        void AddToAddressReg(const DecodedOpcode& decodedOpcode);
+
+        //Fx29
+        void SetAddressRegToDigit(const DecodedOpcode& decodedOpcode);
+
+        //Fx30
+        void SetAddressRegToBigDigit(const DecodedOpcode& decodedOpcode);
+
+        //Fx33
+        void StoreBCD(const DecodedOpcode& decodedOpcode);
+
+        //Fx3A
+        void SetPitch(const DecodedOpcode& decodedOpcode);
+
+        //Fx55
+        template <QuirkProfile profile>
+        void StoreRegs(const DecodedOpcode& decodedOpcode);
+
+        //Fx65
+        template <QuirkProfile profile>
+        void LoadRegs(const DecodedOpcode& decodedOpcode);
+
+        //Fx75
+        void StoreFlags(const DecodedOpcode& decodedOpcode);
+
+        //Fx85
+        void LoadFlags(const DecodedOpcode& decodedOpcode);
+
+        /*Superinstructions*/
+
+        //6xnn, Dxyn
+        template <QuirkProfile profile, Framebuffer::EdgeMode edgeMode>
+        void SetRegAndDraw(const PredecodedInstruction& instruction);
+
+        //Fx07, 3x00
+        void LoadDelayTimerAndSkipIfZero(const PredecodedInstruction& instruction);
+
+        //executes the instruction budget of one frame and counts the timers down
+        void RunFrame();
+        void ScheduleNextFrame();
+        void OnFrame(const boost::system::error_code& errc);
+        //ends the sleep of Run early, may be called from any thread
+        void WakeUp();
+        //accounts for frames which Run slept through while waiting for the keys
+        void SkipIdleFrames(std::size_t frameCount);
+        //samples in the given number of frames at the rate of the sink, carrying the remainder over
+        std::size_t CountFrameSamples(std::size_t frameCount);
+        //synthesizes the sound of one frame and writes it to the sink
+        void PlayFrameSound(bool playing);
 
     public:
         VirtualMachine();
         void LoadProgram(std::span<const std::byte> program);
-        std::optional<DisplayMemory> GetDisplayMemory();
+        //must be selected before Run, falls back to the threaded engine if the JIT is not available
+        void SetExecutionEngine(ExecutionEngine engine);
+        ExecutionEngine GetExecutionEngine() const;
+        //makes Cxnn reproducible, a VM is seeded randomly otherwise
+        void SetRandomSeed(std::uint32_t seed);
+        //behaviour of the instructions interpreters disagree on, legacy unless set, must be selected before running
+        void SetQuirkProfile(QuirkProfile profile);
+        QuirkProfile GetQuirkProfile() const;
+        //sprites are clipped or wrapped around the edges of the display as the quirk profile says unless set, std::nullopt follows the profile again
+        void SetSpriteEdgeMode(std::optional<Framebuffer::EdgeMode> edgeMode);
+        //of the loaded program, empty once the program has overwritten its own code
+        const ProgramAnalysis& GetProgramAnalysis() const;
+        //lets perf symbolize blocks compiled by the JIT
+        void EnableJitPerfMap();
+        //keeps up to historyFrames frames of history in arenaBytes of memory, must be called before running
+        void EnableRewind(std::size_t historyFrames, std::size_t arenaBytes);
+        //while set, every frame of Run steps one frame back in the history instead of executing
+        void SetRewinding(bool rewinding);
+        //steps back on the calling thread, not while Run is running, returns fewer frames if the history is shorter
+        std::size_t RewindFrames(std::size_t frameCount);
+        //empty unless rewinding is enabled, may be called from any thread
+        std::optional<RewindBuffer::Statistics> GetRewindStatistics() const;
+        //counts every instruction and memory access from now on, which runs all engines one instruction
+        //at a time, has no effect unless built with CHIP8_ENABLE_PROFILER
+        void EnableProfiler();
+        //null unless profiling, must not be read while the VM runs
+        const Profiler* GetProfiler() const;
+        //last instructions executed, ending with the one which failed if Execute has thrown, must not be read while the VM runs
+        const ExecutionTrace& GetExecutionTrace() const;
+        //latest finished frame, stays valid until the next call, must only be called from one thread,
+        //its generation tells whether anything changed since a frame seen before and in which rows
+        const DisplayMemory& GetDisplayMemory();
+        //blocks until a frame newer than the given generation is published or the deadline passes,
+        //returns whether there is such a frame; nothing but a published frame ends the wait early
+        bool WaitForDisplay(Framebuffer::Generation seenGeneration, std::chrono::steady_clock::time_point deadline);
+        //the VM starts with a NullKeyboard, must be replaced before Run
+        void SetKeyboard(std::unique_ptr<Keyboard> keyboard);
+        //no sound is produced unless a sink is set, must be set before Run
+        void SetAudioSink(std::unique_ptr<AudioSink> audioSink);
+        //must be called whenever the keys of the keyboard change, Run sleeps while Fx0A waits
+        //and only checks the keys again when told to, may be called from any thread
+        void NotifyKeyboardChanged();
         void Stop();
+        //runs in real time until Stop is called
         void Run();
+        //of Run, created on first use; a debugger serves its connection on it so its handlers run between frames
+        asio::io_context& GetIoContext();
+        //keeps Run from running frames until Resume, only on the thread running Run or before it starts
+        void Pause();
+        void Resume();
+        //run without pacing on the calling thread, timers are not counted down;
+        //stops early if Fx0A waits, counting the rest of the instructions as spent waiting
+        std::size_t Execute(std::size_t instructionCount);
+        //run without pacing, counting timers down once per frame; stops early in a frame a debugger stopped in
+        void RunFrames(std::size_t frameCount);
+        //instructions executed per second of emulated time
+        void SetClockSpeed(std::uint32_t instructionsPerSecond);
+        std::span<const std::byte> GetRegisters() const;
+        std::uint16_t GetAddressRegister() const;
+        std::uint16_t GetProgramCounter() const;
+        //of the current resolution
         unsigned int GetDisplayHeight() const;
         unsigned int GetDisplayWidth() const;
+
+        //while a debugger is attached every engine runs one instruction at a time, without fast-forwarding idle loops,
+        //and Execute stops once the program reaches a breakpoint or writes to watched memory; Run is paused, and pauses
+        //again after the frame which stops or fails, calling onStop; only on the thread running Run or before it starts
+        void AttachDebugger(DebugStopHandler onStop = {});
+        //drops every breakpoint and watchpoint, Run resumes the program
+        void DetachDebugger();
+        bool IsDebuggerAttached() const;
+        //no effect unless a debugger is attached
+        void SetBreakpoint(std::uint16_t address, bool enabled);
+        //only writes by the program are watched, ranges past the end of memory are cut off; no effect unless a debugger is attached
+        void SetWatchpoint(std::uint16_t address, std::size_t length, bool enabled);
+        //of the last call to Execute or RunFrames, the reason is None if it was not stopped by a debugger
+        DebugStop GetDebugStop() const;
+        //as large as the quirk profile has it
+        std::span<const std::byte> GetMemory() const;
+        //code written over is translated again, throws std::invalid_argument if the bytes do not fit into memory
+        void WriteMemory(std::uint16_t address, std::span<const std::byte> bytes);
+        //setting registers, I or the program counter discards the analysis of the loaded program, every access is checked again;
+        //throws std::out_of_range unless the index is of a V register
+        void SetRegister(std::size_t index, std::byte value);
+        void SetAddressRegister(std::uint16_t value);
+        void SetProgramCounter(std::uint16_t value);
     };
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "disassembler.hpp"
+#include <format>
+#include "instruction.hpp"
+
+std::string CHIP8::Disassemble(std::uint16_t opcode)
+{
+    const DecodedOpcode operands {opcode};
+    const auto x = operands.x, y = operands.y, n = operands.n;
+    const auto nn = operands.nn;
+    const auto nnn = operands.nnn;
+
+    switch (opcode >> 12)
+    {
+        case 0x0:
+            switch (opcode)
+            {
+                case 0x00E0: return "CLS";
+                case 0x00EE: return "RET";
+                case 0x00FB: return "SCR";
+                case 0x00FC: return "SCL";
+                case 0x00FD: return "EXIT";
+                case 0x00FE: return "LOW";
+                case 0x00FF: return "HIGH";
+            }
+            switch (opcode & 0xFFF0)
+            {
+                case 0x00C0: return std::format("SCD {:X}", n);
+                case 0x00D0: return std::format("SCU {:X}", n);
+            }
+            return std::format("SYS {:03X}", nnn);
+
+        case 0x1: return std::format("JP {:03X}", nnn);
+        case 0x2: return std::format("CALL {:03X}", nnn);
+        case 0x3: return std::format("SE V{:X}, {:02X}", x, nn);
+        case 0x4: return std::format("SNE V{:X}, {:02X}", x, nn);
+
+        case 0x5:
+            switch (n)
+            {
+                case 0x0: return std::format("SE V{:X}, V{:X}", x, y);
+                case 0x2: return std::format("SAVE V{:X}-V{:X}", x, y);
+                case 0x3: return std::format("LOAD V{:X}-V{:X}", x, y);
+            }
+            break;
+
+        case 0x6: return std::format("LD V{:X}, {:02X}", x, nn);
+        case 0x7: return std::format("ADD V{:X}, {:02X}", x, nn);
+
+        case 0x8:
+            switch (n)
+            {
+                case 0x0: return std::format("LD V{:X}, V{:X}", x, y);
+                case 0x1: return std::format("OR V{:X}, V{:X}", x, y);
+                case 0x2: return std::format("AND V{:X}, V{:X}", x, y);
+                case 0x3: return std::format("XOR V{:X}, V{:X}", x, y);
+                case 0x4: return std::format("ADD V{:X}, V{:X}", x, y);
+                case 0x5: return std::format("SUB V{:X}, V{:X}", x, y);
+                case 0x6: return std::format("SHR V{:X}, V{:X}", x, y);
+                case 0x7: return std::format("SUBN V{:X}, V{:X}", x, y);
+                case 0xE: return std::format("SHL V{:X}, V{:X}", x, y);
+            }
+            break;
+
+        case 0x9:
+            if (n == 0)
+            {
+                return std::format("SNE V{:X}, V{:X}", x, y);
+            }
+            break;
+
+        case 0xA: return std::format("LD I, {:03X}", nnn);
+        case 0xB: return std::format("JP V0, {:03X}", nnn);
+        case 0xC: return std::format("RND V{:X}, {:02X}", x, nn);
+        case 0xD: return std::format("DRW V{:X}, V{:X}, {:X}", x, y, n);
+
+        case 0xE:
+            switch (nn)
+            {
+                case 0x9E: return std::format("SKP V{:X}", x);
+                case 0xA1: return std::format("SKNP V{:X}", x);
+            }
+            break;
+
+        case 0xF:
+            //the address of F000 is the word after it, which is not part of the opcode
+            if (IsLongInstruction(opcode))
+            {
+                return "LD I, long";
+            }
+            switch (nn)
+            {
+                case 0x01: return std::format("PLANE {:X}", x);
+                case 0x02: return x == 0 ? "AUDIO" : std::format("DW {:04X}", opcode);
+                case 0x07: return std::format("LD V{:X}, DT", x);
+                case 0x0A: return std::format("LD V{:X}, K", x);
+                case 0x15: return std::format("LD DT, V{:X}", x);
+                case 0x18: return std::format("LD ST, V{:X}", x);
+                case 0x1E: return std::format("ADD I, V{:X}", x);
+                case 0x29: return std::format("LD F, V{:X}", x);
+                case 0x30: return std::format("LD HF, V{:X}", x);
+                case 0x33: return std::format("LD B, V{:X}", x);
+                case 0x3A: return std::format("PITCH V{:X}", x);
+                case 0x55: return std::format("LD [I], V{:X}", x);
+                case 0x65: return std::format("LD V{:X}, [I]", x);
+                case 0x75: return std::format("LD R, V{:X}", x);
+                case 0x85: return std::format("LD V{:X}, R", x);
+            }
+            break;
+    }
+    return std::format("DW {:04X}", opcode);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace CHIP8
+{
+    //mnemonic of an opcode in the syntax of Cowgod's technical reference, with the instructions SUPER-CHIP
+    //and XO-CHIP add; the same for every quirk profile, opcodes none of them decode are shown as data
+    std::string Disassemble(std::uint16_t opcode);
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "executionTrace.hpp"
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include "littleEndian.hpp"
+
+namespace
+{
+    constexpr std::array<char, 4> MAGIC {'C', '8', 'T', 'R'};
+    constexpr std::uint16_t VERSION = 1;
+}
+
+CHIP8::ExecutionTrace::ExecutionTrace()
+    :
+    m_entries(CAPACITY),
+    m_recordedCount(0)
+{
+
+}
+
+std::uint64_t CHIP8::ExecutionTrace::GetRecordedCount() const
+{
+    return m_recordedCount;
+}
+
+std::vector<CHIP8::TraceEntry> CHIP8::ExecutionTrace::GetEntries() const
+{
+    //until the ring is full the oldest entry is the first one
+    const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(m_recordedCount, CAPACITY));
+    const auto oldest = static_cast<std::size_t>((m_recordedCount - count) & (CAPACITY - 1));
+    std::vector<TraceEntry> entries;
+    entries.reserve(count);
+    for (std::size_t index {0}; index < count; ++index)
+    {
+        entries.push_back(m_entries[(oldest + index) & (CAPACITY - 1)]);
+    }
+    return entries;
+}
+
+void CHIP8::ExecutionTrace::Save(const std::filesystem::path& path, std::string_view failure) const
+{
+    std::ofstream file {path, std::ios::out | std::ios::binary | std::ios::trunc};
+    if (not file.is_open())
+    {
+        throw std::runtime_error {std::format("Cannot write trace {}", path.string())};
+    }
+
+    const auto entries = GetEntries();
+    const auto failureLength = std::min<std::size_t>(failure.size(), std::numeric_limits<std::uint16_t>::max());
+    file.write(MAGIC.data(), MAGIC.size());
+    WriteLittleEndian(file, VERSION);
+    WriteLittleEndian(file, m_recordedCount);
+    WriteLittleEndian(file, static_cast<std::uint16_t>(failureLength));
+    file.write(failure.data(), failureLength);
+    WriteLittleEndian(file, static_cast<std::uint32_t>(entries.size()));
+    for (const auto& entry : entries)
+    {
+        WriteLittleEndian(file, entry.programCounter);
+        WriteLittleEndian(file, entry.opcode);
+        WriteLittleEndian(file, entry.addressRegister);
+        WriteLittleEndian(file, entry.registerValue);
+        WriteLittleEndian(file, static_cast<std::uint8_t>(entry.event));
+    }
+
+    if (not file.flush())
+    {
+        throw std::runtime_error {std::format("Cannot write trace {}", path.string())};
+    }
+}
+
+CHIP8::TraceLog CHIP8::TraceLog::Load(const std::filesystem::path& path)
+{
+    std::ifstream file {path, std::ios::in | std::ios::binary};
+    if (not file.is_open())
+    {
+        throw std::runtime_error {std::format("Cannot open trace {}", path.string())};
+    }
+
+    const auto notATrace = [&path]
+    {
+        return std::runtime_error {std::format("{} is not a trace", path.string())};
+    };
+
+    std::array<char, MAGIC.size()> magic;
+    std::uint16_t version, failureLength;
+    std::uint32_t entryCount;
+    TraceLog log;
+    if (not file.read(magic.data(), magic.size()) or magic != MAGIC or 
+        not ReadLittleEndian(file, version) or version != VERSION or 
+        not ReadLittleEndian(file, log.recordedCount) or 
+        not ReadLittleEndian(file, failureLength))
+    {
+        throw notATrace();
+    }
+    log.failure.resize(failureLength);
+    if (not file.read(log.failure.data(), failureLength) or 
+        not ReadLittleEndian(file, entryCount) or entryCount > ExecutionTrace::CAPACITY)
+    {
+        throw notATrace();
+    }
+
+    log.entries.resize(entryCount);
+    for (auto& entry : log.entries)
+    {
+        std::uint8_t event;
+        if (not ReadLittleEndian(file, entry.programCounter) or 
+            not ReadLittleEndian(file, entry.opcode) or 
+            not ReadLittleEndian(file, entry.addressRegister) or 
+            not ReadLittleEndian(file, entry.registerValue) or 
+            not ReadLittleEndian(file, event) or event > static_cast<std::uint8_t>(TraceEvent::Failed))
+        {
+            throw notATrace();
+        }
+        entry.event = static_cast<TraceEvent>(event);
+    }
+    return log;
+}
\ No newline at end of file
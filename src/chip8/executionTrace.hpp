@@ -0,0 +1,91 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CHIP8
+{
+    enum class TraceEvent : std::uint8_t
+    {
+        //the instruction has run, the entry holds the state it left
+        Executed,
+        //compiled code was entered at the instruction, the entry holds the state it was entered with;
+        //only the instructions it leaves to their handlers are recorded on their own
+        EnteredBlock,
+        //the instruction threw, the entry holds the state it failed in
+        Failed
+    };
+
+    struct TraceEntry
+    {
+        std::uint16_t programCounter, opcode, addressRegister;
+        //Vx of the opcode, the register most instructions change
+        std::uint8_t registerValue;
+        TraceEvent event;
+    };
+
+    //ring of the last instructions a VM executed, recorded all the time, so it can tell how a failing program got there;
+    //recording only stores one entry into the ring, which is allocated once with the VM
+    class ExecutionTrace
+    {
+    public:
+        static constexpr std::size_t CAPACITY = 8192;
+
+    private:
+        static_assert(std::has_single_bit(CAPACITY));
+
+        std::vector<TraceEntry> m_entries;
+        //entries ever recorded, the ring holds the last CAPACITY of them
+        std::uint64_t m_recordedCount;
+
+    public:
+        ExecutionTrace();
+
+        void Record(const TraceEntry& entry)
+        {
+            m_entries[m_recordedCount & (CAPACITY - 1)] = entry;
+            m_recordedCount += 1;
+        }
+
+        std::uint64_t GetRecordedCount() const;
+        //oldest first
+        std::vector<TraceEntry> GetEntries() const;
+        //throws std::runtime_error if the file cannot be written
+        void Save(const std::filesystem::path& path, std::string_view failure) const;
+    };
+
+    //a trace as saved when a program failed, stored as a header, the message of the failure
+    //and one little-endian entry per instruction, oldest first
+    struct TraceLog
+    {
+        std::uint64_t recordedCount;
+        std::string failure;
+        std::vector<TraceEntry> entries;
+
+        //throws std::runtime_error if the file cannot be read or is not a trace
+        static TraceLog Load(const std::filesystem::path& path);
+    };
+}
\ No newline at end of file
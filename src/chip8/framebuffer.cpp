@@ -0,0 +1,425 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "framebuffer.hpp"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+CHIP8::Framebuffer::Framebuffer()
+    :
+    m_planes(),
+    m_resolution(Resolution::Low),
+    m_generation(0)
+{
+    m_rowGenerations.fill(0);
+}
+
+unsigned CHIP8::Framebuffer::GetWordCount() const
+{
+    return GetWidth() / WORD_BITS;
+}
+
+void CHIP8::Framebuffer::MarkChanged(RowMask rows)
+{
+    if (rows == 0)
+    {
+        return;
+    }
+
+    m_generation += 1;
+    for (; rows != 0; rows &= rows - 1)
+    {
+        m_rowGenerations[std::countr_zero(rows)] = m_generation;
+    }
+}
+
+void CHIP8::Framebuffer::Clear(PlaneMask planes)
+{
+    //clearing an empty display is not a change
+    RowMask changedRows {0};
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        if ((planes >> plane & 1) == 0)
+        {
+            continue;
+        }
+
+        for (unsigned rowIndex {0}; rowIndex < HIGH_HEIGHT; ++rowIndex)
+        {
+            auto& row = m_planes[plane][rowIndex];
+            if (row != Row {})
+            {
+                row = Row {};
+                changedRows |= RowMask {1} << rowIndex;
+            }
+        }
+    }
+    MarkChanged(changedRows);
+}
+
+void CHIP8::Framebuffer::SetResolution(Resolution resolution)
+{
+    //the rows outside the low resolution stay unlit, so every operation may work on whole rows
+    for (auto& plane : m_planes)
+    {
+        plane.fill(Row {});
+    }
+    m_resolution = resolution;
+    MarkChanged(~RowMask {0});
+}
+
+CHIP8::Framebuffer::Resolution CHIP8::Framebuffer::GetResolution() const
+{
+    return m_resolution;
+}
+
+unsigned CHIP8::Framebuffer::GetWidth() const
+{
+    return m_resolution == Resolution::High ? HIGH_WIDTH : LOW_WIDTH;
+}
+
+unsigned CHIP8::Framebuffer::GetHeight() const
+{
+    return m_resolution == Resolution::High ? HIGH_HEIGHT : LOW_HEIGHT;
+}
+
+bool CHIP8::Framebuffer::DrawSprite(unsigned x, unsigned y, std::span<const std::byte> sprite, EdgeMode edgeMode)
+{
+    return DrawSprite(x, y, sprite, edgeMode, 8, 1);
+}
+
+bool CHIP8::Framebuffer::DrawSprite(unsigned x, unsigned y, std::span<const std::byte> sprite, EdgeMode edgeMode, unsigned spriteWidth, PlaneMask planes)
+{
+    const auto width = GetWidth(), height = GetHeight();
+    if (edgeMode == EdgeMode::Clip and (x >= width or y >= height))
+    {
+        return false;
+    }
+
+    x %= width;
+    const auto planeCount = static_cast<unsigned>(std::popcount(static_cast<unsigned>(planes & ((1U << PLANES) - 1))));
+    if (planeCount == 0)
+    {
+        return false;
+    }
+
+    const auto bytesPerRow = spriteWidth / 8;
+    const auto rowCount = static_cast<unsigned>(sprite.size()) / (bytesPerRow * planeCount);
+    const auto wordCount = GetWordCount();
+    Word collision {0};
+    RowMask changedRows {0};
+    auto spriteRow = sprite.begin();
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        if ((planes >> plane & 1) == 0)
+        {
+            continue;
+        }
+
+        for (unsigned rowOffset {0}; rowOffset < rowCount; ++rowOffset, spriteRow += bytesPerRow)
+        {
+            auto rowIndex = y + rowOffset;
+            if (edgeMode == EdgeMode::Wrap)
+            {
+                rowIndex %= height;
+            }
+            else if (rowIndex >= height)
+            {
+                //the remaining rows of this plane are clipped, the next plane starts after them
+                spriteRow += (rowCount - rowOffset) * bytesPerRow;
+                break;
+            }
+
+            //gather the sprite row at the left edge of a word
+            Word leftAligned {0};
+            for (unsigned byteIndex {0}; byteIndex < bytesPerRow; ++byteIndex)
+            {
+                leftAligned |= std::to_integer<Word>(spriteRow[byteIndex]) << (WORD_BITS - 8 * (byteIndex + 1));
+            }
+
+            if (leftAligned == 0)
+            {
+                continue;
+            }
+
+            const auto mask = PlaceSpriteRow(leftAligned, x, wordCount, edgeMode);
+            auto& row = m_planes[plane][rowIndex];
+            for (unsigned wordIndex {0}; wordIndex < wordCount; ++wordIndex)
+            {
+                collision |= row[wordIndex] & mask[wordIndex];
+                row[wordIndex] ^= mask[wordIndex];
+            }
+            changedRows |= RowMask {1} << rowIndex;
+        }
+    }
+    MarkChanged(changedRows);
+
+    return collision != 0;
+}
+
+CHIP8::Framebuffer::Row CHIP8::Framebuffer::PlaceSpriteRow(Word spriteRow, unsigned x, unsigned wordCount, EdgeMode edgeMode)
+{
+    //the sprite lands in the word holding column x and spills into the next one,
+    //past the right edge the spill is dropped or wraps around to the first word
+    Row placed {};
+    const auto wordIndex = x / WORD_BITS, shift = x % WORD_BITS;
+    placed[wordIndex] = spriteRow >> shift;
+    if (shift != 0)
+    {
+        const auto spill = spriteRow << (WORD_BITS - shift);
+        if (wordIndex + 1 < wordCount)
+        {
+            placed[wordIndex + 1] = spill;
+        }
+        else if (edgeMode == EdgeMode::Wrap)
+        {
+            placed[0] |= spill;
+        }
+    }
+    return placed;
+}
+
+CHIP8::Framebuffer::Word CHIP8::Framebuffer::PlaceSpriteRow(std::byte spriteRow, unsigned x, EdgeMode edgeMode)
+{
+    static constexpr auto SPRITE_ROW_SHIFT = std::numeric_limits<Word>::digits - 8;
+
+    //place the sprite byte at the left edge, then move it to column x,
+    //a plain shift drops the pixels past the right edge while a rotation wraps them around
+    const auto leftAligned = std::to_integer<Word>(spriteRow) << SPRITE_ROW_SHIFT;
+    return edgeMode == EdgeMode::Wrap ? std::rotr(leftAligned, x % LOW_WIDTH) : leftAligned >> x;
+}
+
+void CHIP8::Framebuffer::ScrollDown(unsigned pixels, PlaneMask planes)
+{
+    const auto height = GetHeight();
+    pixels = std::min(pixels, height);
+    if (pixels == 0)
+    {
+        return;
+    }
+
+    RowMask changedRows {0};
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        if ((planes >> plane & 1) == 0)
+        {
+            continue;
+        }
+
+        auto& rows = m_planes[plane];
+        for (auto rowIndex = height; rowIndex-- > 0;)
+        {
+            const auto row = rowIndex >= pixels ? rows[rowIndex - pixels] : Row {};
+            if (rows[rowIndex] != row)
+            {
+                rows[rowIndex] = row;
+                changedRows |= RowMask {1} << rowIndex;
+            }
+        }
+    }
+    MarkChanged(changedRows);
+}
+
+void CHIP8::Framebuffer::ScrollUp(unsigned pixels, PlaneMask planes)
+{
+    const auto height = GetHeight();
+    pixels = std::min(pixels, height);
+    if (pixels == 0)
+    {
+        return;
+    }
+
+    RowMask changedRows {0};
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        if ((planes >> plane & 1) == 0)
+        {
+            continue;
+        }
+
+        auto& rows = m_planes[plane];
+        for (unsigned rowIndex {0}; rowIndex < height; ++rowIndex)
+        {
+            const auto row = rowIndex + pixels < height ? rows[rowIndex + pixels] : Row {};
+            if (rows[rowIndex] != row)
+            {
+                rows[rowIndex] = row;
+                changedRows |= RowMask {1} << rowIndex;
+            }
+        }
+    }
+    MarkChanged(changedRows);
+}
+
+void CHIP8::Framebuffer::ScrollRight(unsigned pixels, PlaneMask planes)
+{
+    if (pixels == 0)
+    {
+        return;
+    }
+
+    const auto wordCount = GetWordCount(), height = GetHeight();
+    const auto wordShift = pixels / WORD_BITS, bitShift = pixels % WORD_BITS;
+    RowMask changedRows {0};
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        if ((planes >> plane & 1) == 0)
+        {
+            continue;
+        }
+
+        for (unsigned rowIndex {0}; rowIndex < height; ++rowIndex)
+        {
+            auto& row = m_planes[plane][rowIndex];
+            //each word takes the pixels shifted out of the word to the left of its source
+            Row scrolled {};
+            for (auto wordIndex = wordShift; wordIndex < wordCount; ++wordIndex)
+            {
+                const auto source = wordIndex - wordShift;
+                scrolled[wordIndex] = row[source] >> bitShift;
+                if (bitShift != 0 and source > 0)
+                {
+                    scrolled[wordIndex] |= row[source - 1] << (WORD_BITS - bitShift);
+                }
+            }
+
+            if (row != scrolled)
+            {
+                row = scrolled;
+                changedRows |= RowMask {1} << rowIndex;
+            }
+        }
+    }
+    MarkChanged(changedRows);
+}
+
+void CHIP8::Framebuffer::ScrollLeft(unsigned pixels, PlaneMask planes)
+{
+    if (pixels == 0)
+    {
+        return;
+    }
+
+    const auto wordCount = GetWordCount(), height = GetHeight();
+    const auto wordShift = pixels / WORD_BITS, bitShift = pixels % WORD_BITS;
+    RowMask changedRows {0};
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        if ((planes >> plane & 1) == 0)
+        {
+            continue;
+        }
+
+        for (unsigned rowIndex {0}; rowIndex < height; ++rowIndex)
+        {
+            auto& row = m_planes[plane][rowIndex];
+            //each word takes the pixels shifted out of the word to the right of its source
+            Row scrolled {};
+            for (unsigned wordIndex {0}; wordIndex + wordShift < wordCount; ++wordIndex)
+            {
+                const auto source = wordIndex + wordShift;
+                scrolled[wordIndex] = row[source] << bitShift;
+                if (bitShift != 0 and source + 1 < wordCount)
+                {
+                    scrolled[wordIndex] |= row[source + 1] >> (WORD_BITS - bitShift);
+                }
+            }
+
+            if (row != scrolled)
+            {
+                row = scrolled;
+                changedRows |= RowMask {1} << rowIndex;
+            }
+        }
+    }
+    MarkChanged(changedRows);
+}
+
+std::uint8_t CHIP8::Framebuffer::GetPixel(unsigned x, unsigned y) const
+{
+    std::uint8_t color {0};
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        const auto word = m_planes[plane].at(y).at(x / WORD_BITS);
+        color |= ((word >> (WORD_BITS - 1 - x % WORD_BITS)) & 1) << plane;
+    }
+    return color;
+}
+
+const CHIP8::Framebuffer::Plane& CHIP8::Framebuffer::GetPlane(unsigned plane) const
+{
+    return m_planes.at(plane);
+}
+
+void CHIP8::Framebuffer::SetPlanes(Resolution resolution, std::span<const Plane, PLANES> planes)
+{
+    RowMask changedRows {resolution != m_resolution ? ~RowMask {0} : RowMask {0}};
+    m_resolution = resolution;
+    for (unsigned plane {0}; plane < PLANES; ++plane)
+    {
+        for (unsigned rowIndex {0}; rowIndex < HIGH_HEIGHT; ++rowIndex)
+        {
+            if (m_planes[plane][rowIndex] != planes[plane][rowIndex])
+            {
+                m_planes[plane][rowIndex] = planes[plane][rowIndex];
+                changedRows |= RowMask {1} << rowIndex;
+            }
+        }
+    }
+    MarkChanged(changedRows);
+}
+
+void CHIP8::Framebuffer::Update(const Framebuffer& source)
+{
+    //rows untouched since this copy was taken are already equal
+    for (auto changedRows = source.ChangedRowsSince(m_generation); changedRows != 0; changedRows &= changedRows - 1)
+    {
+        const auto rowIndex = std::countr_zero(changedRows);
+        for (unsigned plane {0}; plane < PLANES; ++plane)
+        {
+            m_planes[plane][rowIndex] = source.m_planes[plane][rowIndex];
+        }
+        m_rowGenerations[rowIndex] = source.m_rowGenerations[rowIndex];
+    }
+    m_resolution = source.m_resolution;
+    m_generation = source.m_generation;
+}
+
+CHIP8::Framebuffer::Generation CHIP8::Framebuffer::GetGeneration() const
+{
+    return m_generation;
+}
+
+CHIP8::Framebuffer::RowMask CHIP8::Framebuffer::ChangedRowsSince(Generation generation) const
+{
+    RowMask changedRows {0};
+    for (unsigned rowIndex {0}; rowIndex < HIGH_HEIGHT; ++rowIndex)
+    {
+        if (m_rowGenerations[rowIndex] > generation)
+        {
+            changedRows |= RowMask {1} << rowIndex;
+        }
+    }
+    return changedRows;
+}
+
+bool CHIP8::Framebuffer::operator==(const Framebuffer& other) const
+{
+    return m_resolution == other.m_resolution and m_planes == other.m_planes;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace CHIP8
+{
+    //display of SUPER-CHIP and XO-CHIP with up to two bitplanes, whose pixels select one of four colors;
+    //every row of a plane is packed into 64-bit words, the most significant bit of the first word is the leftmost pixel;
+    //the low resolution only uses the first word of the first 32 rows, so it costs as much as the original display
+    class Framebuffer
+    {
+    public:
+        static constexpr unsigned 
+            LOW_WIDTH = 64, 
+            LOW_HEIGHT = 32, 
+            HIGH_WIDTH = 128, 
+            HIGH_HEIGHT = 64, 
+            PLANES = 2;
+        using Word = std::uint64_t;
+        static constexpr unsigned WORD_BITS = 64, WORDS_PER_ROW = HIGH_WIDTH / WORD_BITS;
+        using Row = std::array<Word, WORDS_PER_ROW>;
+        using Plane = std::array<Row, HIGH_HEIGHT>;
+        //bit i is set when row i is included
+        using RowMask = std::uint64_t;
+        //counts the changes made to the display, a newer frame has a higher generation
+        using Generation = std::uint64_t;
+        //bit p selects plane p
+        using PlaneMask = std::uint8_t;
+
+        //what happens to sprite pixels which cross the edge of the display
+        enum class EdgeMode
+        {
+            Clip,
+            Wrap
+        };
+
+        enum class Resolution : std::uint8_t
+        {
+            //64x32
+            Low,
+            //128x64
+            High
+        };
+
+    private:
+        std::array<Plane, PLANES> m_planes;
+        Resolution m_resolution;
+        Generation m_generation;
+        //generation of the last change of each row
+        std::array<Generation, HIGH_HEIGHT> m_rowGenerations;
+
+        unsigned GetWordCount() const;
+        void MarkChanged(RowMask rows);
+        //sprite pixels left aligned in a word, moved to column x of a row wordCount words wide
+        static Row PlaceSpriteRow(Word spriteRow, unsigned x, unsigned wordCount, EdgeMode edgeMode);
+
+    public:
+        Framebuffer();
+        //clears the selected planes
+        void Clear(PlaneMask planes = 1);
+        //switching the resolution clears every plane
+        void SetResolution(Resolution resolution);
+        Resolution GetResolution() const;
+        unsigned GetWidth() const;
+        unsigned GetHeight() const;
+        //XORs a sprite 8 pixels wide onto the first plane, returns whether any lit pixel was erased
+        bool DrawSprite(unsigned x, unsigned y, std::span<const std::byte> sprite, EdgeMode edgeMode);
+        //XORs a sprite 8 or 16 pixels wide onto the selected planes, the sprite holds the rows of every selected plane one after another;
+        //returns whether any lit pixel was erased
+        bool DrawSprite(unsigned x, unsigned y, std::span<const std::byte> sprite, EdgeMode edgeMode, unsigned spriteWidth, PlaneMask planes);
+        //moves the selected planes by whole pixels of the current resolution, pixels moved in are unlit
+        void ScrollDown(unsigned pixels, PlaneMask planes);
+        void ScrollUp(unsigned pixels, PlaneMask planes);
+        void ScrollRight(unsigned pixels, PlaneMask planes);
+        void ScrollLeft(unsigned pixels, PlaneMask planes);
+        //color of the pixel, bit p is the pixel in plane p
+        std::uint8_t GetPixel(unsigned x, unsigned y) const;
+        //pixels of one sprite row moved to column x of a row in the low resolution, as XORed onto the display
+        static Word PlaceSpriteRow(std::byte spriteRow, unsigned x, EdgeMode edgeMode);
+        const Plane& GetPlane(unsigned plane) const;
+        //replaces the resolution and every row, the rows which differ count as changed
+        void SetPlanes(Resolution resolution, std::span<const Plane, PLANES> planes);
+        //brings a copy taken earlier from the source up to date, only the rows changed since then are copied
+        void Update(const Framebuffer& source);
+        Generation GetGeneration() const;
+        //rows which were modified after the given generation
+        RowMask ChangedRowsSince(Generation generation) const;
+        //compares the resolution and pixels only
+        bool operator==(const Framebuffer& other) const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,567 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "gdbStub.hpp"
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    //largest packet the debugger may send, memory is read in pieces which fit into it
+    constexpr std::size_t MAX_PACKET_SIZE = 4096;
+    //the g packet holds V0 to VF, then I and PC in little-endian order, also numbered so by p and P
+    constexpr std::size_t V_REGISTER_COUNT = 16, ADDRESS_REGISTER_NUMBER = 16, PROGRAM_COUNTER_NUMBER = 17;
+    //stop replies report these signals
+    constexpr unsigned SIGINT_NUMBER = 2, SIGILL_NUMBER = 4, SIGTRAP_NUMBER = 5;
+
+    const std::string& GetTargetDescription()
+    {
+        //GDB has no CHIP-8 architecture, the registers are described instead
+        static const auto description = []
+        {
+            std::string xml = 
+                "<?xml version=\"1.0\"?>\n"
+                "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+                "<target version=\"1.0\">\n"
+                "<feature name=\"org.chip8.core\">\n";
+            for (std::size_t index {0}; index < V_REGISTER_COUNT; ++index)
+            {
+                xml += std::format("<reg name=\"v{:x}\" bitsize=\"8\" type=\"uint8\" regnum=\"{}\"/>\n", index, index);
+            }
+            xml += std::format("<reg name=\"i\" bitsize=\"16\" type=\"data_ptr\" regnum=\"{}\"/>\n", ADDRESS_REGISTER_NUMBER);
+            xml += std::format("<reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\" regnum=\"{}\"/>\n", PROGRAM_COUNTER_NUMBER);
+            xml += "</feature>\n</target>\n";
+            return xml;
+        }();
+        return description;
+    }
+
+    std::optional<std::uint64_t> ParseHex(std::string_view text)
+    {
+        std::uint64_t value;
+        const auto [end, errc] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+        if (text.empty() or errc != std::errc {} or end != text.data() + text.size())
+        {
+            return {};
+        }
+        return value;
+    }
+
+    std::optional<std::vector<std::byte>> ParseHexBytes(std::string_view text)
+    {
+        if (text.size() % 2 != 0)
+        {
+            return {};
+        }
+        std::vector<std::byte> bytes;
+        for (std::size_t position {0}; position < text.size(); position += 2)
+        {
+            const auto value = ParseHex(text.substr(position, 2));
+            if (not value.has_value())
+            {
+                return {};
+            }
+            bytes.push_back(static_cast<std::byte>(*value));
+        }
+        return bytes;
+    }
+
+    //in little-endian order, as GDB expects register values
+    void AppendHex(std::string& text, std::uint64_t value, std::size_t byteCount)
+    {
+        for (std::size_t byteIndex {0}; byteIndex < byteCount; ++byteIndex)
+        {
+            text += std::format("{:02x}", (value >> (8 * byteIndex)) & 0xFF);
+        }
+    }
+
+    std::uint16_t ToLittleEndianWord(std::span<const std::byte> bytes)
+    {
+        return static_cast<std::uint16_t>(std::to_integer<unsigned>(bytes[0]) | (std::to_integer<unsigned>(bytes[1]) << 8));
+    }
+
+    //splits "a,b" or "a:b" at the first separator
+    std::pair<std::string_view, std::string_view> Split(std::string_view text, char separator)
+    {
+        const auto position = text.find(separator);
+        if (position == std::string_view::npos)
+        {
+            return {text, {}};
+        }
+        return {text.substr(0, position), text.substr(position + 1)};
+    }
+}
+
+CHIP8::GdbStub::GdbStub(VirtualMachine& virtualMachine, std::uint16_t port)
+    :
+    m_virtualMachine(virtualMachine),
+    m_acceptor(virtualMachine.GetIoContext(), asio::ip::tcp::endpoint {asio::ip::address_v4::loopback(), port}),
+    m_socket(virtualMachine.GetIoContext()),
+    m_readBuffer(),
+    m_acknowledging(true),
+    m_running(false)
+{
+    //the program starts stopped, until a debugger continues it
+    m_virtualMachine.Pause();
+    Accept();
+}
+
+void CHIP8::GdbStub::Accept()
+{
+    m_acceptor.async_accept(m_socket, [this](const boost::system::error_code& errc)
+    {
+        if (errc)
+        {
+            return;
+        }
+        //a debugger finds the program stopped
+        m_running = false;
+        m_input.clear();
+        m_lastPacket.clear();
+        m_acknowledging = true;
+        m_virtualMachine.AttachDebugger([this](std::exception_ptr failure)
+        {
+            OnStop(failure);
+        });
+        Read();
+    });
+}
+
+void CHIP8::GdbStub::Read()
+{
+    m_socket.async_read_some(asio::buffer(m_readBuffer), [this](const boost::system::error_code& errc, std::size_t length)
+    {
+        OnRead(errc, length);
+    });
+}
+
+void CHIP8::GdbStub::OnRead(const boost::system::error_code& errc, std::size_t length)
+{
+    if (errc)
+    {
+        if (errc != asio::error::operation_aborted)
+        {
+            Disconnect();
+        }
+        return;
+    }
+
+    m_input.append(m_readBuffer.data(), length);
+    ProcessInput();
+    if (m_socket.is_open())
+    {
+        Read();
+    }
+}
+
+void CHIP8::GdbStub::Disconnect()
+{
+    boost::system::error_code ignored;
+    m_socket.close(ignored);
+    //the program runs on in the hands of Run
+    m_running = false;
+    m_virtualMachine.DetachDebugger();
+    Accept();
+}
+
+void CHIP8::GdbStub::ProcessInput()
+{
+    while (not m_input.empty() and m_socket.is_open())
+    {
+        const auto first = m_input.front();
+        //sent on its own when the user interrupts the program
+        if (first == '\x03')
+        {
+            m_input.erase(0, 1);
+            if (m_running)
+            {
+                m_running = false;
+                m_virtualMachine.Pause();
+                SendPacket(std::format("S{:02x}", SIGINT_NUMBER));
+            }
+            continue;
+        }
+        if (first == '-' and not m_lastPacket.empty())
+        {
+            Write(m_lastPacket);
+        }
+        //acknowledgements and noise between packets
+        if (first != '$')
+        {
+            m_input.erase(0, 1);
+            continue;
+        }
+
+        //$payload#checksum, the checksum being two hex digits
+        const auto end = m_input.find('#');
+        if (end == std::string::npos or end + 3 > m_input.size())
+        {
+            return;
+        }
+        const auto payload = m_input.substr(1, end - 1);
+        const auto checksum = ParseHex(std::string_view {m_input}.substr(end + 1, 2));
+        m_input.erase(0, end + 3);
+
+        if (m_acknowledging)
+        {
+            std::uint8_t sum {0};
+            for (const auto character : payload)
+            {
+                sum += static_cast<std::uint8_t>(character);
+            }
+            if (not checksum.has_value() or *checksum != sum)
+            {
+                Write("-");
+                continue;
+            }
+            Write("+");
+        }
+
+        const auto reply = HandlePacket(payload);
+        if (reply.has_value())
+        {
+            SendPacket(*reply);
+        }
+    }
+}
+
+std::optional<std::string> CHIP8::GdbStub::HandlePacket(std::string_view packet)
+{
+    if (packet.empty())
+    {
+        return "";
+    }
+
+    const auto arguments = packet.substr(1);
+    switch (packet.front())
+    {
+        case '?':
+            return std::format("S{:02x}", SIGTRAP_NUMBER);
+
+        case 'g':
+            return ReadRegisters();
+
+        case 'G':
+            return WriteRegisters(arguments);
+
+        case 'p':
+        case 'P':
+        {
+            //p and P work on the register's place in the g packet, so both are checked the same way
+            const auto [numberText, valueText] = Split(arguments, '=');
+            const auto number = ParseHex(numberText);
+            if (not number.has_value() or *number > PROGRAM_COUNTER_NUMBER)
+            {
+                return "E01";
+            }
+            const auto position = *number < V_REGISTER_COUNT ? 2 * *number : 2 * V_REGISTER_COUNT + 4 * (*number - ADDRESS_REGISTER_NUMBER);
+            const std::size_t width = *number < V_REGISTER_COUNT ? 2 : 4;
+            auto registers = ReadRegisters();
+            if (packet.front() == 'p')
+            {
+                return registers.substr(position, width);
+            }
+            if (valueText.size() != width)
+            {
+                return "E01";
+            }
+            registers.replace(position, width, valueText);
+            return WriteRegisters(registers);
+        }
+
+        case 'm':
+            return ReadMemory(arguments);
+
+        case 'M':
+            return WriteMemory(arguments);
+
+        case 'c':
+        case 's':
+        {
+            //may give the address to resume at
+            if (not arguments.empty())
+            {
+                const auto address = ParseHex(arguments);
+                if (not address.has_value() or *address >= m_virtualMachine.GetMemory().size())
+                {
+                    return "E01";
+                }
+                m_virtualMachine.SetProgramCounter(static_cast<std::uint16_t>(*address));
+            }
+            if (packet.front() == 'c')
+            {
+                Resume();
+            }
+            else
+            {
+                Step();
+            }
+            return {};
+        }
+
+        case 'Z':
+            return SetStopPoint(arguments, true);
+
+        case 'z':
+            return SetStopPoint(arguments, false);
+
+        //there is only one thread
+        case 'H':
+            return "OK";
+
+        case 'D':
+            SendPacket("OK");
+            Disconnect();
+            return {};
+
+        case 'k':
+        {
+            boost::system::error_code ignored;
+            m_socket.close(ignored);
+            m_virtualMachine.Stop();
+            return {};
+        }
+
+        case 'q':
+            if (arguments.starts_with("Supported"))
+            {
+                return std::format("PacketSize={:x};qXfer:features:read+;QStartNoAckMode+", MAX_PACKET_SIZE);
+            }
+            if (arguments.starts_with("Xfer:features:read:target.xml:"))
+            {
+                return ReadFeatures(arguments.substr(std::string_view {"Xfer:features:read:target.xml:"}.size()));
+            }
+            if (arguments == "Attached")
+            {
+                return "1";
+            }
+            return "";
+
+        case 'Q':
+            if (arguments == "StartNoAckMode")
+            {
+                m_acknowledging = false;
+                return "OK";
+            }
+            return "";
+
+        //anything else is not supported, which an empty reply tells
+        default:
+            return "";
+    }
+}
+
+void CHIP8::GdbStub::Write(std::string_view data)
+{
+    //a connection which broke is noticed by the pending read
+    boost::system::error_code ignored;
+    asio::write(m_socket, asio::buffer(data), ignored);
+}
+
+void CHIP8::GdbStub::SendPacket(std::string_view payload)
+{
+    std::uint8_t sum {0};
+    for (const auto character : payload)
+    {
+        sum += static_cast<std::uint8_t>(character);
+    }
+    m_lastPacket = std::format("${}#{:02x}", payload, sum);
+    Write(m_lastPacket);
+}
+
+void CHIP8::GdbStub::SendConsoleOutput(std::string_view text)
+{
+    std::string packet {"O"};
+    for (const auto character : text)
+    {
+        AppendHex(packet, static_cast<std::uint8_t>(character), 1);
+    }
+    SendPacket(packet);
+}
+
+std::string CHIP8::GdbStub::ReadRegisters() const
+{
+    std::string registers;
+    for (const auto value : m_virtualMachine.GetRegisters())
+    {
+        AppendHex(registers, std::to_integer<std::uint8_t>(value), 1);
+    }
+    AppendHex(registers, m_virtualMachine.GetAddressRegister(), 2);
+    AppendHex(registers, m_virtualMachine.GetProgramCounter(), 2);
+    return registers;
+}
+
+std::string CHIP8::GdbStub::WriteRegisters(std::string_view hexData)
+{
+    const auto bytes = ParseHexBytes(hexData);
+    if (not bytes.has_value() or bytes->size() != V_REGISTER_COUNT + 4)
+    {
+        return "E01";
+    }
+    for (std::size_t index {0}; index < V_REGISTER_COUNT; ++index)
+    {
+        m_virtualMachine.SetRegister(index, (*bytes)[index]);
+    }
+    const std::span registerBytes {*bytes};
+    m_virtualMachine.SetAddressRegister(ToLittleEndianWord(registerBytes.subspan(V_REGISTER_COUNT, 2)));
+    m_virtualMachine.SetProgramCounter(ToLittleEndianWord(registerBytes.subspan(V_REGISTER_COUNT + 2, 2)));
+    return "OK";
+}
+
+std::string CHIP8::GdbStub::ReadMemory(std::string_view arguments) const
+{
+    const auto [addressText, lengthText] = Split(arguments, ',');
+    const auto address = ParseHex(addressText);
+    const auto length = ParseHex(lengthText);
+    const auto memory = m_virtualMachine.GetMemory();
+    if (not address.has_value() or not length.has_value() or *address >= memory.size())
+    {
+        return "E01";
+    }
+
+    //a read past the end of memory returns what there is
+    const auto readLength = std::min({*length, memory.size() - *address, MAX_PACKET_SIZE / 2});
+    std::string contents;
+    for (const auto value : memory.subspan(*address, readLength))
+    {
+        AppendHex(contents, std::to_integer<std::uint8_t>(value), 1);
+    }
+    return contents;
+}
+
+std::string CHIP8::GdbStub::WriteMemory(std::string_view arguments)
+{
+    const auto [range, data] = Split(arguments, ':');
+    const auto [addressText, lengthText] = Split(range, ',');
+    const auto address = ParseHex(addressText);
+    const auto length = ParseHex(lengthText);
+    const auto bytes = ParseHexBytes(data);
+    const auto memorySize = m_virtualMachine.GetMemory().size();
+    if (not address.has_value() or not length.has_value() or not bytes.has_value() or bytes->size() != *length or 
+        *address >= memorySize or *length > memorySize - *address)
+    {
+        return "E01";
+    }
+    m_virtualMachine.WriteMemory(static_cast<std::uint16_t>(*address), *bytes);
+    return "OK";
+}
+
+std::string CHIP8::GdbStub::SetStopPoint(std::string_view arguments, bool enabled)
+{
+    //type,address,kind where kind is the length of a watchpoint
+    const auto [typeText, rest] = Split(arguments, ',');
+    const auto [addressText, kindText] = Split(rest, ',');
+    const auto address = ParseHex(addressText);
+    const auto kind = ParseHex(kindText);
+    if (not address.has_value() or not kind.has_value() or *address >= m_virtualMachine.GetMemory().size())
+    {
+        return "E01";
+    }
+
+    //software and hardware breakpoints are the same bit, only writes can be watched
+    if (typeText == "0" or typeText == "1")
+    {
+        m_virtualMachine.SetBreakpoint(static_cast<std::uint16_t>(*address), enabled);
+        return "OK";
+    }
+    if (typeText == "2")
+    {
+        m_virtualMachine.SetWatchpoint(static_cast<std::uint16_t>(*address), *kind, enabled);
+        return "OK";
+    }
+    return "";
+}
+
+std::string CHIP8::GdbStub::ReadFeatures(std::string_view arguments) const
+{
+    const auto [offsetText, lengthText] = Split(arguments, ',');
+    const auto offset = ParseHex(offsetText);
+    const auto length = ParseHex(lengthText);
+    const auto& description = GetTargetDescription();
+    if (not offset.has_value() or not length.has_value())
+    {
+        return "E01";
+    }
+    if (*offset >= description.size())
+    {
+        return "l";
+    }
+    //m if there is more to read, l for the last part
+    const auto part = description.substr(*offset, *length);
+    return (*offset + part.size() < description.size() ? "m" : "l") + part;
+}
+
+void CHIP8::GdbStub::Resume()
+{
+    if (m_running)
+    {
+        return;
+    }
+    m_running = true;
+    m_virtualMachine.Resume();
+}
+
+void CHIP8::GdbStub::Step()
+{
+    bool failed {false};
+    try
+    {
+        m_virtualMachine.Execute(1);
+    }
+    catch (const std::exception& e)
+    {
+        failed = true;
+        SendConsoleOutput(std::format("{}\n", e.what()));
+    }
+    SendPacket(DescribeStop(failed));
+}
+
+void CHIP8::GdbStub::OnStop(std::exception_ptr failure)
+{
+    m_running = false;
+    if (failure)
+    {
+        try
+        {
+            std::rethrow_exception(failure);
+        }
+        catch (const std::exception& e)
+        {
+            SendConsoleOutput(std::format("{}\n", e.what()));
+        }
+    }
+    SendPacket(DescribeStop(failure != nullptr));
+}
+
+std::string CHIP8::GdbStub::DescribeStop(bool failed) const
+{
+    if (failed)
+    {
+        return std::format("S{:02x}", SIGILL_NUMBER);
+    }
+    const auto stop = m_virtualMachine.GetDebugStop();
+    if (stop.reason == VirtualMachine::DebugStopReason::Watchpoint)
+    {
+        return std::format("T{:02x}watch:{:x};", SIGTRAP_NUMBER, stop.address);
+    }
+    return std::format("S{:02x}", SIGTRAP_NUMBER);
+}
\ No newline at end of file
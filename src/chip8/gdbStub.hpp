@@ -0,0 +1,86 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <boost/asio.hpp>
+#include "chip8vm.hpp"
+
+namespace CHIP8
+{
+    namespace asio = boost::asio;
+
+    //serves GDB's remote serial protocol on a port of localhost, one debugger at a time; it reads and writes
+    //the registers and memory of the VM, steps it and sets breakpoints and write watchpoints;
+    //the connection is served on the io_context of the VM, whose Run keeps the program paused
+    //until the debugger continues it or detaches
+    class GdbStub
+    {
+        VirtualMachine& m_virtualMachine;
+        asio::ip::tcp::acceptor m_acceptor;
+        asio::ip::tcp::socket m_socket;
+        std::array<char, 1024> m_readBuffer;
+        //received bytes which do not form a whole packet yet
+        std::string m_input;
+        //sent again if the debugger did not receive it intact
+        std::string m_lastPacket;
+        //until the debugger turns acknowledgements off
+        bool m_acknowledging;
+        //set while the debugger waits for the program to stop
+        bool m_running;
+
+        void Accept();
+        void Read();
+        void OnRead(const boost::system::error_code& errc, std::size_t length);
+        //lets the program run on without a debugger, which may connect again
+        void Disconnect();
+        void ProcessInput();
+        //returns the reply, none is sent yet for packets which resume the program
+        std::optional<std::string> HandlePacket(std::string_view packet);
+        void Write(std::string_view data);
+        void SendPacket(std::string_view payload);
+        //text the debugger prints on its console
+        void SendConsoleOutput(std::string_view text);
+
+        std::string ReadRegisters() const;
+        std::string WriteRegisters(std::string_view hexData);
+        std::string ReadMemory(std::string_view arguments) const;
+        std::string WriteMemory(std::string_view arguments);
+        std::string SetStopPoint(std::string_view arguments, bool enabled);
+        std::string ReadFeatures(std::string_view arguments) const;
+
+        void Resume();
+        void Step();
+        //called by the VM once a frame stopped for the debugger or failed
+        void OnStop(std::exception_ptr failure);
+        //stop reply for why the program stopped running
+        std::string DescribeStop(bool failed) const;
+
+    public:
+        //listens on the port and pauses the VM, throws boost::system::system_error if it cannot listen;
+        //debuggers are served while the VM runs, a debugger killing the program stops it
+        GdbStub(VirtualMachine& virtualMachine, std::uint16_t port);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "inputLog.hpp"
+#include <array>
+#include <format>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include "littleEndian.hpp"
+
+namespace
+{
+    constexpr std::array<char, 4> MAGIC {'C', '8', 'I', 'L'};
+    constexpr std::uint16_t VERSION = 1;
+    constexpr std::uint16_t WRAP_SPRITES_FLAG = 1;
+    //frames are flushed this often, so a crash loses at most a second of input
+    constexpr std::size_t FLUSH_PERIOD = 60;
+}
+
+std::uint64_t CHIP8::InputLog::HashProgram(std::span<const std::byte> program)
+{
+    std::uint64_t hash {0xCBF29CE484222325};
+    for (const auto byte : program)
+    {
+        hash = (hash ^ std::to_integer<std::uint64_t>(byte)) * 0x100000001B3;
+    }
+    return hash;
+}
+
+CHIP8::InputLog CHIP8::InputLog::Load(const std::filesystem::path& path)
+{
+    std::ifstream file {path, std::ios::in | std::ios::binary};
+    if (not file.is_open())
+    {
+        throw std::runtime_error {std::format("Cannot open input log {}", path.string())};
+    }
+
+    std::array<char, MAGIC.size()> magic;
+    std::uint16_t version, quirkProfile, flags;
+    InputLog log;
+    if (not file.read(magic.data(), magic.size()) or magic != MAGIC or 
+        not ReadLittleEndian(file, version) or version != VERSION or 
+        not ReadLittleEndian(file, quirkProfile) or quirkProfile > static_cast<std::uint16_t>(QuirkProfile::Legacy) or 
+        not ReadLittleEndian(file, flags) or 
+        not ReadLittleEndian(file, log.header.programHash) or 
+        not ReadLittleEndian(file, log.header.randomSeed) or 
+        not ReadLittleEndian(file, log.header.clockSpeed))
+    {
+        throw std::runtime_error {std::format("{} is not an input log", path.string())};
+    }
+    log.header.quirkProfile = static_cast<QuirkProfile>(quirkProfile);
+    log.header.wrapSprites = (flags & WRAP_SPRITES_FLAG) != 0;
+
+    std::uint16_t pressedKeys;
+    while (ReadLittleEndian(file, pressedKeys))
+    {
+        log.frames.push_back(pressedKeys);
+    }
+    return log;
+}
+
+CHIP8::RecordingKeyboard::RecordingKeyboard(std::unique_ptr<Keyboard> source, const std::filesystem::path& path, const InputLog::Header& header)
+    :
+    m_source(std::move(source)),
+    m_file(path, std::ios::out | std::ios::binary | std::ios::trunc),
+    m_frameCount(0)
+{
+    if (not m_file.is_open())
+    {
+        throw std::runtime_error {std::format("Cannot write input log {}", path.string())};
+    }
+
+    m_file.write(MAGIC.data(), MAGIC.size());
+    WriteLittleEndian(m_file, VERSION);
+    WriteLittleEndian(m_file, static_cast<std::uint16_t>(header.quirkProfile));
+    WriteLittleEndian(m_file, header.wrapSprites ? WRAP_SPRITES_FLAG : std::uint16_t {0});
+    WriteLittleEndian(m_file, header.programHash);
+    WriteLittleEndian(m_file, header.randomSeed);
+    WriteLittleEndian(m_file, header.clockSpeed);
+    m_file.flush();
+}
+
+void CHIP8::RecordingKeyboard::BeginFrame()
+{
+    //the source may latch its keys for the frame as well
+    m_source->BeginFrame();
+    const auto pressedKeys = m_source->GetPressedKeys();
+    SetPressedKeys(pressedKeys);
+
+    WriteLittleEndian(m_file, pressedKeys);
+    m_frameCount += 1;
+    if (m_frameCount % FLUSH_PERIOD == 0)
+    {
+        m_file.flush();
+    }
+}
+
+void CHIP8::RecordingKeyboard::SkipFrames(std::size_t frameCount)
+{
+    m_source->SkipFrames(frameCount);
+    const auto pressedKeys = GetPressedKeys();
+    for (std::size_t frame {0}; frame < frameCount; ++frame)
+    {
+        WriteLittleEndian(m_file, pressedKeys);
+    }
+    m_frameCount += frameCount;
+    m_file.flush();
+}
+
+CHIP8::ReplayKeyboard::ReplayKeyboard(std::vector<std::uint16_t> frames)
+    :
+    m_frames(std::move(frames)),
+    m_nextFrame(0)
+{
+
+}
+
+void CHIP8::ReplayKeyboard::BeginFrame()
+{
+    SetPressedKeys(m_nextFrame < m_frames.size() ? m_frames[m_nextFrame] : 0);
+    m_nextFrame += 1;
+}
+
+void CHIP8::ReplayKeyboard::SkipFrames(std::size_t frameCount)
+{
+    m_nextFrame += frameCount;
+}
\ No newline at end of file
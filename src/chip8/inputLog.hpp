@@ -0,0 +1,84 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include "keyboard.hpp"
+#include "quirks.hpp"
+
+namespace CHIP8
+{
+    //keys held down in each frame of a run, with the settings needed to run it again the same way;
+    //stored as a header followed by one little-endian 16-bit key mask per frame
+    struct InputLog
+    {
+        struct Header
+        {
+            //FNV-1a of the program the log was recorded with
+            std::uint64_t programHash;
+            std::uint32_t randomSeed;
+            std::uint32_t clockSpeed;
+            QuirkProfile quirkProfile;
+            //sprites wrap around the edges of the display whatever the quirk profile says
+            bool wrapSprites;
+        };
+
+        Header header;
+        //bit k is set while key k is held down
+        std::vector<std::uint16_t> frames;
+
+        static std::uint64_t HashProgram(std::span<const std::byte> program);
+        //throws std::runtime_error if the file cannot be read or is not an input log
+        static InputLog Load(const std::filesystem::path& path);
+    };
+
+    //samples another keyboard at the start of every frame and appends what it saw to an input log file
+    class RecordingKeyboard : public LatchedKeyboard
+    {
+        std::unique_ptr<Keyboard> m_source;
+        std::ofstream m_file;
+        std::size_t m_frameCount;
+
+    public:
+        //throws std::runtime_error if the file cannot be written
+        RecordingKeyboard(std::unique_ptr<Keyboard> source, const std::filesystem::path& path, const InputLog::Header& header);
+        void BeginFrame() override;
+        //repeats the keys of the last frame, so a replay sees them for as long as they were held
+        void SkipFrames(std::size_t frameCount) override;
+    };
+
+    //plays the frames of an input log back, no keys are pressed after its end
+    class ReplayKeyboard : public LatchedKeyboard
+    {
+        std::vector<std::uint16_t> m_frames;
+        std::size_t m_nextFrame;
+
+    public:
+        explicit ReplayKeyboard(std::vector<std::uint16_t> frames);
+        void BeginFrame() override;
+        void SkipFrames(std::size_t frameCount) override;
+    };
+}
\ No newline at end of file
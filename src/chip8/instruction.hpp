@@ -0,0 +1,64 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace CHIP8
+{
+    class VirtualMachine;
+
+    //operands of an opcode, extracted once when the opcode is predecoded
+    struct DecodedOpcode
+    {
+        std::uint16_t opcode, nnn;
+        std::uint8_t x, y, n, nn;
+
+        constexpr DecodedOpcode(std::uint16_t opcode = 0)
+            :
+            opcode(opcode),
+            nnn(opcode & 0x0FFF),
+            x((opcode >> 8) & 0xF),
+            y((opcode >> 4) & 0xF),
+            n(opcode & 0xF),
+            nn(opcode & 0xFF)
+        {
+
+        }
+    };
+
+    //XO-CHIP's F000 nnnn is followed by a second word holding its address
+    constexpr bool IsLongInstruction(std::uint16_t opcode)
+    {
+        return opcode == 0xF000;
+    }
+
+    struct PredecodedInstruction;
+
+    using Instruction = void (*)(VirtualMachine& vm, const PredecodedInstruction&);
+
+    //final handler of an opcode together with its operands;
+    //superinstructions also carry the operands of the opcode fused into them,
+    //fusedOperands.opcode is zero for every other instruction
+    struct PredecodedInstruction
+    {
+        Instruction handler;
+        DecodedOpcode operands, fusedOperands;
+    };
+}
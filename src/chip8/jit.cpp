@@ -0,0 +1,807 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "jit.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <numeric>
+#include <optional>
+#include <ranges>
+
+#if defined(__x86_64__) and defined(__unix__)
+    #define CHIP8_JIT_SUPPORTED
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace
+{
+    enum HostRegister : std::uint8_t
+    {
+        RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11, R12, R13, R14, R15
+    };
+
+    enum class AluOperation : std::uint8_t
+    {
+        Add = 0, Or = 1, And = 4, Sub = 5, Xor = 6, Cmp = 7
+    };
+
+    //minimal x86-64 assembler, only the forms the compiler needs
+    class X64Emitter
+    {
+        std::vector<std::uint8_t> m_code;
+
+        void Byte(std::uint8_t value)
+        {
+            m_code.push_back(value);
+        }
+
+        template <typename T>
+        void Immediate(T value)
+        {
+            for (const auto byteIndex : std::views::iota(0UZ, sizeof(T)))
+            {
+                Byte(static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (byteIndex * 8)));
+            }
+        }
+
+        //byte operations always get a prefix so that SPL..DIL are addressed instead of AH..BH
+        void Rex(bool wide, std::uint8_t reg, std::uint8_t rm, bool forced = false)
+        {
+            const std::uint8_t rex = 0x40 | (wide << 3) | ((reg >> 3) << 2) | (rm >> 3);
+            if (rex != 0x40 or forced)
+            {
+                Byte(rex);
+            }
+        }
+
+        void ModRM(std::uint8_t mod, std::uint8_t reg, std::uint8_t rm)
+        {
+            Byte((mod << 6) | ((reg & 7) << 3) | (rm & 7));
+        }
+
+    public:
+        std::size_t Size() const
+        {
+            return m_code.size();
+        }
+
+        const std::vector<std::uint8_t>& Code() const
+        {
+            return m_code;
+        }
+
+        void Push(HostRegister reg)
+        {
+            Rex(false, 0, reg);
+            Byte(0x50 + (reg & 7));
+        }
+
+        void Pop(HostRegister reg)
+        {
+            Rex(false, 0, reg);
+            Byte(0x58 + (reg & 7));
+        }
+
+        void Ret()
+        {
+            Byte(0xC3);
+        }
+
+        void AdjustStack(std::int8_t bytes)
+        {
+            //add rsp, imm8
+            Byte(0x48);
+            Byte(0x83);
+            ModRM(0b11, 0, RSP);
+            Immediate(bytes);
+        }
+
+        void MovImm64(HostRegister dst, std::uint64_t value)
+        {
+            Rex(true, 0, dst);
+            Byte(0xB8 + (dst & 7));
+            Immediate(value);
+        }
+
+        void MovImm32(HostRegister dst, std::uint32_t value)
+        {
+            Rex(false, 0, dst);
+            Byte(0xB8 + (dst & 7));
+            Immediate(value);
+        }
+
+        void Mov(HostRegister dst, HostRegister src)
+        {
+            Rex(false, src, dst);
+            Byte(0x89);
+            ModRM(0b11, src, dst);
+        }
+
+        void Alu(AluOperation operation, HostRegister dst, HostRegister src)
+        {
+            Rex(false, src, dst);
+            Byte((static_cast<std::uint8_t>(operation) << 3) | 0x01);
+            ModRM(0b11, src, dst);
+        }
+
+        void AluImm(AluOperation operation, HostRegister dst, std::uint32_t value)
+        {
+            Rex(false, 0, dst);
+            Byte(0x81);
+            ModRM(0b11, static_cast<std::uint8_t>(operation), dst);
+            Immediate(value);
+        }
+
+        void ShiftRightImm(HostRegister dst, std::uint8_t count)
+        {
+            Rex(false, 0, dst);
+            Byte(0xC1);
+            ModRM(0b11, 5, dst);
+            Byte(count);
+        }
+
+        void ImulImm(HostRegister dst, HostRegister src, std::uint32_t value)
+        {
+            Rex(false, dst, src);
+            Byte(0x69);
+            ModRM(0b11, dst, src);
+            Immediate(value);
+        }
+
+        //dst = 1 if the last comparison was above or equal (unsigned), 0 otherwise
+        void SetAboveOrEqual(HostRegister dst)
+        {
+            MovImm32(dst, 0);
+            Rex(false, 0, dst, true);
+            Byte(0x0F);
+            Byte(0x93);
+            ModRM(0b11, 0, dst);
+        }
+
+        void CmovEqual(HostRegister dst, HostRegister src)
+        {
+            Rex(false, dst, src);
+            Byte(0x0F);
+            Byte(0x44);
+            ModRM(0b11, dst, src);
+        }
+
+        void CmovNotEqual(HostRegister dst, HostRegister src)
+        {
+            Rex(false, dst, src);
+            Byte(0x0F);
+            Byte(0x45);
+            ModRM(0b11, dst, src);
+        }
+
+        //movzx dst, byte [base + offset]
+        void LoadByte(HostRegister dst, HostRegister base, std::int8_t offset)
+        {
+            Rex(false, dst, base);
+            Byte(0x0F);
+            Byte(0xB6);
+            ModRM(0b01, dst, base);
+            Immediate(offset);
+        }
+
+        //mov byte [base + offset], src
+        void StoreByte(HostRegister base, std::int8_t offset, HostRegister src)
+        {
+            Rex(false, src, base, true);
+            Byte(0x88);
+            ModRM(0b01, src, base);
+            Immediate(offset);
+        }
+
+        //movzx dst, word [rax]
+        void LoadWordFromRax(HostRegister dst)
+        {
+            Rex(false, dst, RAX);
+            Byte(0x0F);
+            Byte(0xB7);
+            ModRM(0b00, dst, RAX);
+        }
+
+        //mov word [rax], src
+        void StoreWordToRax(HostRegister src)
+        {
+            Byte(0x66);
+            Rex(false, src, RAX);
+            Byte(0x89);
+            ModRM(0b00, src, RAX);
+        }
+
+        //mov word [rax], imm16
+        void StoreWordImmToRax(std::uint16_t value)
+        {
+            Byte(0x66);
+            Byte(0xC7);
+            ModRM(0b00, 0, RAX);
+            Immediate(value);
+        }
+
+        void CallRax()
+        {
+            Byte(0xFF);
+            ModRM(0b11, 2, RAX);
+        }
+
+        void TestEax()
+        {
+            Byte(0x85);
+            ModRM(0b11, RAX, RAX);
+        }
+
+        //jnz rel32, returns the position of the displacement to patch
+        std::size_t JumpIfNotZero()
+        {
+            Byte(0x0F);
+            Byte(0x85);
+            const auto position = m_code.size();
+            Immediate(std::int32_t {0});
+            return position;
+        }
+
+        void PatchJump(std::size_t position, std::size_t target)
+        {
+            const auto displacement = static_cast<std::int32_t>(target - (position + sizeof(std::int32_t)));
+            std::memcpy(m_code.data() + position, &displacement, sizeof(displacement));
+        }
+    };
+
+    //host registers which survive calls to handlers, guest V registers are cached in them
+    constexpr std::array CACHE_REGISTERS {RBX, RBP, R13, R14, R15};
+    //holds the guest address register
+    constexpr auto ADDRESS_REGISTER = R12;
+    //holds the address of the guest register file
+    constexpr auto REGISTER_FILE = RDI;
+
+    constexpr std::uint16_t INSTRUCTION_WIDTH = 2, FONT_ADDRESS_START = 0x50, HEX_DIGIT_SPRITE_SIZE = 5;
+
+    bool IsSuperinstruction(const CHIP8::PredecodedInstruction& instruction)
+    {
+        return instruction.fusedOperands.opcode != 0;
+    }
+
+    //instructions which are translated to machine code instead of calling their handler
+    bool HasNativeTranslation(const CHIP8::PredecodedInstruction& instruction)
+    {
+        if (IsSuperinstruction(instruction))
+        {
+            return false;
+        }
+
+        const auto& operands = instruction.operands;
+        switch (operands.opcode >> 12)
+        {
+            case 0x1: case 0x3: case 0x4: case 0x6: case 0x7: case 0xA:
+                return true;
+            case 0x5: case 0x9:
+                return operands.n == 0;
+            case 0x8:
+                return operands.n <= 0x7 or operands.n == 0xE;
+            case 0xF:
+                return operands.nn == 0x1E or operands.nn == 0x29;
+            default:
+                return false;
+        }
+    }
+
+    class BlockTranslator
+    {
+        const CHIP8::JitCompiler::GuestState& m_guestState;
+        //only consulted while translating, compiled code never checks them
+        const CHIP8::Quirks m_quirks;
+        X64Emitter m_emitter;
+        //host register caching each guest register, if any
+        std::array<std::optional<HostRegister>, 16> m_cachedRegisters;
+        std::array<bool, 16> m_dirtyRegisters;
+        std::vector<std::size_t> m_failureJumps;
+        //bytes a skip ending the block jumps over
+        std::uint16_t m_skipWidth;
+
+        void LoadGuestState()
+        {
+            m_emitter.MovImm64(REGISTER_FILE, reinterpret_cast<std::uint64_t>(m_guestState.registers));
+            for (const auto [guestRegister, hostRegister] : m_cachedRegisters | std::views::enumerate)
+            {
+                if (hostRegister.has_value())
+                {
+                    m_emitter.LoadByte(*hostRegister, REGISTER_FILE, static_cast<std::int8_t>(guestRegister));
+                }
+            }
+            m_emitter.MovImm64(RAX, reinterpret_cast<std::uint64_t>(m_guestState.addressRegister));
+            m_emitter.LoadWordFromRax(ADDRESS_REGISTER);
+        }
+
+        void StoreGuestState()
+        {
+            for (const auto [guestRegister, hostRegister] : m_cachedRegisters | std::views::enumerate)
+            {
+                if (hostRegister.has_value() and m_dirtyRegisters[guestRegister])
+                {
+                    m_emitter.StoreByte(REGISTER_FILE, static_cast<std::int8_t>(guestRegister), *hostRegister);
+                    m_dirtyRegisters[guestRegister] = false;
+                }
+            }
+            m_emitter.MovImm64(RAX, reinterpret_cast<std::uint64_t>(m_guestState.addressRegister));
+            m_emitter.StoreWordToRax(ADDRESS_REGISTER);
+        }
+
+        void StoreProgramCounter(std::uint16_t programCounter)
+        {
+            m_emitter.MovImm64(RAX, reinterpret_cast<std::uint64_t>(m_guestState.programCounter));
+            m_emitter.StoreWordImmToRax(programCounter);
+        }
+
+        void ReadGuestRegister(HostRegister dst, std::uint8_t guestRegister)
+        {
+            if (m_cachedRegisters[guestRegister].has_value())
+            {
+                m_emitter.Mov(dst, *m_cachedRegisters[guestRegister]);
+            }
+            else
+            {
+                m_emitter.LoadByte(dst, REGISTER_FILE, static_cast<std::int8_t>(guestRegister));
+            }
+        }
+
+        //src must already hold a value in 0..255
+        void WriteGuestRegister(std::uint8_t guestRegister, HostRegister src)
+        {
+            if (m_cachedRegisters[guestRegister].has_value())
+            {
+                m_emitter.Mov(*m_cachedRegisters[guestRegister], src);
+                m_dirtyRegisters[guestRegister] = true;
+            }
+            else
+            {
+                m_emitter.StoreByte(REGISTER_FILE, static_cast<std::int8_t>(guestRegister), src);
+            }
+        }
+
+        void AllocateRegisters(const CHIP8::BasicBlock& block)
+        {
+            std::array<std::size_t, 16> uses {};
+            for (const auto& instruction : block.code | std::views::filter(HasNativeTranslation))
+            {
+                const auto& operands = instruction.operands;
+                const auto prefix = operands.opcode >> 12;
+                uses[operands.x] += prefix != 0x1 and prefix != 0xA;
+                uses[operands.y] += prefix == 0x5 or prefix == 0x8 or prefix == 0x9;
+                uses[0xF] += prefix == 0x8 and (operands.n >= 0x4 or (m_quirks.logicResetsFlag and operands.n != 0x0));
+            }
+
+            std::array<std::uint8_t, 16> byUse;
+            std::iota(byUse.begin(), byUse.end(), 0);
+            std::ranges::stable_sort(byUse, std::ranges::greater {}, [&](std::uint8_t guestRegister) {return uses[guestRegister];});
+
+            m_cachedRegisters.fill(std::nullopt);
+            m_dirtyRegisters.fill(false);
+            //caching a register used only once would cost more than it saves
+            for (const auto cacheIndex : std::views::iota(0UZ, CACHE_REGISTERS.size()))
+            {
+                const auto guestRegister = byUse[cacheIndex];
+                if (uses[guestRegister] > 1)
+                {
+                    m_cachedRegisters[guestRegister] = CACHE_REGISTERS[cacheIndex];
+                }
+            }
+        }
+
+        void Prologue()
+        {
+            for (const auto hostRegister : {RBX, RBP, R12, R13, R14, R15})
+            {
+                m_emitter.Push(hostRegister);
+            }
+            //keeps the stack aligned to 16 bytes at calls
+            m_emitter.AdjustStack(-8);
+            LoadGuestState();
+        }
+
+        void Epilogue()
+        {
+            m_emitter.AdjustStack(8);
+            for (const auto hostRegister : {R15, R14, R13, R12, RBP, RBX})
+            {
+                m_emitter.Pop(hostRegister);
+            }
+            m_emitter.Ret();
+        }
+
+        void CallHandler(const CHIP8::PredecodedInstruction& instruction, std::uint16_t programCounter)
+        {
+            //handlers see the guest state exactly as the interpreter would leave it
+            StoreGuestState();
+            StoreProgramCounter(programCounter);
+            m_emitter.MovImm64(RDI, reinterpret_cast<std::uint64_t>(m_guestState.vm));
+            m_emitter.MovImm64(RSI, reinterpret_cast<std::uint64_t>(&instruction));
+            m_emitter.MovImm64(RAX, reinterpret_cast<std::uint64_t>(m_guestState.nativeCall));
+            m_emitter.CallRax();
+            m_emitter.TestEax();
+            m_failureJumps.push_back(m_emitter.JumpIfNotZero());
+        }
+
+        void TranslateHandlerCall(const CHIP8::PredecodedInstruction& instruction, std::uint16_t programCounter, bool endsBlock)
+        {
+            CallHandler(instruction, programCounter);
+            if (endsBlock)
+            {
+                //the handler already moved the program counter, advance it like the interpreter does
+                m_emitter.MovImm64(RAX, reinterpret_cast<std::uint64_t>(m_guestState.programCounter));
+                m_emitter.LoadWordFromRax(RDX);
+                m_emitter.AluImm(AluOperation::Add, RDX, INSTRUCTION_WIDTH);
+                m_emitter.StoreWordToRax(RDX);
+                Epilogue();
+            }
+            else
+            {
+                LoadGuestState();
+            }
+        }
+
+        //skips end the block, the program counter becomes next or the address after the instruction at next
+        //depending on the comparison of RAX with RCX
+        void TranslateSkip(std::uint16_t programCounter, bool skipOnEqual)
+        {
+            const std::uint16_t next = programCounter + INSTRUCTION_WIDTH;
+            m_emitter.MovImm32(RSI, next);
+            m_emitter.MovImm32(RDX, static_cast<std::uint16_t>(next + m_skipWidth));
+            m_emitter.Alu(AluOperation::Cmp, RAX, RCX);
+            if (skipOnEqual)
+            {
+                m_emitter.CmovEqual(RSI, RDX);
+            }
+            else
+            {
+                m_emitter.CmovNotEqual(RSI, RDX);
+            }
+            StoreGuestState();
+            m_emitter.MovImm64(RAX, reinterpret_cast<std::uint64_t>(m_guestState.programCounter));
+            m_emitter.StoreWordToRax(RSI);
+            Epilogue();
+        }
+
+        //8xy1, 8xy2 and 8xy3 clear VF after writing Vx on the COSMAC VIP
+        void ResetFlagAfterLogic()
+        {
+            if (m_quirks.logicResetsFlag)
+            {
+                m_emitter.MovImm32(RDX, 0);
+                WriteGuestRegister(0xF, RDX);
+            }
+        }
+
+        //8xy6 and 8xyE shift the value in RAX, which holds Vx unless the profile shifts Vy from RCX
+        void SelectShiftSource()
+        {
+            if (m_quirks.shiftsVy)
+            {
+                m_emitter.Mov(RAX, RCX);
+            }
+        }
+
+        void TranslateArithmetic(const CHIP8::DecodedOpcode& operands)
+        {
+            ReadGuestRegister(RAX, operands.x);
+            ReadGuestRegister(RCX, operands.y);
+            switch (operands.n)
+            {
+                //Vx = Vy
+                case 0x0:
+                    WriteGuestRegister(operands.x, RCX);
+                    break;
+
+                //Vx = Vx OR Vy
+                case 0x1:
+                    m_emitter.Alu(AluOperation::Or, RAX, RCX);
+                    WriteGuestRegister(operands.x, RAX);
+                    ResetFlagAfterLogic();
+                    break;
+
+                //Vx = Vx AND Vy
+                case 0x2:
+                    m_emitter.Alu(AluOperation::And, RAX, RCX);
+                    WriteGuestRegister(operands.x, RAX);
+                    ResetFlagAfterLogic();
+                    break;
+
+                //Vx = Vx XOR Vy
+                case 0x3:
+                    m_emitter.Alu(AluOperation::Xor, RAX, RCX);
+                    WriteGuestRegister(operands.x, RAX);
+                    ResetFlagAfterLogic();
+                    break;
+
+                //Vx = Vx + Vy, VF = carry
+                case 0x4:
+                    m_emitter.Alu(AluOperation::Add, RAX, RCX);
+                    m_emitter.Mov(RDX, RAX);
+                    m_emitter.ShiftRightImm(RDX, 8);
+                    m_emitter.AluImm(AluOperation::And, RAX, 0xFF);
+                    WriteGuestRegister(operands.x, RAX);
+                    WriteGuestRegister(0xF, RDX);
+                    break;
+
+                //Vx = Vx - Vy, VF = 1 if no borrow
+                case 0x5:
+                    m_emitter.Alu(AluOperation::Cmp, RAX, RCX);
+                    m_emitter.SetAboveOrEqual(RDX);
+                    m_emitter.Alu(AluOperation::Sub, RAX, RCX);
+                    m_emitter.AluImm(AluOperation::And, RAX, 0xFF);
+                    WriteGuestRegister(operands.x, RAX);
+                    WriteGuestRegister(0xF, RDX);
+                    break;
+
+                //Vx = Vx >> 1, VF = least significant bit of Vx before shift, Vy instead of Vx if the profile shifts Vy
+                case 0x6:
+                    SelectShiftSource();
+                    m_emitter.Mov(RDX, RAX);
+                    m_emitter.AluImm(AluOperation::And, RDX, 1);
+                    m_emitter.ShiftRightImm(RAX, 1);
+                    WriteGuestRegister(operands.x, RAX);
+                    WriteGuestRegister(0xF, RDX);
+                    break;
+
+                //Vx = Vy - Vx, VF = 1 if no borrow
+                case 0x7:
+                    m_emitter.Alu(AluOperation::Cmp, RCX, RAX);
+                    m_emitter.SetAboveOrEqual(RDX);
+                    m_emitter.Alu(AluOperation::Sub, RCX, RAX);
+                    m_emitter.AluImm(AluOperation::And, RCX, 0xFF);
+                    WriteGuestRegister(operands.x, RCX);
+                    WriteGuestRegister(0xF, RDX);
+                    break;
+
+                //Vx = Vx << 1, VF = most significant bit of Vx before shift, Vy instead of Vx if the profile shifts Vy
+                case 0xE:
+                    SelectShiftSource();
+                    m_emitter.Mov(RDX, RAX);
+                    m_emitter.ShiftRightImm(RDX, 7);
+                    m_emitter.Alu(AluOperation::Add, RAX, RAX);
+                    m_emitter.AluImm(AluOperation::And, RAX, 0xFF);
+                    WriteGuestRegister(operands.x, RAX);
+                    WriteGuestRegister(0xF, RDX);
+                    break;
+            }
+        }
+
+        void TranslateNative(const CHIP8::DecodedOpcode& operands, std::uint16_t programCounter)
+        {
+            switch (operands.opcode >> 12)
+            {
+                case 0x1:
+                    StoreGuestState();
+                    StoreProgramCounter(operands.nnn);
+                    Epilogue();
+                    break;
+
+                case 0x3:
+                case 0x4:
+                    ReadGuestRegister(RAX, operands.x);
+                    m_emitter.MovImm32(RCX, operands.nn);
+                    TranslateSkip(programCounter, (operands.opcode >> 12) == 0x3);
+                    break;
+
+                case 0x5:
+                case 0x9:
+                    ReadGuestRegister(RAX, operands.x);
+                    ReadGuestRegister(RCX, operands.y);
+                    TranslateSkip(programCounter, (operands.opcode >> 12) == 0x5);
+                    break;
+
+                case 0x6:
+                    m_emitter.MovImm32(RAX, operands.nn);
+                    WriteGuestRegister(operands.x, RAX);
+                    break;
+
+                case 0x7:
+                    ReadGuestRegister(RAX, operands.x);
+                    m_emitter.AluImm(AluOperation::Add, RAX, operands.nn);
+                    m_emitter.AluImm(AluOperation::And, RAX, 0xFF);
+                    WriteGuestRegister(operands.x, RAX);
+                    break;
+
+                case 0x8:
+                    TranslateArithmetic(operands);
+                    break;
+
+                case 0xA:
+                    m_emitter.MovImm32(ADDRESS_REGISTER, operands.nnn);
+                    break;
+
+                case 0xF:
+                    ReadGuestRegister(RAX, operands.x);
+                    if (operands.nn == 0x1E)
+                    {
+                        m_emitter.Alu(AluOperation::Add, ADDRESS_REGISTER, RAX);
+                        m_emitter.AluImm(AluOperation::And, ADDRESS_REGISTER, 0xFFFF);
+                    }
+                    else
+                    {
+                        m_emitter.ImulImm(ADDRESS_REGISTER, RAX, HEX_DIGIT_SPRITE_SIZE);
+                        m_emitter.AluImm(AluOperation::Add, ADDRESS_REGISTER, FONT_ADDRESS_START);
+                    }
+                    break;
+            }
+        }
+
+    public:
+        BlockTranslator(const CHIP8::JitCompiler::GuestState& guestState, const CHIP8::Quirks& quirks)
+            :
+            m_guestState(guestState),
+            m_quirks(quirks),
+            m_skipWidth(INSTRUCTION_WIDTH)
+        {
+
+        }
+
+        const std::vector<std::uint8_t>& Translate(const CHIP8::BasicBlock& block)
+        {
+            AllocateRegisters(block);
+            m_skipWidth = block.skipWidth;
+            Prologue();
+
+            auto programCounter = block.start;
+            for (const auto [index, instruction] : block.code | std::views::enumerate)
+            {
+                if (HasNativeTranslation(instruction))
+                {
+                    TranslateNative(instruction.operands, programCounter);
+                }
+                else
+                {
+                    const auto isLast = static_cast<std::size_t>(index) + 1 == block.code.size();
+                    TranslateHandlerCall(instruction, programCounter, isLast and EndsBlockWithTransfer(instruction));
+                }
+                //F000 is followed by the word holding its address
+                programCounter += INSTRUCTION_WIDTH * (1 + IsSuperinstruction(instruction) + CHIP8::IsLongInstruction(instruction.operands.opcode));
+            }
+
+            //blocks cut at the length limit fall through to the next address
+            if (not EndsBlockWithTransfer(block.code.back()))
+            {
+                StoreGuestState();
+                StoreProgramCounter(programCounter);
+                Epilogue();
+            }
+
+            //a failed handler already left the guest state as it was when it threw
+            const auto failureExit = m_emitter.Size();
+            Epilogue();
+            for (const auto position : m_failureJumps)
+            {
+                m_emitter.PatchJump(position, failureExit);
+            }
+
+            return m_emitter.Code();
+        }
+
+        //whether the code of the instruction itself leaves the block
+        static bool EndsBlockWithTransfer(const CHIP8::PredecodedInstruction& instruction)
+        {
+            const auto& operands = IsSuperinstruction(instruction) ? instruction.fusedOperands : instruction.operands;
+            switch (operands.opcode >> 12)
+            {
+                case 0x0: return operands.opcode == 0x00EE or operands.opcode == 0x00FD;
+                case 0x1: case 0x2: case 0xB: return true;
+                case 0x3: case 0x4: case 0x5: case 0x9: case 0xE: return true;
+                case 0xF: return operands.nn == 0x0A or operands.nn == 0x33 or operands.nn == 0x55;
+                default: return false;
+            }
+        }
+    };
+}
+
+CHIP8::JitCompiler::JitCompiler(const GuestState& guestState)
+    :
+    m_guestState(guestState),
+    m_codeBuffer(nullptr),
+    m_codeBufferUsed(0)
+{
+#ifdef CHIP8_JIT_SUPPORTED
+    //never writable and executable at once, Compile makes the pages of a block executable once it is copied
+    void* codeBuffer = mmap(nullptr, CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (codeBuffer != MAP_FAILED)
+    {
+        m_codeBuffer = static_cast<std::byte*>(codeBuffer);
+    }
+#endif
+}
+
+CHIP8::JitCompiler::~JitCompiler()
+{
+#ifdef CHIP8_JIT_SUPPORTED
+    if (m_codeBuffer != nullptr)
+    {
+        munmap(m_codeBuffer, CODE_BUFFER_SIZE);
+    }
+#endif
+}
+
+bool CHIP8::JitCompiler::IsAvailable() const
+{
+    return m_codeBuffer != nullptr;
+}
+
+CHIP8::NativeCode CHIP8::JitCompiler::Compile(const BasicBlock& block, const Quirks& quirks)
+{
+    if (not IsAvailable() or block.code.empty())
+    {
+        return nullptr;
+    }
+
+    BlockTranslator translator {m_guestState, quirks};
+    const auto& code = translator.Translate(block);
+    if (m_codeBufferUsed + code.size() > CODE_BUFFER_SIZE)
+    {
+        return nullptr;
+    }
+
+    auto* const start = m_codeBuffer + m_codeBufferUsed;
+#ifdef CHIP8_JIT_SUPPORTED
+    //the first page may hold blocks compiled before, it is only writable while the block is copied;
+    //nothing compiled runs while a block is compiled
+    const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const auto pagesStart = m_codeBufferUsed / pageSize * pageSize;
+    const auto pagesEnd = (m_codeBufferUsed + code.size() + pageSize - 1) / pageSize * pageSize;
+    if (mprotect(m_codeBuffer + pagesStart, pagesEnd - pagesStart, PROT_READ | PROT_WRITE) != 0)
+    {
+        return nullptr;
+    }
+    std::memcpy(start, code.data(), code.size());
+    if (mprotect(m_codeBuffer + pagesStart, pagesEnd - pagesStart, PROT_READ | PROT_EXEC) != 0)
+    {
+        return nullptr;
+    }
+#endif
+    m_codeBufferUsed += code.size();
+    //keep every block on its own cache line
+    m_codeBufferUsed = (m_codeBufferUsed + 63) & ~std::size_t {63};
+
+    if (m_perfMap.is_open())
+    {
+        m_perfMap << std::format("{:x} {:x} chip8_block_{:04X}\n", reinterpret_cast<std::uintptr_t>(start), code.size(), block.start) << std::flush;
+    }
+
+    return reinterpret_cast<NativeCode>(start);
+}
+
+void CHIP8::JitCompiler::Reset()
+{
+#ifdef CHIP8_JIT_SUPPORTED
+    //dropped code must not stay executable
+    if (m_codeBuffer != nullptr)
+    {
+        mprotect(m_codeBuffer, CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE);
+    }
+#endif
+    m_codeBufferUsed = 0;
+}
+
+void CHIP8::JitCompiler::EnablePerfMap()
+{
+#ifdef CHIP8_JIT_SUPPORTED
+    m_perfMap.open(std::format("/tmp/perf-{}.map", getpid()), std::ios::out | std::ios::app);
+#endif
+}
@@ -0,0 +1,73 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include "instruction.hpp"
+#include "blockCache.hpp"
+#include "quirks.hpp"
+
+namespace CHIP8
+{
+    //compiles basic blocks of one virtual machine into x86-64 machine code;
+    //guest registers used by a block are kept in host registers while it runs
+    //and every instruction without a native translation calls its interpreter handler
+    class JitCompiler
+    {
+    public:
+        //calls a handler on behalf of compiled code, must not throw and returns non-zero on failure
+        using NativeCall = std::uint32_t (*)(VirtualMachine& vm, const PredecodedInstruction& instruction);
+
+        //addresses of the guest state which compiled code reads and writes directly
+        struct GuestState
+        {
+            VirtualMachine* vm;
+            std::byte* registers;
+            std::uint16_t* addressRegister;
+            std::uint16_t* programCounter;
+            NativeCall nativeCall;
+        };
+
+    private:
+        static constexpr std::size_t CODE_BUFFER_SIZE = 1 << 20;
+
+        GuestState m_guestState;
+        std::byte* m_codeBuffer;
+        std::size_t m_codeBufferUsed;
+        std::ofstream m_perfMap;
+
+    public:
+        JitCompiler(const GuestState& guestState);
+        ~JitCompiler();
+        JitCompiler(const JitCompiler&) = delete;
+        JitCompiler& operator=(const JitCompiler&) = delete;
+
+        //false if the host cannot run compiled code, blocks are then left to the threaded engine
+        bool IsAvailable() const;
+        //returns nullptr when the code buffer is full, the quirks decide what native translations emit
+        NativeCode Compile(const BasicBlock& block, const Quirks& quirks);
+        //drops all compiled code, none of it may be running
+        void Reset();
+        //writes /tmp/perf-<pid>.map so perf can symbolize compiled blocks
+        void EnablePerfMap();
+    };
+}
@@ -18,8 +18,8 @@
 
 #pragma once
 
-#include <array>
-#include <SFML/Window/Keyboard.hpp>
+#include <cstddef>
+#include <cstdint>
 
 namespace CHIP8
 {
@@ -31,14 +31,39 @@ namespace CHIP8
         C, D, E, F
     };
 
+    //source of the state of the 16 CHIP-8 keys, implemented by the frontend
     class Keyboard
     {
+    public:
         static constexpr unsigned KEYS = 16;
-        std::array<sf::Keyboard::Key, KEYS> m_chip8KeyToPhysicalKey;
-        
+
+        virtual ~Keyboard() = default;
+        //bit k is set while key k is held down, read by the VM thread for every key instruction
+        virtual std::uint16_t GetPressedKeys() const = 0;
+        //called by the VM before the instructions of every frame
+        virtual void BeginFrame();
+        //called instead of BeginFrame for frames which the VM slept through while Fx0A waited,
+        //the keys are the same as in the frame before them
+        virtual void SkipFrames(std::size_t frameCount);
+    };
+
+    //keyboard without any keys pressed, used when no frontend is attached
+    class NullKeyboard : public Keyboard
+    {
+    public:
+        std::uint16_t GetPressedKeys() const override;
+    };
+
+    //keyboard which only changes between frames, so a frame sees the same keys from start to end
+    class LatchedKeyboard : public Keyboard
+    {
+        std::uint16_t m_pressedKeys;
+
+    protected:
+        void SetPressedKeys(std::uint16_t pressedKeys);
+
     public:
-        Keyboard();
-        bool IsKeyPressed(CHIP8::Key key) const;
-        CHIP8::Key WaitForKeyPress() const;
+        LatchedKeyboard();
+        std::uint16_t GetPressedKeys() const override;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,53 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+
+namespace CHIP8
+{
+    //integers are stored least significant byte first in every file the emulator writes
+    template <typename T>
+    void WriteLittleEndian(std::ostream& stream, T value)
+    {
+        for (std::size_t byteIndex {0}; byteIndex < sizeof(T); ++byteIndex)
+        {
+            stream.put(static_cast<char>((value >> (8 * byteIndex)) & 0xFF));
+        }
+    }
+
+    //returns false if the stream ends before the whole value was read
+    template <typename T>
+    bool ReadLittleEndian(std::istream& stream, T& value)
+    {
+        value = 0;
+        for (std::size_t byteIndex {0}; byteIndex < sizeof(T); ++byteIndex)
+        {
+            const auto byte = stream.get();
+            if (byte == std::istream::traits_type::eof())
+            {
+                return false;
+            }
+            value |= static_cast<T>(static_cast<T>(byte) << (8 * byteIndex));
+        }
+        return true;
+    }
+}
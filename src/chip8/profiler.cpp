@@ -0,0 +1,253 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "profiler.hpp"
+#include <algorithm>
+#include <numeric>
+#include <print>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    //indices of the non-zero counts, most frequent first, ties in index order
+    std::vector<std::size_t> RankNonZero(std::span<const std::uint64_t> counts)
+    {
+        std::vector<std::size_t> indices(counts.size());
+        std::iota(std::begin(indices), std::end(indices), 0UZ);
+        std::erase_if(indices, [counts](const std::size_t index) {return counts[index] == 0;});
+        std::ranges::stable_sort(indices, std::ranges::greater {}, [counts](const std::size_t index) {return counts[index];});
+        return indices;
+    }
+
+    consteval std::size_t ClassIndex(std::string_view opcodeClass)
+    {
+        return std::ranges::find(CHIP8::Profiler::OPCODE_CLASSES, opcodeClass) - CHIP8::Profiler::OPCODE_CLASSES.begin();
+    }
+
+    constexpr std::size_t INVALID_CLASS = CHIP8::Profiler::OPCODE_CLASSES.size() - 1;
+}
+
+CHIP8::Profiler::Profiler()
+    :
+    m_instructionCount(0),
+    m_opcodeClassCounts{},
+    m_addressCounts{},
+    m_reads{},
+    m_writes{},
+    m_executes{}
+{
+
+}
+
+std::size_t CHIP8::Profiler::ClassifyOpcode(std::uint16_t opcode)
+{
+    const auto n = opcode & 0xF;
+    const auto nn = opcode & 0xFF;
+
+    switch (opcode >> 12)
+    {
+        case 0x0:
+            switch (opcode & 0xFFF0)
+            {
+                case 0x00C0: return ClassIndex("00Cn");
+                case 0x00D0: return ClassIndex("00Dn");
+            }
+            switch (opcode)
+            {
+                case 0x00E0: return ClassIndex("00E0");
+                case 0x00EE: return ClassIndex("00EE");
+                case 0x00FB: return ClassIndex("00FB");
+                case 0x00FC: return ClassIndex("00FC");
+                case 0x00FD: return ClassIndex("00FD");
+                case 0x00FE: return ClassIndex("00FE");
+                case 0x00FF: return ClassIndex("00FF");
+                default: return ClassIndex("0nnn");
+            }
+        case 0x1: return ClassIndex("1nnn");
+        case 0x2: return ClassIndex("2nnn");
+        case 0x3: return ClassIndex("3xnn");
+        case 0x4: return ClassIndex("4xnn");
+        //any other 5xyn is decoded as 5xy0
+        case 0x5: return n == 0x2 ? ClassIndex("5xy2") : n == 0x3 ? ClassIndex("5xy3") : ClassIndex("5xy0");
+        case 0x6: return ClassIndex("6xnn");
+        case 0x7: return ClassIndex("7xnn");
+        case 0x8:
+            switch (n)
+            {
+                case 0x0: case 0x1: case 0x2: case 0x3: case 0x4: case 0x5: case 0x6: case 0x7: return ClassIndex("8xy0") + n;
+                case 0xE: return ClassIndex("8xyE");
+                default: return INVALID_CLASS;
+            }
+        case 0x9: return ClassIndex("9xy0");
+        case 0xA: return ClassIndex("Annn");
+        case 0xB: return ClassIndex("Bnnn");
+        case 0xC: return ClassIndex("Cxnn");
+        case 0xD: return ClassIndex("Dxyn");
+        case 0xE:
+            switch (nn)
+            {
+                case 0x9E: return ClassIndex("Ex9E");
+                case 0xA1: return ClassIndex("ExA1");
+                default: return INVALID_CLASS;
+            }
+        case 0xF:
+            switch (opcode)
+            {
+                case 0xF000: return ClassIndex("F000");
+                case 0xF002: return ClassIndex("F002");
+            }
+            switch (nn)
+            {
+                case 0x01: return ClassIndex("Fn01");
+                case 0x07: return ClassIndex("Fx07");
+                case 0x0A: return ClassIndex("Fx0A");
+                case 0x15: return ClassIndex("Fx15");
+                case 0x18: return ClassIndex("Fx18");
+                case 0x1E: return ClassIndex("Fx1E");
+                case 0x29: return ClassIndex("Fx29");
+                case 0x30: return ClassIndex("Fx30");
+                case 0x33: return ClassIndex("Fx33");
+                case 0x3A: return ClassIndex("Fx3A");
+                case 0x55: return ClassIndex("Fx55");
+                case 0x65: return ClassIndex("Fx65");
+                case 0x75: return ClassIndex("Fx75");
+                case 0x85: return ClassIndex("Fx85");
+                default: return INVALID_CLASS;
+            }
+    }
+
+    return INVALID_CLASS;
+}
+
+void CHIP8::Profiler::CountRange(std::array<std::uint64_t, MEMORY_SIZE>& counts, std::size_t address, std::size_t length)
+{
+    const auto end = std::min(address + length, MEMORY_SIZE);
+    for (auto current = address; current < end; ++current)
+    {
+        ++counts[current];
+    }
+}
+
+void CHIP8::Profiler::CountExecution(std::uint16_t address, std::uint16_t opcode)
+{
+    ++m_instructionCount;
+    ++m_opcodeClassCounts[ClassifyOpcode(opcode)];
+    ++m_addressCounts[address];
+    CountRange(m_executes, address, sizeof(opcode));
+}
+
+void CHIP8::Profiler::CountReads(std::size_t address, std::size_t length)
+{
+    CountRange(m_reads, address, length);
+}
+
+void CHIP8::Profiler::CountWrites(std::size_t address, std::size_t length)
+{
+    CountRange(m_writes, address, length);
+}
+
+std::uint64_t CHIP8::Profiler::GetInstructionCount() const
+{
+    return m_instructionCount;
+}
+
+std::uint64_t CHIP8::Profiler::GetOpcodeClassCount(std::size_t opcodeClass) const
+{
+    return m_opcodeClassCounts.at(opcodeClass);
+}
+
+std::uint64_t CHIP8::Profiler::GetAddressCount(std::uint16_t address) const
+{
+    return m_addressCounts.at(address);
+}
+
+void CHIP8::Profiler::WriteJson(std::ostream& stream) const
+{
+    const auto writeList = [&stream](std::string_view name, const auto& items, const auto& writeItem)
+    {
+        std::print(stream, "  \"{}\": [", name);
+        for (const auto [index, item] : items | std::views::enumerate)
+        {
+            std::print(stream, "{}\n    ", index == 0 ? "" : ",");
+            writeItem(item);
+        }
+        std::print(stream, "{}]", items.empty() ? "" : "\n  ");
+    };
+
+    std::println(stream, "{{");
+    std::println(stream, "  \"instructions\": {},", m_instructionCount);
+    writeList("opcodes", RankNonZero(m_opcodeClassCounts), [&](const std::size_t opcodeClass)
+    {
+        std::print(stream, "{{\"class\": \"{}\", \"count\": {}}}", OPCODE_CLASSES[opcodeClass], m_opcodeClassCounts[opcodeClass]);
+    });
+    std::println(stream, ",");
+    writeList("addresses", RankNonZero(m_addressCounts), [&](const std::size_t address)
+    {
+        std::print(stream, "{{\"address\": \"0x{:04X}\", \"count\": {}}}", address, m_addressCounts[address]);
+    });
+    std::println(stream, ",");
+
+    std::vector<std::size_t> touched;
+    for (std::size_t address = 0; address < MEMORY_SIZE; ++address)
+    {
+        if (m_reads[address] != 0 or m_writes[address] != 0 or m_executes[address] != 0)
+        {
+            touched.push_back(address);
+        }
+    }
+    writeList("memory", touched, [&](const std::size_t address)
+    {
+        std::print(stream, "{{\"address\": \"0x{:04X}\", \"reads\": {}, \"writes\": {}, \"executes\": {}}}", 
+            address, m_reads[address], m_writes[address], m_executes[address]);
+    });
+    std::println(stream, "");
+    std::println(stream, "}}");
+}
+
+void CHIP8::Profiler::WriteCsv(std::ostream& stream) const
+{
+    std::println(stream, "section,key,count");
+    for (const auto opcodeClass : RankNonZero(m_opcodeClassCounts))
+    {
+        std::println(stream, "opcode,{},{}", OPCODE_CLASSES[opcodeClass], m_opcodeClassCounts[opcodeClass]);
+    }
+    for (const auto address : RankNonZero(m_addressCounts))
+    {
+        std::println(stream, "address,0x{:04X},{}", address, m_addressCounts[address]);
+    }
+
+    const std::array<std::pair<std::string_view, const std::array<std::uint64_t, MEMORY_SIZE>&>, 3> memoryCounts 
+    {{
+        {"read", m_reads},
+        {"write", m_writes},
+        {"execute", m_executes}
+    }};
+    for (const auto& [section, counts] : memoryCounts)
+    {
+        for (std::size_t address = 0; address < MEMORY_SIZE; ++address)
+        {
+            if (counts[address] != 0)
+            {
+                std::println(stream, "{},0x{:04X},{}", section, address, counts[address]);
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace CHIP8
+{
+    //counts the instructions a program executes and the memory it touches, the VM only calls
+    //it when built with CHIP8_ENABLE_PROFILER, otherwise every hook is compiled out
+    class Profiler
+    {
+    public:
+#ifdef CHIP8_ENABLE_PROFILER
+        static constexpr bool ENABLED = true;
+#else
+        static constexpr bool ENABLED = false;
+#endif
+
+        //instruction patterns as the VM decodes them, the last one counts opcodes it rejects
+        static constexpr std::array<std::string_view, 52> OPCODE_CLASSES = 
+        {
+            "00Cn", "00Dn", "00E0", "00EE", "00FB", "00FC", "00FD", "00FE", "00FF", "0nnn", 
+            "1nnn", "2nnn", "3xnn", "4xnn", "5xy0", "5xy2", "5xy3", "6xnn", "7xnn", 
+            "8xy0", "8xy1", "8xy2", "8xy3", "8xy4", "8xy5", "8xy6", "8xy7", "8xyE", "9xy0",
+            "Annn", "Bnnn", "Cxnn", "Dxyn", "Ex9E", "ExA1", "F000", "Fn01", "F002", "Fx07", "Fx0A", "Fx15", "Fx18",
+            "Fx1E", "Fx29", "Fx30", "Fx33", "Fx3A", "Fx55", "Fx65", "Fx75", "Fx85", "invalid"
+        };
+
+    private:
+        //same as the memory of the VM
+        static constexpr std::size_t MEMORY_SIZE = 0x10000;
+
+        std::uint64_t m_instructionCount;
+        std::array<std::uint64_t, OPCODE_CLASSES.size()> m_opcodeClassCounts;
+        //instructions started at an address
+        std::array<std::uint64_t, MEMORY_SIZE> m_addressCounts;
+        //per byte, an instruction executes both of its bytes
+        std::array<std::uint64_t, MEMORY_SIZE> m_reads, m_writes, m_executes;
+
+        static void CountRange(std::array<std::uint64_t, MEMORY_SIZE>& counts, std::size_t address, std::size_t length);
+
+    public:
+        Profiler();
+        //index into OPCODE_CLASSES
+        static std::size_t ClassifyOpcode(std::uint16_t opcode);
+        void CountExecution(std::uint16_t address, std::uint16_t opcode);
+        //accesses past the end of memory are not counted
+        void CountReads(std::size_t address, std::size_t length);
+        void CountWrites(std::size_t address, std::size_t length);
+
+        std::uint64_t GetInstructionCount() const;
+        std::uint64_t GetOpcodeClassCount(std::size_t opcodeClass) const;
+        std::uint64_t GetAddressCount(std::uint16_t address) const;
+        //opcode classes and addresses sorted from the most executed, memory in address order, zero counts are left out
+        void WriteJson(std::ostream& stream) const;
+        //one section,key,count row per non-zero count, sections are opcode, address, read, write and execute
+        void WriteCsv(std::ostream& stream) const;
+    };
+}
\ No newline at end of file
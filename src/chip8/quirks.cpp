@@ -0,0 +1,107 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+#include "quirks.hpp"
+#include <array>
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{
+    constexpr std::array QUIRK_PROFILE_NAMES 
+    {
+        std::pair {CHIP8::QuirkProfile::CosmacVip, std::string_view {"cosmac-vip"}},
+        std::pair {CHIP8::QuirkProfile::Chip48, std::string_view {"chip-48"}},
+        std::pair {CHIP8::QuirkProfile::SuperChip, std::string_view {"super-chip"}},
+        std::pair {CHIP8::QuirkProfile::XoChip, std::string_view {"xo-chip"}},
+        std::pair {CHIP8::QuirkProfile::Legacy, std::string_view {"legacy"}}
+    };
+    constexpr std::size_t HASH_DIGITS = 16;
+}
+
+std::string_view CHIP8::GetQuirkProfileName(QuirkProfile profile)
+{
+    for (const auto& [namedProfile, name] : QUIRK_PROFILE_NAMES)
+    {
+        if (namedProfile == profile)
+        {
+            return name;
+        }
+    }
+    return {};
+}
+
+std::optional<CHIP8::QuirkProfile> CHIP8::ParseQuirkProfile(std::string_view name)
+{
+    for (const auto& [profile, profileName] : QUIRK_PROFILE_NAMES)
+    {
+        if (profileName == name)
+        {
+            return profile;
+        }
+    }
+    return {};
+}
+
+CHIP8::QuirkDatabase CHIP8::QuirkDatabase::Load(const std::filesystem::path& path)
+{
+    std::ifstream file {path};
+    if (not file.is_open())
+    {
+        throw std::runtime_error {std::format("Cannot open quirk database {}", path.string())};
+    }
+
+    QuirkDatabase database;
+    std::string line;
+    for (std::size_t lineNumber {1}; std::getline(file, line); ++lineNumber)
+    {
+        line.erase(std::min(line.find('#'), line.size()));
+        std::istringstream fields {line};
+        std::string hashText, name, rest;
+        if (not (fields >> hashText))
+        {
+            continue;
+        }
+
+        std::uint64_t programHash {0};
+        const auto [end, errc] = std::from_chars(hashText.data(), hashText.data() + hashText.size(), programHash, 16);
+        const auto profile = fields >> name ? ParseQuirkProfile(name) : std::nullopt;
+        if (hashText.size() != HASH_DIGITS or errc != std::errc {} or end != hashText.data() + hashText.size() or 
+            not profile.has_value() or fields >> rest)
+        {
+            throw std::runtime_error {std::format("Line {} of quirk database {} is malformed", lineNumber, path.string())};
+        }
+        database.m_profiles.insert_or_assign(programHash, profile.value());
+    }
+    return database;
+}
+
+std::optional<CHIP8::QuirkProfile> CHIP8::QuirkDatabase::Find(std::uint64_t programHash) const
+{
+    const auto found = m_profiles.find(programHash);
+    if (found == m_profiles.end())
+    {
+        return {};
+    }
+    return found->second;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include "framebuffer.hpp"
+
+namespace CHIP8
+{
+    //interpreters whose behaviour is followed where they disagree on what an instruction does
+    enum class QuirkProfile : std::uint8_t
+    {
+        CosmacVip,
+        Chip48,
+        SuperChip,
+        XoChip,
+        //this emulator before it followed other interpreters, the default
+        Legacy
+    };
+
+    //how far Fx55 and Fx65 move I past the registers they copy
+    enum class AddressIncrement : std::uint8_t
+    {
+        None,
+        //I ends up at the last register copied
+        ByX,
+        //I ends up right after the last register copied
+        ByXPlusOne
+    };
+
+    //behaviour of the instructions which differ between interpreters
+    struct Quirks
+    {
+        //8xy1, 8xy2 and 8xy3 set VF to 0
+        bool logicResetsFlag;
+        //8xy6 and 8xyE shift Vy into Vx instead of shifting Vx in place
+        bool shiftsVy;
+        AddressIncrement addressIncrement;
+        //Bxnn jumps to xnn + Vx instead of nnn + V0
+        bool jumpsWithVx;
+        Framebuffer::EdgeMode spriteEdgeMode;
+        //bytes of memory, XO-CHIP extends the address space to 64 KiB
+        std::uint32_t memorySize;
+    };
+
+    constexpr Quirks GetQuirks(QuirkProfile profile)
+    {
+        switch (profile)
+        {
+            case QuirkProfile::CosmacVip: return {true, true, AddressIncrement::ByXPlusOne, false, Framebuffer::EdgeMode::Clip, 0x1000};
+            case QuirkProfile::Chip48: return {false, false, AddressIncrement::ByX, true, Framebuffer::EdgeMode::Clip, 0x1000};
+            case QuirkProfile::SuperChip: return {false, false, AddressIncrement::None, true, Framebuffer::EdgeMode::Clip, 0x1000};
+            case QuirkProfile::XoChip: return {false, true, AddressIncrement::ByXPlusOne, false, Framebuffer::EdgeMode::Wrap, 0x10000};
+            case QuirkProfile::Legacy: return {false, false, AddressIncrement::None, false, Framebuffer::EdgeMode::Clip, 0x1000};
+        }
+        return {};
+    }
+
+    //names used on the command line and in quirk databases: cosmac-vip, chip-48, super-chip, xo-chip and legacy
+    std::string_view GetQuirkProfileName(QuirkProfile profile);
+    std::optional<QuirkProfile> ParseQuirkProfile(std::string_view name);
+
+    //quirk profiles of known programs, keyed by the same FNV-1a hash of the program as input logs;
+    //a text file with one line of the hash as 16 hex digits and the profile name per program, # starts a comment
+    class QuirkDatabase
+    {
+        std::unordered_map<std::uint64_t, QuirkProfile> m_profiles;
+
+    public:
+        //throws std::runtime_error if the file cannot be read or a line is malformed
+        static QuirkDatabase Load(const std::filesystem::path& path);
+        std::optional<QuirkProfile> Find(std::uint64_t programHash) const;
+    };
+}
\ No newline at end of file
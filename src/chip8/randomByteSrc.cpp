@@ -26,7 +26,16 @@ CHIP8::RandomByteSource::RandomByteSource()
 
 }
 
+CHIP8::RandomByteSource::RandomByteSource(std::uint32_t seed)
+    :
+    m_engine(seed)
+{
+
+}
+
 std::uint8_t CHIP8::RandomByteSource::operator()()
 {
-    return m_distr(m_engine);
+    //distributions are implementation-defined and do not take bytes, the engine itself is specified exactly;
+    //its low bits are the weakest, so a byte above them is taken
+    return static_cast<std::uint8_t>(m_engine() >> 8);
 }
\ No newline at end of file
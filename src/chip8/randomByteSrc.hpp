@@ -26,10 +26,11 @@ namespace CHIP8
     class RandomByteSource
     {
         std::minstd_rand m_engine;
-        std::uniform_int_distribution<std::uint8_t> m_distr;
 
     public:
         RandomByteSource();
+        //same sequence of bytes for the same seed, whatever the standard library
+        explicit RandomByteSource(std::uint32_t seed);
         std::uint8_t operator()();
     };
 }
\ No newline at end of file
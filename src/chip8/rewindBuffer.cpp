@@ -0,0 +1,205 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "rewindBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+CHIP8::RewindBuffer::RewindBuffer(std::size_t snapshotSize, std::size_t historyFrames, std::size_t arenaBytes)
+    :
+    m_snapshotSize(snapshotSize),
+    //a segment ends at a run of unchanged bytes longer than its header, so it covers at least that many bytes more than it holds,
+    //unless it was split, which takes another header per MAX_SEGMENT_LENGTH bytes at most
+    m_maxDeltaSize(snapshotSize + SEGMENT_HEADER_SIZE * (snapshotSize / (SEGMENT_HEADER_SIZE + 1) + snapshotSize / MAX_SEGMENT_LENGTH + 2)),
+    m_latest(snapshotSize),
+    m_hasLatest(false),
+    m_pending(snapshotSize),
+    m_arena(arenaBytes),
+    m_entries(historyFrames),
+    m_oldestEntry(0),
+    m_entryCount(0),
+    m_writeOffset(0),
+    m_frameCount(0),
+    m_usedBytes(0),
+    m_captureNanoseconds(0),
+    m_captureCount(0)
+{
+    if (historyFrames == 0 or arenaBytes < m_maxDeltaSize)
+    {
+        throw std::invalid_argument {"Rewind history cannot hold a single frame"};
+    }
+}
+
+std::span<std::byte> CHIP8::RewindBuffer::BeginCapture()
+{
+    m_captureStart = std::chrono::steady_clock::now();
+    return m_pending;
+}
+
+void CHIP8::RewindBuffer::EndCapture()
+{
+    if (m_hasLatest)
+    {
+        //the delta is encoded in place, so the worst case has to fit behind the newest delta
+        if (m_writeOffset + m_maxDeltaSize > m_arena.size())
+        {
+            m_writeOffset = 0;
+        }
+        while (m_entryCount == m_entries.size() or 
+            (m_entryCount > 0 and m_entries[m_oldestEntry].offset >= m_writeOffset and m_entries[m_oldestEntry].offset < m_writeOffset + m_maxDeltaSize))
+        {
+            DropOldest();
+        }
+
+        const auto size = EncodeDelta(m_latest, m_pending, m_arena.data() + m_writeOffset);
+        m_entries[(m_oldestEntry + m_entryCount) % m_entries.size()] = Entry {m_writeOffset, size};
+        m_entryCount += 1;
+        m_writeOffset += size;
+        m_usedBytes += size;
+        m_frameCount = m_entryCount;
+    }
+    std::swap(m_latest, m_pending);
+    m_hasLatest = true;
+
+    const auto captureTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_captureStart);
+    m_captureNanoseconds.fetch_add(captureTime.count(), std::memory_order_relaxed);
+    m_captureCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::span<const std::byte> CHIP8::RewindBuffer::StepBack()
+{
+    if (m_entryCount == 0)
+    {
+        return {};
+    }
+
+    m_entryCount -= 1;
+    const auto newest = m_entries[(m_oldestEntry + m_entryCount) % m_entries.size()];
+    ApplyDelta(std::span {m_arena}.subspan(newest.offset, newest.size), m_latest);
+    m_writeOffset = newest.offset;
+    m_usedBytes -= newest.size;
+    m_frameCount = m_entryCount;
+    return m_latest;
+}
+
+CHIP8::RewindBuffer::Statistics CHIP8::RewindBuffer::GetStatistics() const
+{
+    const auto captureCount = m_captureCount.load(std::memory_order_relaxed);
+    return Statistics 
+    {
+        m_frameCount,
+        m_usedBytes,
+        m_arena.size(),
+        std::chrono::nanoseconds {captureCount > 0 ? m_captureNanoseconds.load(std::memory_order_relaxed) / captureCount : 0}
+    };
+}
+
+void CHIP8::RewindBuffer::DropOldest()
+{
+    m_usedBytes -= m_entries[m_oldestEntry].size;
+    m_oldestEntry = (m_oldestEntry + 1) % m_entries.size();
+    m_entryCount -= 1;
+}
+
+std::size_t CHIP8::RewindBuffer::EncodeDelta(std::span<const std::byte> older, std::span<const std::byte> newer, std::byte* output)
+{
+    const auto size = older.size();
+    const auto* outputStart = output;
+    std::size_t position {0};
+    while (true)
+    {
+        //most of a snapshot is unchanged between frames, skip it a word at a time
+        auto literalStart = position;
+        while (literalStart + sizeof(std::uint64_t) <= size and 
+            std::memcmp(older.data() + literalStart, newer.data() + literalStart, sizeof(std::uint64_t)) == 0)
+        {
+            literalStart += sizeof(std::uint64_t);
+        }
+        while (literalStart < size and older[literalStart] == newer[literalStart])
+        {
+            literalStart += 1;
+        }
+        //unchanged bytes at the end are not stored
+        if (literalStart == size)
+        {
+            break;
+        }
+
+        //a few unchanged bytes are cheaper to keep in the literal than to start another segment
+        auto literalEnd = literalStart + 1;
+        std::size_t unchangedRun {0};
+        for (auto index = literalEnd; index < size and unchangedRun <= SEGMENT_HEADER_SIZE; ++index)
+        {
+            if (older[index] == newer[index])
+            {
+                unchangedRun += 1;
+            }
+            else
+            {
+                unchangedRun = 0;
+                literalEnd = index + 1;
+            }
+        }
+
+        //a skip too long for one header is made of empty segments
+        for (; literalStart - position > MAX_SEGMENT_LENGTH; position += MAX_SEGMENT_LENGTH)
+        {
+            const std::uint16_t header[] {static_cast<std::uint16_t>(MAX_SEGMENT_LENGTH), 0};
+            std::memcpy(output, header, SEGMENT_HEADER_SIZE);
+            output += SEGMENT_HEADER_SIZE;
+        }
+        //the rest of a long literal goes to the next segment
+        literalEnd = std::min(literalEnd, literalStart + MAX_SEGMENT_LENGTH);
+
+        const std::uint16_t header[] {static_cast<std::uint16_t>(literalStart - position), static_cast<std::uint16_t>(literalEnd - literalStart)};
+        std::memcpy(output, header, SEGMENT_HEADER_SIZE);
+        output += SEGMENT_HEADER_SIZE;
+        for (auto index = literalStart; index < literalEnd; ++index)
+        {
+            *output++ = older[index] ^ newer[index];
+        }
+        position = literalEnd;
+    }
+
+    //an unchanged snapshot still gets an empty segment, so every delta has its own place in the arena
+    if (output == outputStart)
+    {
+        std::memset(output, 0, SEGMENT_HEADER_SIZE);
+        output += SEGMENT_HEADER_SIZE;
+    }
+    return output - outputStart;
+}
+
+void CHIP8::RewindBuffer::ApplyDelta(std::span<const std::byte> delta, std::span<std::byte> snapshot)
+{
+    std::size_t position {0};
+    while (not delta.empty())
+    {
+        std::uint16_t header[2];
+        std::memcpy(header, delta.data(), SEGMENT_HEADER_SIZE);
+        position += header[0];
+        const auto literal = delta.subspan(SEGMENT_HEADER_SIZE, header[1]);
+        for (const auto value : literal)
+        {
+            snapshot[position++] ^= value;
+        }
+        delta = delta.subspan(SEGMENT_HEADER_SIZE + literal.size());
+    }
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace CHIP8
+{
+    //history of fixed-size snapshots for stepping back one frame at a time;
+    //a snapshot is stored as the run-length encoded XOR against the snapshot after it,
+    //so the bytes a frame leaves unchanged cost nothing and stepping back decodes a single delta;
+    //everything is allocated up front, capturing never allocates
+    class RewindBuffer
+    {
+    public:
+        struct Statistics
+        {
+            //frames which can be stepped back
+            std::size_t frameCount;
+            std::size_t usedBytes, capacityBytes;
+            //average time from BeginCapture to EndCapture
+            std::chrono::nanoseconds averageCaptureTime;
+        };
+
+    private:
+        //a delta is a sequence of segments, each made of the number of unchanged bytes to skip,
+        //the number of changed bytes and the changed bytes XORed with their previous values
+        static constexpr std::size_t SEGMENT_HEADER_SIZE = 2 * sizeof(std::uint16_t);
+        //longer skips and literals are split over several segments
+        static constexpr std::size_t MAX_SEGMENT_LENGTH = 0xFFFF;
+
+        //where a delta is stored in the arena
+        struct Entry
+        {
+            std::size_t offset, size;
+        };
+
+        std::size_t m_snapshotSize, m_maxDeltaSize;
+        //newest snapshot, the deltas lead back from it
+        std::vector<std::byte> m_latest;
+        bool m_hasLatest;
+        //filled between BeginCapture and EndCapture
+        std::vector<std::byte> m_pending;
+        std::chrono::steady_clock::time_point m_captureStart;
+
+        std::vector<std::byte> m_arena;
+        //ring of deltas in the order they were captured, the oldest is m_entries[m_oldestEntry]
+        std::vector<Entry> m_entries;
+        std::size_t m_oldestEntry, m_entryCount;
+        //where the next delta is written, right behind the newest one
+        std::size_t m_writeOffset;
+
+        //read by other threads for reporting
+        std::atomic_size_t m_frameCount, m_usedBytes;
+        std::atomic_uint64_t m_captureNanoseconds, m_captureCount;
+
+        static std::size_t EncodeDelta(std::span<const std::byte> older, std::span<const std::byte> newer, std::byte* output);
+        static void ApplyDelta(std::span<const std::byte> delta, std::span<std::byte> snapshot);
+
+        void DropOldest();
+
+    public:
+        //keeps at most historyFrames frames within arenaBytes of encoded deltas
+        RewindBuffer(std::size_t snapshotSize, std::size_t historyFrames, std::size_t arenaBytes);
+        //the snapshot to fill in, its capture is timed from here
+        std::span<std::byte> BeginCapture();
+        //encodes the filled snapshot, dropping the oldest frames if the history is full
+        void EndCapture();
+        //returns the snapshot of the frame before the newest one and forgets the newest,
+        //returns an empty span when there is no older frame
+        std::span<const std::byte> StepBack();
+        //may be called from any thread
+        Statistics GetStatistics() const;
+    };
+}
\ No newline at end of file
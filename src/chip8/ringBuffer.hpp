@@ -0,0 +1,104 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace CHIP8
+{
+    //queue between one writer thread and one reader thread without locks, neither side ever waits;
+    //the capacity is rounded up to a power of two so positions wrap around with a mask
+    template <typename T>
+    class RingBuffer
+    {
+        //keeps the positions of the two sides from sharing a cache line
+        static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+        std::vector<T> m_slots;
+        std::size_t m_mask;
+        //positions only ever grow, they are reduced with the mask when indexing
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_writePosition;
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_readPosition;
+
+        //copies count values between the ring starting at position and a linear range
+        template <typename Copy>
+        void CopyWrapped(std::size_t position, std::size_t count, Copy copy)
+        {
+            const auto start = position & m_mask;
+            const auto firstPart = std::min(count, m_slots.size() - start);
+            copy(start, 0, firstPart);
+            copy(0, firstPart, count - firstPart);
+        }
+
+    public:
+        explicit RingBuffer(std::size_t capacity)
+            :
+            m_slots(std::bit_ceil(std::max(capacity, std::size_t {1}))),
+            m_mask(m_slots.size() - 1),
+            m_writePosition(0),
+            m_readPosition(0)
+        {
+
+        }
+
+        //writer side, returns how many of the values fitted
+        std::size_t Write(std::span<const T> values)
+        {
+            const auto writePosition = m_writePosition.load(std::memory_order_relaxed);
+            const auto used = writePosition - m_readPosition.load(std::memory_order_acquire);
+            const auto count = std::min(values.size(), m_slots.size() - used);
+            CopyWrapped(writePosition, count, [&](std::size_t slot, std::size_t value, std::size_t length)
+            {
+                std::copy_n(values.begin() + value, length, m_slots.begin() + slot);
+            });
+            m_writePosition.store(writePosition + count, std::memory_order_release);
+            return count;
+        }
+
+        //reader side, returns how many values were available
+        std::size_t Read(std::span<T> values)
+        {
+            const auto readPosition = m_readPosition.load(std::memory_order_relaxed);
+            const auto available = m_writePosition.load(std::memory_order_acquire) - readPosition;
+            const auto count = std::min(values.size(), available);
+            CopyWrapped(readPosition, count, [&](std::size_t slot, std::size_t value, std::size_t length)
+            {
+                std::copy_n(m_slots.begin() + slot, length, values.begin() + value);
+            });
+            m_readPosition.store(readPosition + count, std::memory_order_release);
+            return count;
+        }
+
+        //either side, exact for the calling side and a snapshot of the other
+        std::size_t GetSize() const
+        {
+            return m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_acquire);
+        }
+
+        std::size_t GetCapacity() const
+        {
+            return m_slots.size();
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,455 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "staticAnalyzer.hpp"
+#include <algorithm>
+#include <array>
+#include <format>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include "beeper.hpp"
+#include "instruction.hpp"
+
+namespace
+{
+    constexpr std::uint16_t INSTRUCTION_WIDTH = 2;
+    constexpr std::size_t REGISTER_COUNT = 16;
+    constexpr std::uint32_t MAX_REGISTER_VALUE = 0xFF, MAX_ADDRESS = 0xFFFF, MAX_KEY = 0xF;
+    //the fonts and every digit Fx29 and Fx30 may point I at lie within the first 4 KiB
+    constexpr std::uint32_t MAX_FONT_ADDRESS = 0xFFF;
+    //changes of the state at an address before the bounds which keep moving are set to their limits,
+    //so loops counting a register or I converge after a few iterations
+    constexpr unsigned WIDENING_DELAY = 4;
+
+    //values a register or I may hold
+    struct Range
+    {
+        std::uint32_t low, high;
+
+        bool operator==(const Range&) const = default;
+    };
+
+    constexpr Range Exactly(std::uint32_t value)
+    {
+        return {value, value};
+    }
+
+    Range Join(Range a, Range b)
+    {
+        return {std::min(a.low, b.low), std::max(a.high, b.high)};
+    }
+
+    Range Widen(Range previous, Range joined, std::uint32_t max)
+    {
+        return {joined.low < previous.low ? 0 : joined.low, joined.high > previous.high ? max : joined.high};
+    }
+
+    //addition modulo max + 1, which stays exact unless only some of the sums wrap around
+    Range AddWrapping(Range a, Range b, std::uint32_t max)
+    {
+        const Range sum {a.low + b.low, a.high + b.high};
+        if (sum.high <= max)
+        {
+            return sum;
+        }
+        if (sum.low > max)
+        {
+            return {sum.low - max - 1, sum.high - max - 1};
+        }
+        return {0, max};
+    }
+
+    //what is known about the machine whenever it reaches an address
+    struct AbstractState
+    {
+        std::array<Range, REGISTER_COUNT> registers;
+        Range addressRegister;
+
+        bool operator==(const AbstractState&) const = default;
+    };
+
+    AbstractState Join(const AbstractState& a, const AbstractState& b)
+    {
+        AbstractState joined;
+        for (std::size_t index {0}; index < REGISTER_COUNT; ++index)
+        {
+            joined.registers[index] = Join(a.registers[index], b.registers[index]);
+        }
+        joined.addressRegister = Join(a.addressRegister, b.addressRegister);
+        return joined;
+    }
+
+    //abstract interpretation over the instructions reachable from the entry, which are found along the way
+    class Analyzer
+    {
+        struct Visit
+        {
+            AbstractState state;
+            unsigned changes;
+        };
+
+        std::span<const std::byte> m_memory;
+        const CHIP8::Quirks m_quirks;
+        //indexed by the address of the instruction
+        std::unordered_map<std::uint16_t, Visit> m_visits;
+        std::vector<std::uint16_t> m_worklist;
+        //00EE may return to the address after any call with the state of any other 00EE
+        std::optional<AbstractState> m_returnState;
+        std::vector<std::uint16_t> m_returnAddresses;
+        //instructions which may continue at the last byte of memory, where no instruction fits
+        std::set<std::uint16_t> m_strandedInstructions;
+
+        std::uint16_t Fetch(std::uint16_t address) const
+        {
+            return std::to_integer<std::uint16_t>(m_memory[address]) << 8 | std::to_integer<std::uint16_t>(m_memory[address + 1]);
+        }
+
+        bool IsFetchable(std::uint16_t address) const
+        {
+            return address + 1U < m_memory.size();
+        }
+
+        void Propagate(std::uint16_t source, std::uint16_t target, const AbstractState& state)
+        {
+            if (not IsFetchable(target))
+            {
+                m_strandedInstructions.insert(source);
+                return;
+            }
+
+            const auto [visit, inserted] = m_visits.try_emplace(target, Visit {state, 0});
+            auto& previous = visit->second.state;
+            auto joined = Join(previous, state);
+            if (not inserted and joined == previous)
+            {
+                return;
+            }
+
+            if (++visit->second.changes > WIDENING_DELAY)
+            {
+                for (std::size_t index {0}; index < REGISTER_COUNT; ++index)
+                {
+                    joined.registers[index] = Widen(previous.registers[index], joined.registers[index], MAX_REGISTER_VALUE);
+                }
+                joined.addressRegister = Widen(previous.addressRegister, joined.addressRegister, MAX_ADDRESS);
+            }
+            previous = joined;
+            m_worklist.push_back(target);
+        }
+
+        //the next instruction is skipped as a whole, F000 nnnn included
+        void Skip(std::uint16_t address, std::uint16_t next, const AbstractState& state)
+        {
+            Propagate(address, next, state);
+            if (IsFetchable(next))
+            {
+                const auto width = CHIP8::IsLongInstruction(Fetch(next)) ? 2 * INSTRUCTION_WIDTH : INSTRUCTION_WIDTH;
+                Propagate(address, static_cast<std::uint16_t>(next + width), state);
+            }
+        }
+
+        void Call(std::uint16_t address, std::uint16_t subroutine, const AbstractState& state)
+        {
+            const auto returnAddress = static_cast<std::uint16_t>(address + INSTRUCTION_WIDTH);
+            if (std::ranges::find(m_returnAddresses, returnAddress) == m_returnAddresses.end())
+            {
+                m_returnAddresses.push_back(returnAddress);
+                if (m_returnState.has_value())
+                {
+                    Propagate(address, returnAddress, m_returnState.value());
+                }
+            }
+            Propagate(address, subroutine, state);
+        }
+
+        void Return(std::uint16_t address, const AbstractState& state)
+        {
+            const auto joined = m_returnState.has_value() ? Join(m_returnState.value(), state) : state;
+            if (m_returnState == joined)
+            {
+                return;
+            }
+            m_returnState = joined;
+            for (const auto returnAddress : m_returnAddresses)
+            {
+                Propagate(address, returnAddress, joined);
+            }
+        }
+
+        void AdvanceAddressRegister(AbstractState& state, std::uint8_t x) const
+        {
+            switch (m_quirks.addressIncrement)
+            {
+                case CHIP8::AddressIncrement::None: 
+                    break;
+                case CHIP8::AddressIncrement::ByX: 
+                    state.addressRegister = AddWrapping(state.addressRegister, Exactly(x), MAX_ADDRESS); 
+                    break;
+                case CHIP8::AddressIncrement::ByXPlusOne: 
+                    state.addressRegister = AddWrapping(state.addressRegister, Exactly(x + 1U), MAX_ADDRESS); 
+                    break;
+            }
+        }
+
+        //applies the instruction to a copy of its state and passes the result on to every address it may continue at
+        void Step(std::uint16_t address)
+        {
+            auto state = m_visits.at(address).state;
+            const auto operands = CHIP8::DecodedOpcode {Fetch(address)};
+            const auto next = static_cast<std::uint16_t>(address + INSTRUCTION_WIDTH);
+            auto& vx = state.registers[operands.x];
+            const auto vy = state.registers[operands.y];
+            auto& flag = state.registers[0xF];
+
+            switch (operands.opcode >> 12)
+            {
+                case 0x0:
+                    if (operands.opcode == 0x00EE)
+                    {
+                        Return(address, state);
+                        return;
+                    }
+                    //00FD executes itself until the program is started again
+                    if (operands.opcode == 0x00FD)
+                    {
+                        return;
+                    }
+                    break;
+                case 0x1:
+                    Propagate(address, operands.nnn, state);
+                    return;
+                case 0x2:
+                    Call(address, operands.nnn, state);
+                    return;
+                case 0x3: case 0x4: case 0x9:
+                    Skip(address, next, state);
+                    return;
+                case 0x5:
+                    if (operands.n == 0x3)
+                    {
+                        std::fill(state.registers.begin() + std::min(operands.x, operands.y), 
+                            state.registers.begin() + std::max(operands.x, operands.y) + 1, Range {0, MAX_REGISTER_VALUE});
+                    }
+                    else if (operands.n != 0x2)
+                    {
+                        Skip(address, next, state);
+                        return;
+                    }
+                    break;
+                case 0x6:
+                    vx = Exactly(operands.nn);
+                    break;
+                case 0x7:
+                    vx = AddWrapping(vx, Exactly(operands.nn), MAX_REGISTER_VALUE);
+                    break;
+                case 0x8:
+                    switch (operands.n)
+                    {
+                        case 0x0: 
+                            vx = vy; 
+                            break;
+                        case 0x1: case 0x2: case 0x3:
+                            vx = operands.n == 0x2 ? Range {0, std::min(vx.high, vy.high)} : Range {0, MAX_REGISTER_VALUE};
+                            if (m_quirks.logicResetsFlag)
+                            {
+                                flag = Exactly(0);
+                            }
+                            break;
+                        case 0x4: case 0x5: case 0x6: case 0x7: case 0xE:
+                            vx = Range {0, MAX_REGISTER_VALUE};
+                            flag = Range {0, 1};
+                            break;
+                        default: 
+                            return;
+                    }
+                    break;
+                case 0xA:
+                    state.addressRegister = Exactly(operands.nnn);
+                    break;
+                case 0xB:
+                {
+                    const auto offset = state.registers[m_quirks.jumpsWithVx ? operands.x : 0];
+                    for (auto target = operands.nnn + offset.low; target <= operands.nnn + offset.high; ++target)
+                    {
+                        Propagate(address, static_cast<std::uint16_t>(target), state);
+                    }
+                    return;
+                }
+                case 0xC:
+                    vx = Range {0, operands.nn};
+                    break;
+                case 0xD:
+                    flag = Range {0, 1};
+                    break;
+                case 0xE:
+                    if (operands.nn == 0x9E or operands.nn == 0xA1)
+                    {
+                        Skip(address, next, state);
+                    }
+                    return;
+                case 0xF:
+                    if (operands.opcode == 0xF000)
+                    {
+                        //the address is the word after the opcode
+                        if (not IsFetchable(next))
+                        {
+                            m_strandedInstructions.insert(address);
+                            return;
+                        }
+                        state.addressRegister = Exactly(Fetch(next));
+                        Propagate(address, static_cast<std::uint16_t>(next + INSTRUCTION_WIDTH), state);
+                        return;
+                    }
+                    if (operands.opcode == 0xF002)
+                    {
+                        break;
+                    }
+                    switch (operands.nn)
+                    {
+                        case 0x01: case 0x15: case 0x18: case 0x33: case 0x3A: case 0x75:
+                            break;
+                        case 0x07:
+                            vx = Range {0, MAX_REGISTER_VALUE};
+                            break;
+                        case 0x0A:
+                            vx = Range {0, MAX_KEY};
+                            break;
+                        case 0x1E:
+                            state.addressRegister = AddWrapping(state.addressRegister, vx, MAX_ADDRESS);
+                            break;
+                        case 0x29: case 0x30:
+                            state.addressRegister = Range {0, MAX_FONT_ADDRESS};
+                            break;
+                        case 0x55:
+                            AdvanceAddressRegister(state, operands.x);
+                            break;
+                        case 0x65:
+                            std::fill_n(state.registers.begin(), operands.x + 1, Range {0, MAX_REGISTER_VALUE});
+                            AdvanceAddressRegister(state, operands.x);
+                            break;
+                        case 0x85:
+                            std::fill_n(state.registers.begin(), operands.x + 1, Range {0, MAX_REGISTER_VALUE});
+                            break;
+                        default:
+                            return;
+                    }
+                    break;
+            }
+            Propagate(address, next, state);
+        }
+
+    public:
+        Analyzer(std::span<const std::byte> memory, const CHIP8::Quirks& quirks)
+            :
+            m_memory(memory),
+            m_quirks(quirks)
+        {
+
+        }
+
+        CHIP8::ProgramAnalysis Run(const CHIP8::AnalysisEntry& entry)
+        {
+            AbstractState state;
+            for (std::size_t index {0}; index < REGISTER_COUNT; ++index)
+            {
+                state.registers[index] = Exactly(std::to_integer<std::uint32_t>(entry.registers[index]));
+            }
+            state.addressRegister = Exactly(entry.addressRegister);
+            for (const auto callAddress : entry.callAddresses)
+            {
+                m_returnAddresses.push_back(static_cast<std::uint16_t>(callAddress + INSTRUCTION_WIDTH));
+            }
+
+            Propagate(entry.programCounter, entry.programCounter, state);
+            while (not m_worklist.empty())
+            {
+                const auto address = m_worklist.back();
+                m_worklist.pop_back();
+                Step(address);
+            }
+
+            CHIP8::ProgramAnalysis analysis {std::vector<bool>(m_memory.size()), std::vector<bool>(m_memory.size()), {}};
+            for (const auto& [address, visit] : m_visits)
+            {
+                const auto opcode = Fetch(address);
+                const std::size_t width = CHIP8::IsLongInstruction(opcode) ? 2 * INSTRUCTION_WIDTH : INSTRUCTION_WIDTH;
+                for (std::size_t offset {0}; offset < width; ++offset)
+                {
+                    analysis.code[(address + offset) % m_memory.size()] = true;
+                }
+
+                //the analysis assumes every plane may be selected
+                const auto length = CHIP8::GetMemoryAccessLength(opcode, CHIP8::Framebuffer::PLANES);
+                const auto highestAddress = visit.state.addressRegister.high;
+                if (length == 0 or highestAddress + length <= m_memory.size())
+                {
+                    analysis.inBounds[address] = true;
+                }
+                else
+                {
+                    analysis.diagnostics.push_back({address, std::format("Instruction {:04X} may access {} bytes at I up to {:04X}, past the end of memory", 
+                        opcode, length, highestAddress)});
+                }
+            }
+            for (const auto address : m_strandedInstructions)
+            {
+                analysis.diagnostics.push_back({address, std::format("Instruction {:04X} may continue at the last byte of memory, where no instruction fits", 
+                    Fetch(address))});
+            }
+            std::ranges::stable_sort(analysis.diagnostics, {}, &CHIP8::AnalysisDiagnostic::address);
+            return analysis;
+        }
+    };
+}
+
+std::size_t CHIP8::GetMemoryAccessLength(std::uint16_t opcode, unsigned planeCount)
+{
+    const auto decodedOpcode = DecodedOpcode {opcode};
+    switch (opcode >> 12)
+    {
+        //5xy2 and 5xy3 copy the registers from x to y in either order
+        case 0x5:
+            if (decodedOpcode.n == 0x2 or decodedOpcode.n == 0x3)
+            {
+                return std::max(decodedOpcode.x, decodedOpcode.y) - std::min(decodedOpcode.x, decodedOpcode.y) + 1U;
+            }
+            return 0;
+        //Dxy0 draws a 16x16 sprite of 32 bytes, every selected plane reads a sprite of its own
+        case 0xD:
+            return (decodedOpcode.n == 0 ? 32U : decodedOpcode.n) * planeCount;
+        case 0xF:
+            if (opcode == 0xF002)
+            {
+                return std::tuple_size_v<Beeper::Pattern>;
+            }
+            switch (decodedOpcode.nn)
+            {
+                case 0x33: return 3;
+                case 0x55: case 0x65: return decodedOpcode.x + 1U;
+                default: return 0;
+            }
+        default:
+            return 0;
+    }
+}
+
+CHIP8::ProgramAnalysis CHIP8::AnalyzeProgram(std::span<const std::byte> memory, const AnalysisEntry& entry, const Quirks& quirks)
+{
+    return Analyzer {memory, quirks}.Run(entry);
+}
\ No newline at end of file
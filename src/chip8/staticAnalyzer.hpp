@@ -0,0 +1,64 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "quirks.hpp"
+
+namespace CHIP8
+{
+    //machine state the analysis starts from
+    struct AnalysisEntry
+    {
+        std::uint16_t programCounter, addressRegister;
+        std::span<const std::byte> registers;
+        //addresses of the calls on the stack, their subroutines return right after them
+        std::span<const std::uint16_t> callAddresses;
+    };
+
+    //instruction which may access memory past its end or move the program counter where no instruction fits
+    struct AnalysisDiagnostic
+    {
+        std::uint16_t address;
+        std::string message;
+    };
+
+    //what holds for every execution from the entry as long as no instruction of the program is overwritten;
+    //both vectors are indexed by address and empty if nothing was analyzed
+    struct ProgramAnalysis
+    {
+        //instructions which stay within memory whatever path reaches them
+        std::vector<bool> inBounds;
+        //bytes of every instruction which may be executed, writing to them invalidates the analysis
+        std::vector<bool> code;
+        //sorted by address
+        std::vector<AnalysisDiagnostic> diagnostics;
+    };
+
+    //bytes the instruction reads or writes starting at I with the given number of planes selected, 0 if it does not access memory
+    std::size_t GetMemoryAccessLength(std::uint16_t opcode, unsigned planeCount);
+
+    //follows every path from the entry, tracking the ranges of I and the registers, to prove which instructions
+    //access memory in bounds
+    ProgramAnalysis AnalyzeProgram(std::span<const std::byte> memory, const AnalysisEntry& entry, const Quirks& quirks);
+}
\ No newline at end of file
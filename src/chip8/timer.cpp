@@ -16,48 +16,24 @@
     If not, see <https://www.gnu.org/licenses/>. 
 */
 
-#include <boost/asio/error.hpp>
-#include <functional>
 #include "timer.hpp"
 
-CHIP8::Timer::Timer(asio::io_context& ctx)
+CHIP8::Timer::Timer()
     :
     m_value(0),
-    m_sixtyHerzTimer(ctx)
+    m_setFrame(0)
 {
     
 }
 
-CHIP8::Timer::~Timer()
+void CHIP8::Timer::Set(std::uint8_t value, Frame frame)
 {
-    m_sixtyHerzTimer.cancel();
+    m_value = value;
+    m_setFrame = frame;
 }
 
-void CHIP8::Timer::Set(std::uint8_t value)
+std::uint8_t CHIP8::Timer::GetValue(Frame frame) const
 {
-    if (m_value == 0)
-    {
-        m_value = value;
-        SetTimer();
-    }
-}
-
-void CHIP8::Timer::OnTimer(const boost::system::error_code& errc)
-{
-    if (m_value > 0 and not errc)
-    {
-        m_value -= 1;
-        SetTimer();
-    }
-}
-
-void CHIP8::Timer::SetTimer()
-{
-    m_sixtyHerzTimer.expires_after(PERIOD);
-    m_sixtyHerzTimer.async_wait(std::bind(&CHIP8::Timer::OnTimer, this, std::placeholders::_1));
-}
-
-std::uint8_t CHIP8::Timer::GetValue() const
-{
-    return m_value;
+    const auto elapsedFrames = frame - m_setFrame;
+    return elapsedFrames < m_value ? static_cast<std::uint8_t>(m_value - elapsedFrames) : 0;
 }
\ No newline at end of file
@@ -18,31 +18,28 @@
 
 #pragma once
 
-#include <atomic>
-#include <chrono>
-#include <boost/asio.hpp>
-#include <boost/asio/steady_timer.hpp>
+#include <cstdint>
 
 namespace CHIP8
 {
-    namespace asio = boost::asio;
-
-    using namespace std::chrono_literals;
-
+    //60 Hz countdown register, nothing counts it down, its value is derived from
+    //the number of emulated frames which have passed since it was set
     class Timer 
     {
-        static constexpr auto PERIOD = 17ms;
-        std::atomic_uint8_t m_value;
-        asio::steady_timer m_sixtyHerzTimer;
+    public:
+        //emulated frames since the VM started
+        using Frame = std::uint64_t;
 
-        void SetTimer();
-        void OnTimer(const boost::system::error_code& errc);
+    private:
+        std::uint8_t m_value;
+        Frame m_setFrame;
 
     public:
-        Timer(asio::io_context& ctx);
-        ~Timer();
+        Timer();
 
-        void Set(std::uint8_t value);
-        std::uint8_t GetValue() const;
+        //starts counting down from the value in the given frame, also while a previous value still counts down
+        void Set(std::uint8_t value, Frame frame);
+        //frames must not go backwards after Set
+        std::uint8_t GetValue(Frame frame) const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace CHIP8
+{
+    //hands finished values from one writer thread to one reader thread without locks,
+    //neither side ever waits and the reader always sees a complete value
+    template <typename T>
+    class TripleBuffer
+    {
+        static constexpr std::uint8_t INDEX_MASK = 0b011, FRESH = 0b100;
+        //keeps the indices of the two sides from sharing a cache line
+        static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+        std::array<T, 3> m_slots;
+        //slot exchanged between the two sides, FRESH is set while it holds a value the reader has not taken
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint8_t> m_middle;
+        alignas(CACHE_LINE_SIZE) std::uint8_t m_back;
+        alignas(CACHE_LINE_SIZE) std::uint8_t m_front;
+
+    public:
+        TripleBuffer()
+            :
+            m_slots(),
+            m_middle(1),
+            m_back(0),
+            m_front(2)
+        {
+
+        }
+
+        //writer side, the value is not visible to the reader until it is published
+        T& GetBackBuffer()
+        {
+            return m_slots[m_back];
+        }
+
+        //writer side
+        void Publish()
+        {
+            m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        //reader side, the reference stays valid and unchanged until the next call
+        const T& GetFrontBuffer()
+        {
+            if (m_middle.load(std::memory_order_relaxed) & FRESH)
+            {
+                m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+            }
+            return m_slots[m_front];
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "vmPool.hpp"
+#include "inputLog.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+CHIP8::VmPool::VmPool(unsigned workerCount, VirtualMachine::ExecutionEngine engine)
+    :
+    m_workerCount(workerCount > 0 ? workerCount : std::max(std::thread::hardware_concurrency(), 1U)),
+    m_executionEngine(engine),
+    m_clockSpeed(VirtualMachine::DEFAULT_CLOCK_SPEED)
+{
+    for (unsigned worker {0}; worker < m_workerCount; ++worker)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+void CHIP8::VmPool::SetClockSpeed(std::uint32_t instructionsPerSecond)
+{
+    m_clockSpeed = instructionsPerSecond;
+}
+
+std::size_t CHIP8::VmPool::Add(std::span<const std::byte> program, std::size_t frameCount, std::uint32_t seed, std::vector<std::uint16_t> keyFrames)
+{
+    m_instances.push_back(Instance {{program.begin(), program.end()}, frameCount, seed, std::move(keyFrames), nullptr, {}});
+    return m_instances.size() - 1;
+}
+
+std::vector<CHIP8::VmPool::InstanceResult> CHIP8::VmPool::Run(std::size_t sliceFrames)
+{
+    //no instance would ever make progress
+    if (sliceFrames == 0)
+    {
+        throw std::invalid_argument {"Slice length must be greater than zero"};
+    }
+
+    //deal the instances out round robin, stealing evens out whatever imbalance remains
+    for (std::size_t instanceIndex {0}; instanceIndex < m_instances.size(); ++instanceIndex)
+    {
+        m_queues[instanceIndex % m_workerCount]->instances.push_back(instanceIndex);
+    }
+
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned worker {0}; worker < m_workerCount; ++worker)
+        {
+            workers.emplace_back(&CHIP8::VmPool::RunWorker, this, worker, sliceFrames);
+        }
+    }
+
+    std::vector<InstanceResult> results;
+    results.reserve(m_instances.size());
+    for (auto& instance : m_instances)
+    {
+        results.push_back(std::move(instance.result));
+    }
+    m_instances.clear();
+    return results;
+}
+
+unsigned CHIP8::VmPool::GetWorkerCount() const
+{
+    return m_workerCount;
+}
+
+void CHIP8::VmPool::RunWorker(unsigned workerIndex, std::size_t sliceFrames)
+{
+    while (true)
+    {
+        //an unfinished instance only ever goes back to the queue of the worker running it,
+        //so once nothing is left to steal the remaining instances are taken care of
+        const auto instanceIndex = TakeInstance(workerIndex);
+        if (not instanceIndex.has_value())
+        {
+            return;
+        }
+
+        if (not RunSlice(m_instances[instanceIndex.value()], sliceFrames))
+        {
+            auto& queue = *m_queues[workerIndex];
+            std::lock_guard lock {queue.mtx};
+            queue.instances.push_front(instanceIndex.value());
+        }
+    }
+}
+
+std::optional<std::size_t> CHIP8::VmPool::TakeInstance(unsigned workerIndex)
+{
+    {
+        auto& queue = *m_queues[workerIndex];
+        std::lock_guard lock {queue.mtx};
+        if (not queue.instances.empty())
+        {
+            const auto instanceIndex = queue.instances.back();
+            queue.instances.pop_back();
+            return instanceIndex;
+        }
+    }
+
+    //steal from the other workers, starting with the next one so thieves spread out
+    for (unsigned offset {1}; offset < m_workerCount; ++offset)
+    {
+        auto& queue = *m_queues[(workerIndex + offset) % m_workerCount];
+        std::lock_guard lock {queue.mtx};
+        if (not queue.instances.empty())
+        {
+            const auto instanceIndex = queue.instances.front();
+            queue.instances.pop_front();
+            return instanceIndex;
+        }
+    }
+
+    return {};
+}
+
+bool CHIP8::VmPool::RunSlice(Instance& instance, std::size_t sliceFrames)
+{
+    auto& result = instance.result;
+    bool finished {false};
+    //an exception must not leave the worker thread, a program which cannot be loaded fails its instance
+    try
+    {
+        if (not instance.vm)
+        {
+            result.executedFrames = 0;
+            instance.vm = std::make_unique<VirtualMachine>();
+            instance.vm->SetExecutionEngine(m_executionEngine);
+            instance.vm->SetClockSpeed(m_clockSpeed);
+            instance.vm->SetRandomSeed(instance.seed);
+            if (not instance.keyFrames.empty())
+            {
+                instance.vm->SetKeyboard(std::make_unique<ReplayKeyboard>(std::move(instance.keyFrames)));
+            }
+            instance.vm->LoadProgram(instance.program);
+        }
+
+        //whole frames, so the timers count down as they would in real time
+        const auto sliceLength = std::min(sliceFrames, instance.frameBudget - result.executedFrames);
+        instance.vm->RunFrames(sliceLength);
+        result.executedFrames += sliceLength;
+        finished = result.executedFrames >= instance.frameBudget;
+    }
+    catch (const std::exception& exception)
+    {
+        result.error = exception.what();
+        finished = true;
+    }
+
+    if (finished)
+    {
+        //the VM is missing only if it could not even be created
+        if (instance.vm)
+        {
+            auto& vm = *instance.vm;
+            result.display = vm.GetDisplayMemory();
+            std::ranges::copy(vm.GetRegisters(), result.registers.begin());
+            result.addressRegister = vm.GetAddressRegister();
+            result.programCounter = vm.GetProgramCounter();
+        }
+        instance.vm.reset();
+        instance.program = {};
+    }
+    return finished;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "chip8vm.hpp"
+#include "framebuffer.hpp"
+
+namespace CHIP8
+{
+    //runs many independent VMs without pacing on a fixed set of worker threads,
+    //every instance gets time slices of whole frames until it has run its frame budget
+    class VmPool
+    {
+    public:
+        struct InstanceResult
+        {
+            Framebuffer display;
+            std::array<std::byte, 16> registers;
+            std::uint16_t addressRegister, programCounter;
+            //frames of the slices which completed, a failing slice is not counted
+            std::size_t executedFrames;
+            //what the VM threw, empty if it ran through its whole budget
+            std::string error;
+        };
+
+    private:
+        struct Instance
+        {
+            std::vector<std::byte> program;
+            std::size_t frameBudget;
+            std::uint32_t seed;
+            //keys held in each frame, the keyboard stays released when empty
+            std::vector<std::uint16_t> keyFrames;
+            //created by the worker running the first slice and destroyed after the last one
+            std::unique_ptr<VirtualMachine> vm;
+            InstanceResult result;
+        };
+
+        //instances waiting for their next slice, the owner takes from the back and thieves from the front
+        struct WorkQueue
+        {
+            std::mutex mtx;
+            std::deque<std::size_t> instances;
+        };
+
+        unsigned m_workerCount;
+        VirtualMachine::ExecutionEngine m_executionEngine;
+        std::uint32_t m_clockSpeed;
+        std::vector<Instance> m_instances;
+        std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+        void RunWorker(unsigned workerIndex, std::size_t sliceFrames);
+        std::optional<std::size_t> TakeInstance(unsigned workerIndex);
+        //returns whether the instance is finished
+        bool RunSlice(Instance& instance, std::size_t sliceFrames);
+
+    public:
+        //uses every hardware thread when the worker count is 0
+        explicit VmPool(unsigned workerCount = 0, VirtualMachine::ExecutionEngine engine = VirtualMachine::ExecutionEngine::Threaded);
+        //instructions executed per second of emulated time by every instance
+        void SetClockSpeed(std::uint32_t instructionsPerSecond);
+        //returns the index of the instance in the results of Run,
+        //the key frames are replayed like an input log
+        std::size_t Add(std::span<const std::byte> program, std::size_t frameCount, std::uint32_t seed, std::vector<std::uint16_t> keyFrames = {});
+        //runs every added instance to completion and removes them from the pool,
+        //throws std::invalid_argument if the slice length is 0
+        std::vector<InstanceResult> Run(std::size_t sliceFrames);
+        unsigned GetWorkerCount() const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "renderer.hpp"
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <cstddef>
+
+namespace
+{
+    constexpr std::size_t BYTES_PER_PIXEL = 4;
+    //pixels lit in the second plane only and in both planes, as Octo shows them
+    const sf::Color SECOND_PLANE_COLOR {0xFF, 0x66, 0x00}, BOTH_PLANES_COLOR {0x66, 0x22, 0x00};
+}
+
+Renderer::Renderer(unsigned scale, sf::Color foreground, sf::Color background)
+    :
+    m_scale(scale),
+    m_palette {{
+        {background.r, background.g, background.b, background.a},
+        {foreground.r, foreground.g, foreground.b, foreground.a},
+        {SECOND_PLANE_COLOR.r, SECOND_PLANE_COLOR.g, SECOND_PLANE_COLOR.b, SECOND_PLANE_COLOR.a},
+        {BOTH_PLANES_COLOR.r, BOTH_PLANES_COLOR.g, BOTH_PLANES_COLOR.b, BOTH_PLANES_COLOR.a}
+    }},
+    m_width(0),
+    m_pixels(CHIP8::Framebuffer::HIGH_WIDTH * CHIP8::Framebuffer::HIGH_HEIGHT * BYTES_PER_PIXEL),
+    m_generation(0)
+{
+    //a framebuffer of generation 0 is blank
+    for (auto pixel = m_pixels.begin(); pixel != m_pixels.end(); )
+    {
+        pixel = std::ranges::copy(m_palette[0], pixel).out;
+    }
+    m_texture.create(CHIP8::Framebuffer::HIGH_WIDTH, CHIP8::Framebuffer::HIGH_HEIGHT);
+    m_texture.update(m_pixels.data());
+    m_sprite.setTexture(m_texture);
+    SetResolution(CHIP8::Framebuffer::LOW_WIDTH, CHIP8::Framebuffer::LOW_HEIGHT);
+}
+
+void Renderer::SetResolution(unsigned width, unsigned height)
+{
+    //the higher resolution shows more pixels in the same area of the window
+    m_width = width;
+    m_sprite.setTextureRect({0, 0, static_cast<int>(width), static_cast<int>(height)});
+    const auto scale = static_cast<float>(m_scale * CHIP8::Framebuffer::LOW_WIDTH) / width;
+    m_sprite.setScale(scale, scale);
+}
+
+bool Renderer::Update(const CHIP8::Framebuffer& framebuffer)
+{
+    if (framebuffer.GetGeneration() == m_generation)
+    {
+        return false;
+    }
+
+    //switching the resolution changes every row, so all of them are expanded again at the new width
+    const auto width = framebuffer.GetWidth(), height = framebuffer.GetHeight();
+    if (width != m_width)
+    {
+        SetResolution(width, height);
+    }
+
+    //the texture is updated once per run of adjacent changed rows
+    auto changedRows = framebuffer.ChangedRowsSince(m_generation);
+    if (height < std::numeric_limits<CHIP8::Framebuffer::RowMask>::digits)
+    {
+        changedRows &= (CHIP8::Framebuffer::RowMask {1} << height) - 1;
+    }
+    while (changedRows != 0)
+    {
+        const auto firstRow = static_cast<unsigned>(std::countr_zero(changedRows));
+        const auto rowCount = static_cast<unsigned>(std::countr_one(changedRows >> firstRow));
+        for (auto rowIndex = firstRow; rowIndex < firstRow + rowCount; ++rowIndex)
+        {
+            ExpandRow(framebuffer, rowIndex);
+        }
+
+        const auto rowSize = width * BYTES_PER_PIXEL;
+        m_texture.update(m_pixels.data() + firstRow * rowSize, width, rowCount, 0, firstRow);
+        //a run may reach the last bit, where shifting by its length would be undefined
+        changedRows &= firstRow + rowCount < std::numeric_limits<CHIP8::Framebuffer::RowMask>::digits ? 
+            ~CHIP8::Framebuffer::RowMask {0} << (firstRow + rowCount) : 
+            CHIP8::Framebuffer::RowMask {0};
+    }
+
+    m_generation = framebuffer.GetGeneration();
+    return true;
+}
+
+void Renderer::ExpandRow(const CHIP8::Framebuffer& framebuffer, unsigned rowIndex)
+{
+    constexpr auto WORD_BITS = CHIP8::Framebuffer::WORD_BITS;
+    const auto& firstPlane = framebuffer.GetPlane(0)[rowIndex];
+    const auto& secondPlane = framebuffer.GetPlane(1)[rowIndex];
+    auto pixel = m_pixels.begin() + rowIndex * m_width * BYTES_PER_PIXEL;
+    for (unsigned column {0}; column < m_width; ++column)
+    {
+        const auto wordIndex = column / WORD_BITS, shift = WORD_BITS - 1 - column % WORD_BITS;
+        const auto color = ((firstPlane[wordIndex] >> shift) & 1) | ((secondPlane[wordIndex] >> shift) & 1) << 1;
+        pixel = std::ranges::copy(m_palette[color], pixel).out;
+    }
+}
+
+void Renderer::Draw(sf::RenderTarget& target) const
+{
+    target.draw(m_sprite);
+}
+
+sf::Vector2u Renderer::GetSize() const
+{
+    return {CHIP8::Framebuffer::LOW_WIDTH * m_scale, CHIP8::Framebuffer::LOW_HEIGHT * m_scale};
+}
+
+CHIP8::Framebuffer::Generation Renderer::GetGeneration() const
+{
+    return m_generation;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "chip8/framebuffer.hpp"
+
+//draws the CHIP-8 display as one scaled texture, which covers the display at the low resolution
+//at either resolution
+class Renderer
+{
+    using Color = std::array<sf::Uint8, 4>;
+
+    unsigned m_scale;
+    //indexed by the color of a pixel: background, first plane, second plane and both planes
+    std::array<Color, 4> m_palette;
+    //width of the resolution the texture currently shows
+    unsigned m_width;
+    //RGBA pixels of the whole display, rows are as wide as the current resolution
+    std::vector<sf::Uint8> m_pixels;
+    sf::Texture m_texture;
+    sf::Sprite m_sprite;
+    //generation of the framebuffer the texture currently shows
+    CHIP8::Framebuffer::Generation m_generation;
+
+    void ExpandRow(const CHIP8::Framebuffer& framebuffer, unsigned rowIndex);
+    void SetResolution(unsigned width, unsigned height);
+
+public:
+    Renderer(unsigned scale, sf::Color foreground, sf::Color background);
+    //uploads the rows changed since the last update, returns false if the frame was already shown
+    bool Update(const CHIP8::Framebuffer& framebuffer);
+    void Draw(sf::RenderTarget& target) const;
+    //generation of the last frame passed to Update
+    CHIP8::Framebuffer::Generation GetGeneration() const;
+    //size of the scaled display in window pixels
+    sf::Vector2u GetSize() const;
+};
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "sfmlAudioSink.hpp"
+#include <span>
+#include "chip8/beeper.hpp"
+
+namespace
+{
+    constexpr std::uint32_t SAMPLE_RATE = CHIP8::Beeper::DEFAULT_SAMPLE_RATE;
+    //SFML keeps three chunks queued on the device, about 9 ms at this size
+    constexpr std::size_t CHUNK_SIZE = 128;
+    //covers the jitter of the frame timer, a frame is heard about 15 ms after it ran
+    constexpr std::size_t LEAD_SAMPLES = 2 * CHUNK_SIZE;
+    //beyond a frame and the lead, the queue only grows if the device clock runs slower than the frame timer
+    constexpr std::size_t MAX_QUEUED_SAMPLES = SAMPLE_RATE / 60 + 2 * LEAD_SAMPLES;
+}
+
+SfmlAudioSink::SfmlAudioSink()
+    :
+    StreamingAudioSink(SAMPLE_RATE, LEAD_SAMPLES, MAX_QUEUED_SAMPLES),
+    m_chunk(CHUNK_SIZE)
+{
+    initialize(1, SAMPLE_RATE);
+    //the default interval of 10 ms would let the queued chunks run out
+    setProcessingInterval(sf::milliseconds(1));
+}
+
+SfmlAudioSink::~SfmlAudioSink()
+{
+    //the streaming thread must not call onGetData on a partially destroyed object
+    stop();
+}
+
+void SfmlAudioSink::Play()
+{
+    play();
+}
+
+void SfmlAudioSink::Stop()
+{
+    stop();
+}
+
+bool SfmlAudioSink::onGetData(Chunk& data)
+{
+    Read(std::span {m_chunk});
+    data.samples = m_chunk.data();
+    data.sampleCount = m_chunk.size();
+    return true;
+}
+
+void SfmlAudioSink::onSeek(sf::Time)
+{
+
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <SFML/Audio/SoundStream.hpp>
+#include "chip8/audioSink.hpp"
+
+//plays the sound of the VM on the default audio device, SFML requests the samples from its own thread
+class SfmlAudioSink : public CHIP8::StreamingAudioSink, private sf::SoundStream
+{
+    //samples handed to SFML per request
+    std::vector<sf::Int16> m_chunk;
+
+    bool onGetData(Chunk& data) override;
+    void onSeek(sf::Time timeOffset) override;
+
+public:
+    SfmlAudioSink();
+    ~SfmlAudioSink() override;
+    void Play();
+    void Stop();
+};
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#include "sfmlKeyboard.hpp"
+#include <SFML/Window/Keyboard.hpp>
+#include <algorithm>
+#include <iterator>
+
+SfmlKeyboard::SfmlKeyboard()
+    :
+    m_chip8KeyToPhysicalKey
+    {
+        sf::Keyboard::Key::X,
+        sf::Keyboard::Key::Num1,
+        sf::Keyboard::Key::Num2,
+        sf::Keyboard::Key::Num3,
+        sf::Keyboard::Key::Q,
+        sf::Keyboard::Key::W,
+        sf::Keyboard::Key::E,
+        sf::Keyboard::Key::A,
+        sf::Keyboard::Key::S,
+        sf::Keyboard::Key::D,
+        sf::Keyboard::Key::Z,
+        sf::Keyboard::Key::C,
+        sf::Keyboard::Key::Num4,
+        sf::Keyboard::Key::R,
+        sf::Keyboard::Key::F,
+        sf::Keyboard::Key::V,
+    },
+    m_pressedKeys(0),
+    m_keysPressedSinceFrame(0)
+{
+
+}
+
+bool SfmlKeyboard::HandleEvent(const sf::Event& event)
+{
+    const auto previousKeys = m_pressedKeys.load(std::memory_order_relaxed);
+    auto pressedKeys = previousKeys;
+    if (event.type == sf::Event::KeyPressed or event.type == sf::Event::KeyReleased)
+    {
+        const auto physicalKey = std::ranges::find(m_chip8KeyToPhysicalKey, event.key.code);
+        if (physicalKey == std::end(m_chip8KeyToPhysicalKey))
+        {
+            return false;
+        }
+        const auto keyBit = static_cast<std::uint16_t>(1 << std::distance(std::begin(m_chip8KeyToPhysicalKey), physicalKey));
+        pressedKeys = event.type == sf::Event::KeyPressed ? pressedKeys | keyBit : pressedKeys & ~keyBit;
+        if (event.type == sf::Event::KeyPressed)
+        {
+            m_keysPressedSinceFrame.fetch_or(keyBit, std::memory_order_relaxed);
+        }
+    }
+    //releases are not reported to a window without focus
+    else if (event.type == sf::Event::LostFocus)
+    {
+        pressedKeys = 0;
+    }
+
+    m_pressedKeys.store(pressedKeys, std::memory_order_relaxed);
+    return pressedKeys != previousKeys;
+}
+
+void SfmlKeyboard::BeginFrame()
+{
+    SetPressedKeys(m_pressedKeys.load(std::memory_order_relaxed) | m_keysPressedSinceFrame.exchange(0, std::memory_order_relaxed));
+}
\ No newline at end of file
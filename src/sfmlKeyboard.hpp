@@ -0,0 +1,43 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <SFML/Window/Event.hpp>
+#include <SFML/Window/Keyboard.hpp>
+#include "chip8/keyboard.hpp"
+
+//keys held down in the window, tracked from its events so the VM never queries the system;
+//latched at the start of every frame, so the VM's idle loop and key wait shortcuts can rely on them not changing within it
+class SfmlKeyboard : public CHIP8::LatchedKeyboard
+{
+    std::array<sf::Keyboard::Key, KEYS> m_chip8KeyToPhysicalKey;
+    //written by the thread handling window events, read by the VM thread
+    std::atomic<std::uint16_t> m_pressedKeys;
+    //keys pressed since the last frame began, so the next frame sees a press even if it was released before
+    std::atomic<std::uint16_t> m_keysPressedSinceFrame;
+    
+public:
+    SfmlKeyboard();
+    //returns whether the event changed any of the CHIP-8 keys
+    bool HandleEvent(const sf::Event& event);
+    void BeginFrame() override;
+};
@@ -0,0 +1,75 @@
+/*
+    Copyright 2024 Artyom Makarov
+
+    This file is part of chip8_emu.
+
+    chip8_emu is free software: you can redistribute it and/or modify it under the terms of the 
+    GNU General Public License as published by the Free Software Foundation, 
+    either version 3 of the License, or (at your option) any later version.
+
+    chip8_emu is distributed in the hope that it will be useful, 
+    but WITHOUT ANY WARRANTY; 
+    without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. 
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along with chip8_emu. 
+    If not, see <https://www.gnu.org/licenses/>. 
+*/
+
+//decodes a trace the emulator wrote when a program failed into the disassembly of the instructions
+//leading up to the failure, oldest first
+
+#include <cstdlib>
+#include <print>
+#include <stdexcept>
+#include <string_view>
+#include "chip8/disassembler.hpp"
+#include "chip8/executionTrace.hpp"
+#include "chip8/instruction.hpp"
+
+namespace
+{
+    std::string_view DescribeEvent(CHIP8::TraceEvent event)
+    {
+        switch (event)
+        {
+            case CHIP8::TraceEvent::EnteredBlock: return "  entered compiled block, state before it";
+            case CHIP8::TraceEvent::Failed: return "  failed";
+            default: return "";
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::println("Usage: {} TRACE_FILE", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    CHIP8::TraceLog log;
+    try
+    {
+        log = CHIP8::TraceLog::Load(argv[1]);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::println("{}!", e.what());
+        return EXIT_FAILURE;
+    }
+
+    if (not log.failure.empty())
+    {
+        std::println("Failed with: {}", log.failure);
+    }
+    std::println("Last {} of {} recorded instructions, registers as each instruction left them:", log.entries.size(), log.recordedCount);
+    std::println("PC    opcode  instruction        I     Vx");
+    for (const auto& entry : log.entries)
+    {
+        std::println("{:04X}  {:04X}    {:<18} {:04X}  V{:X}={:02X}{}", 
+            entry.programCounter, entry.opcode, CHIP8::Disassemble(entry.opcode), entry.addressRegister, 
+            CHIP8::DecodedOpcode {entry.opcode}.x, entry.registerValue, DescribeEvent(entry.event));
+    }
+    return EXIT_SUCCESS;
+}
\ No newline at end of file